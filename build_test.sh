@@ -19,8 +19,20 @@ CFLAGS="-save-temps=obj -g -ggdb -Og  -Wall -I/usr/include -I$INCLUDEDIR -D_LINU
 
 # g++ $CFLAGS -DAB_LOGGER_SRC -DAB_LOGGER_TEST include/ab_logger.h -o bin/ab_logger
 g++ $CFLAGS -Iinclude $DIR/test/test_logger.cpp -lczmq  -o bin/test_logger
+g++ $CFLAGS -DLOG_DEFERRED=1 -Iinclude $DIR/src_tests/test_logger.cpp -lczmq  -o bin/test_logger_deferred
+g++ $CFLAGS -DLOG_DEFERRED=1 -Iinclude $DIR/src_tests/test_logger_format.cpp -lczmq  -o bin/test_logger_format
 g++ $CFLAGS -Iinclude $DIR/test/test_loggerclient.cpp -lczmq  -o bin/test_loggerclient
 g++ $CFLAGS -Iinclude $DIR/test/test_loggerclient.cpp -lczmq  -o bin/test_loggerclient
+g++ $CFLAGS -Iinclude $DIR/src_tests/test_memory.cpp -o bin/test_memory
+g++ $CFLAGS -DMEM_INSTRUMENT=1 -Iinclude $DIR/src_tests/test_memory.cpp -o bin/test_memory_instrument
+g++ $CFLAGS -Iinclude $DIR/src_tests/test_heap.cpp -o bin/test_heap
+g++ $CFLAGS -Iinclude $DIR/src_tests/test_slab.cpp -o bin/test_slab
+g++ $CFLAGS -Iinclude $DIR/src_tests/test_memory_pmr.cpp -o bin/test_memory_pmr
+g++ $CFLAGS -DTEST_SEPARATE_MEMORY_SRC -Iinclude $DIR/src_tests/test_memory_pmr.cpp $DIR/src_tests/test_memory_src.cpp -o bin/test_memory_pmr_separate
+g++ $CFLAGS -Iinclude $DIR/src_tests/test_hashmap.cpp -o bin/test_hashmap
+g++ $CFLAGS -Iinclude $DIR/src_tests/test_relptr.cpp -o bin/test_relptr
+g++ $CFLAGS -Iinclude $DIR/src_tests/test_allocaudit.cpp -o bin/test_allocaudit
+g++ $CFLAGS -O2 -Iinclude $DIR/src_tests/bench_memory.cpp -o bin/bench_memory
 
 
 popd
\ No newline at end of file
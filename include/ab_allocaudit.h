@@ -0,0 +1,411 @@
+/** @file
+@brief Counts heap allocations, so tests can check that hot paths don't touch the heap.
+@author Amos Buchanan
+@version 1.0
+@date October 2026
+
+Replaces `malloc`, `free` and friends with versions that count calls on the current thread while an audit is running, then pass the call on to the C library. `operator new` and `operator delete` are replaced too, and go through `malloc` and `free`. Calls made by shared libraries, such as czmq inside @ref ab_logger.h, are counted as well, since the program's `malloc` takes the place of the C library's for the whole process.
+
+Audits work like `temporary_memory`: begin one, run the code, then end it to get what was allocated in between. Audits can be nested, and only count the thread that began them. With `isTrapping` set, the first allocation in the audit traps, so a debugger stops right on the code that allocated.
+
+Every call to `malloc`, `calloc`, `realloc` or an aligned allocator counts as an allocation; every `free` of a non-null pointer counts as a free.
+
+This needs glibc, since it calls `__libc_malloc` and friends for the real work. Elsewhere nothing is counted, and @ref au_IsAuditWorking() returns false. It can't be used with AddressSanitizer, which replaces `malloc` itself.
+
+This is a single-file library. Add the following define to include the source *once*, in a test program rather than a shipping one:
+
+~~~c
+#define AB_ALLOCAUDIT_SRC
+#include "ab_allocaudit.h"
+~~~
+
+To audit a program that can't be rebuilt with the source, build it as a shared library instead, and load it with `LD_PRELOAD`. Such a program never begins an audit, so set `AB_ALLOCAUDIT=1` as well: that counts every thread for the whole run, and prints the totals to `stderr` at exit.
+
+~~~
+g++ -shared -fPIC -O2 -DAB_ALLOCAUDIT_SRC -x c++ include/ab_allocaudit.h -o libab_allocaudit.so
+AB_ALLOCAUDIT=1 LD_PRELOAD=./libab_allocaudit.so ./program
+~~~
+
+Example Usage:
+~~~c
+// Logging a message shouldn't allocate once the logger is warmed up.
+lg_Log(Logger, LOG_INFO, "Warm up");
+
+alloc_audit Audit = au_BeginAudit();
+for(u32 Index = 0; Index < 1000; ++Index)
+{
+    lg_Log(Logger, LOG_INFO, "Message %u", Index);
+}
+Audit = au_EndAudit(Audit);
+TestCheck(Audit.AllocCount == 0);
+~~~
+
+See also:
+- @ref ab_memory.h
+
+**/
+
+#ifndef AB_ALLOCAUDIT_H
+#define AB_ALLOCAUDIT_H
+
+#include "ab_common.h"
+
+/** @brief Heap use on one thread between @ref au_BeginAudit() and @ref au_EndAudit(). **/
+struct alloc_audit
+{
+    /** @brief Number of allocations. **/
+    u64 AllocCount;
+    /** @brief Number of frees. **/
+    u64 FreeCount;
+    /** @brief Total bytes asked for. **/
+    u64 AllocSize;
+    
+    /** @private **/
+    b8 wasTrapping;
+};
+
+/** @brief Start counting heap allocations on this thread.
+
+@param isTrapping True to trap on any allocation until the audit ends, to find what's allocating in a debugger.
+@return The audit to pass to @ref au_EndAudit().
+**/
+alloc_audit au_BeginAudit(b8 isTrapping = false);
+
+/** @brief Stop counting, and get what was allocated since @ref au_BeginAudit().
+
+Audits must be ended in the opposite order they were begun, on the same thread.
+
+@param Audit The audit returned from @ref au_BeginAudit().
+@return The allocations and frees made on this thread during the audit, including any nested audits.
+**/
+alloc_audit au_EndAudit(alloc_audit Audit);
+
+/** @brief Check that allocations are being counted.
+
+Useful at the start of a test, so a test expecting no allocations can't pass just because nothing is counted.
+**/
+b8 au_IsAuditWorking();
+
+/** @brief Start counting heap allocations on every thread, until the program exits.
+
+This is what `AB_ALLOCAUDIT=1` turns on before `main()`, though only the environment variable prints the totals at exit. It doesn't trap, and doesn't change what audits on a thread count.
+**/
+void au_BeginProcessAudit();
+
+/** @brief Get what every thread has allocated since @ref au_BeginProcessAudit(). **/
+alloc_audit au_GetProcessAudit();
+
+#endif // AB_ALLOCAUDIT_H
+
+#ifdef AB_ALLOCAUDIT_SRC
+
+#include <stdlib.h>
+#include <new>
+
+// NOTE(amos): Everything below uses glibc and GCC extensions. Elsewhere the API is left as stubs that count nothing.
+#if defined(__GLIBC__)
+#include <stdio.h>
+#include <unistd.h>
+
+// NOTE(amos): Initial exec, so the hooks don't call into the loader (which can allocate) the first time a thread
+// touches these.
+static __thread u32 au_Depth_ __attribute__((tls_model("initial-exec")));
+static __thread b8 au_isTrapping_ __attribute__((tls_model("initial-exec")));
+static __thread u64 au_AllocCount_ __attribute__((tls_model("initial-exec")));
+static __thread u64 au_FreeCount_ __attribute__((tls_model("initial-exec")));
+static __thread u64 au_AllocSize_ __attribute__((tls_model("initial-exec")));
+
+// NOTE(amos): Shared by every thread, so only touched when the whole process is being audited.
+static b8 au_isProcessAudit_;
+static u64 au_ProcessAllocCount_;
+static u64 au_ProcessFreeCount_;
+static u64 au_ProcessAllocSize_;
+
+static inline void
+au_RecordAlloc_(size_t Size)
+{
+    if(au_isProcessAudit_)
+    {
+        __atomic_fetch_add(&au_ProcessAllocCount_, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&au_ProcessAllocSize_, Size, __ATOMIC_RELAXED);
+    }
+    
+    if(au_Depth_)
+    {
+        if(au_isTrapping_)
+        {
+            __builtin_trap();
+        }
+        ++au_AllocCount_;
+        au_AllocSize_ += Size;
+    }
+}
+
+static inline void
+au_RecordFree_(void *Ptr)
+{
+    if(au_isProcessAudit_ && Ptr)
+    {
+        __atomic_fetch_add(&au_ProcessFreeCount_, 1, __ATOMIC_RELAXED);
+    }
+    
+    if(au_Depth_ && Ptr)
+    {
+        ++au_FreeCount_;
+    }
+}
+
+alloc_audit
+au_BeginAudit(b8 isTrapping)
+{
+    alloc_audit Result = {};
+    Result.AllocCount = au_AllocCount_;
+    Result.FreeCount = au_FreeCount_;
+    Result.AllocSize = au_AllocSize_;
+    Result.wasTrapping = au_isTrapping_;
+    
+    au_isTrapping_ = au_isTrapping_ || isTrapping;
+    ++au_Depth_;
+    
+    return Result;
+}
+
+alloc_audit
+au_EndAudit(alloc_audit Audit)
+{
+    Assert(au_Depth_ > 0);
+    --au_Depth_;
+    au_isTrapping_ = Audit.wasTrapping;
+    
+    alloc_audit Result = {};
+    Result.AllocCount = au_AllocCount_ - Audit.AllocCount;
+    Result.FreeCount = au_FreeCount_ - Audit.FreeCount;
+    Result.AllocSize = au_AllocSize_ - Audit.AllocSize;
+    
+    return Result;
+}
+
+b8
+au_IsAuditWorking()
+{
+    // NOTE(amos): Called through a volatile pointer, so the compiler can't remove the malloc/free pair.
+    void *(*volatile Malloc)(size_t) = malloc;
+    
+    alloc_audit Audit = au_BeginAudit();
+    free(Malloc(1));
+    Audit = au_EndAudit(Audit);
+    
+    return Audit.AllocCount == 1 && Audit.FreeCount == 1;
+}
+
+void
+au_BeginProcessAudit()
+{
+    au_isProcessAudit_ = true;
+}
+
+alloc_audit
+au_GetProcessAudit()
+{
+    alloc_audit Result = {};
+    Result.AllocCount = __atomic_load_n(&au_ProcessAllocCount_, __ATOMIC_RELAXED);
+    Result.FreeCount = __atomic_load_n(&au_ProcessFreeCount_, __ATOMIC_RELAXED);
+    Result.AllocSize = __atomic_load_n(&au_ProcessAllocSize_, __ATOMIC_RELAXED);
+    
+    return Result;
+}
+
+static b8 au_isPrintingAtExit_;
+
+__attribute__((constructor)) static void
+au_StartFromEnvironment_()
+{
+    char const *Value = getenv("AB_ALLOCAUDIT");
+    if(Value && Value[0] && !(Value[0] == '0' && !Value[1]))
+    {
+        au_BeginProcessAudit();
+        au_isPrintingAtExit_ = true;
+    }
+}
+
+// NOTE(amos): Formatted on the stack and written straight to the file descriptor, since stdio may allocate or
+// already be closed this late.
+__attribute__((destructor)) static void
+au_PrintProcessAudit_()
+{
+    if(au_isPrintingAtExit_)
+    {
+        alloc_audit Audit = au_GetProcessAudit();
+        char Buffer[160];
+        int Length = snprintf(Buffer, sizeof(Buffer), "ab_allocaudit: %llu allocations, %llu bytes, %llu frees\n",
+                              (unsigned long long)Audit.AllocCount, (unsigned long long)Audit.AllocSize,
+                              (unsigned long long)Audit.FreeCount);
+        if(Length > 0)
+        {
+            write(2, Buffer, MINIMUM((size_t)Length, sizeof(Buffer) - 1));
+        }
+    }
+}
+
+extern "C"
+{
+    void *__libc_malloc(size_t Size);
+    void *__libc_calloc(size_t Count, size_t Size);
+    void *__libc_realloc(void *Ptr, size_t Size);
+    void *__libc_memalign(size_t Alignment, size_t Size);
+    void __libc_free(void *Ptr);
+    
+    void *
+    malloc(size_t Size) noexcept
+    {
+        au_RecordAlloc_(Size);
+        return __libc_malloc(Size);
+    }
+    
+    void *
+    calloc(size_t Count, size_t Size) noexcept
+    {
+        // NOTE(amos): An overflowing size fails in the C library, so it's counted as a call with no bytes.
+        au_RecordAlloc_((Size && Count > SIZE_MAX/Size) ? 0 : Count*Size);
+        return __libc_calloc(Count, Size);
+    }
+    
+    void *
+    realloc(void *Ptr, size_t Size) noexcept
+    {
+        au_RecordAlloc_(Size);
+        return __libc_realloc(Ptr, Size);
+    }
+    
+    void *
+    memalign(size_t Alignment, size_t Size) noexcept
+    {
+        au_RecordAlloc_(Size);
+        return __libc_memalign(Alignment, Size);
+    }
+    
+    void *
+    aligned_alloc(size_t Alignment, size_t Size) noexcept
+    {
+        au_RecordAlloc_(Size);
+        return __libc_memalign(Alignment, Size);
+    }
+    
+    int
+    posix_memalign(void **PtrOut, size_t Alignment, size_t Size) noexcept
+    {
+        au_RecordAlloc_(Size);
+        if(Alignment < sizeof(void*) || (Alignment & (Alignment - 1)))
+        {
+            return 22; // EINVAL
+        }
+        
+        void *Result = __libc_memalign(Alignment, Size);
+        if(!Result)
+        {
+            return 12; // ENOMEM
+        }
+        
+        *PtrOut = Result;
+        return 0;
+    }
+    
+    void
+    free(void *Ptr) noexcept
+    {
+        au_RecordFree_(Ptr);
+        __libc_free(Ptr);
+    }
+}
+
+// NOTE(amos): The standard library's operator new already calls malloc, but replacing it here means it's counted
+// even with a C++ runtime that doesn't. Sized and aligned versions fall back to these, or to aligned_alloc.
+void *
+operator new(size_t Size)
+{
+    void *Result = malloc(Size ? Size : 1);
+    if(!Result)
+    {
+        throw std::bad_alloc();
+    }
+    
+    return Result;
+}
+
+void *
+operator new[](size_t Size)
+{
+    return operator new(Size);
+}
+
+void *
+operator new(size_t Size, std::nothrow_t const &) noexcept
+{
+    return malloc(Size ? Size : 1);
+}
+
+void *
+operator new[](size_t Size, std::nothrow_t const &) noexcept
+{
+    return malloc(Size ? Size : 1);
+}
+
+void
+operator delete(void *Ptr) noexcept
+{
+    free(Ptr);
+}
+
+void
+operator delete[](void *Ptr) noexcept
+{
+    free(Ptr);
+}
+
+void
+operator delete(void *Ptr, size_t Size) noexcept
+{
+    free(Ptr);
+}
+
+void
+operator delete[](void *Ptr, size_t Size) noexcept
+{
+    free(Ptr);
+}
+#else
+alloc_audit
+au_BeginAudit(b8 isTrapping)
+{
+    alloc_audit Result = {};
+    return Result;
+}
+
+alloc_audit
+au_EndAudit(alloc_audit Audit)
+{
+    alloc_audit Result = {};
+    return Result;
+}
+
+b8
+au_IsAuditWorking()
+{
+    return false;
+}
+
+void
+au_BeginProcessAudit()
+{
+}
+
+alloc_audit
+au_GetProcessAudit()
+{
+    alloc_audit Result = {};
+    return Result;
+}
+#endif
+
+#undef AB_ALLOCAUDIT_SRC
+#endif // AB_ALLOCAUDIT_SRC
@@ -0,0 +1,478 @@
+/** @file
+@brief Hash map in a memory arena.
+@author Amos Buchanan
+@version 1.0
+@date October 2026
+
+An open-addressing hash map that keeps its keys, values and control bytes in a `memory_arena`, so it never touches the heap.
+
+The layout follows the "Swiss table" design. Each slot has one control byte: empty, deleted, or the low 7 bits of the hash of the key in it. A lookup loads 16 control bytes at a time and compares them all against the hash with a couple of SSE2 instructions. Only slots whose 7 bits match need their keys compared, so most lookups touch a single cache line of control bytes and a single key.
+
+The map grows by rehashing into a new region of the arena, twice the size, once it is 7/8 full. The old region is left behind in the arena, so size the map up front with `InitialCapacity` where possible, or put it in an arena that is reset along with it. Pointers to values are only valid until the next insert.
+
+Keys and values are copied around with the map, so they must be trivially copyable. Integer, pointer and `st_ptr` keys are supported out of the box. `st_ptr` keys are stored as-is, so the strings they point to must live as long as the map. Other key types need an `hm_Hash()` and an `hm_AreKeysEqual()` overload.
+
+This is a single-file library. You may include it as a header just as any other. Add the following define to include the source *once* per project:
+
+~~~c
+#define AB_HASHMAP_SRC
+#include "ab_hashmap.h"
+~~~
+
+Example Usage:
+~~~c
+hash_map<st_ptr, u32> WordCounts;
+hm_InitHashMap(&WordCounts, &VolatileMemory, 1024);
+
+for(st_ptr Word : Words)
+{
+    *hm_Insert(&WordCounts, Word) += 1;
+}
+
+u32 *Count = hm_Find(&WordCounts, st_ptr("arena"));
+if(Count)
+{
+    printf("arena: %u\n", *Count);
+}
+
+for(u32 Slot = 0; Slot < WordCounts.Capacity; ++Slot)
+{
+    if(hm_IsSlotUsed(&WordCounts, Slot))
+    {
+        printf("%.*s: %u\n", PSTRING(WordCounts.Keys[Slot]), WordCounts.Values[Slot]);
+    }
+}
+~~~
+
+See also:
+- @ref ab_memory.h
+- @ref ab_string.h
+
+**/
+
+#ifndef AB_HASHMAP_H
+#define AB_HASHMAP_H
+
+#include <string.h>
+#include <type_traits>
+
+#include "ab_common.h"
+#include "ab_memory.h"
+#include "ab_string.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/** @brief Number of control bytes checked at a time. **/
+#define HM_GROUP_SIZE 16
+
+/** @brief The most slots a map can have, so slot numbers and capacity math stay within 32 bits. **/
+#define HM_MAX_CAPACITY 0x40000000u
+
+/** @private **/
+#define HM_EMPTY 0x80
+/** @private **/
+#define HM_DELETED 0xFE
+
+/** @brief An open-addressing hash map in a memory arena. See @ref hm_InitHashMap(). **/
+template<typename K, typename V>
+struct hash_map
+{
+    static_assert(std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value,
+                  "hash_map keys and values must be trivially copyable.");
+    
+    /** @brief The arena the map grows into. **/
+    memory_arena *Arena;
+    /** @private
+    
+    One byte per slot, followed by a copy of the first `HM_GROUP_SIZE`, so a group can be loaded from any slot.
+    **/
+    u8 *Control;
+    /** @brief Keys, indexed by slot. Only valid where `hm_IsSlotUsed()`. **/
+    K *Keys;
+    /** @brief Values, indexed by slot. Only valid where `hm_IsSlotUsed()`. **/
+    V *Values;
+    /** @brief Number of slots. Always a power of 2. **/
+    u32 Capacity;
+    /** @brief Number of keys in the map. **/
+    u32 Count;
+    /** @private Empty slots that can still be filled before the map has to grow. **/
+    u32 GrowthLeft;
+};
+
+/** @brief Hash a block of memory. **/
+u64 hm_HashBytes(void const *Data, size_t Size);
+
+/** @brief Mix the bits of an integer into a hash. **/
+inline u64
+hm_HashInteger(u64 Value)
+{
+    Value ^= Value >> 33;
+    Value *= 0xFF51AFD7ED558CCDULL;
+    Value ^= Value >> 33;
+    Value *= 0xC4CEB9FE1A85EC53ULL;
+    Value ^= Value >> 33;
+    
+    return Value;
+}
+
+///@{
+/** @brief Hash a key. Overload this for other key types. **/
+inline u64 hm_Hash(u64 Key) { return hm_HashInteger(Key); }
+inline u64 hm_Hash(s64 Key) { return hm_HashInteger((u64)Key); }
+inline u64 hm_Hash(u32 Key) { return hm_HashInteger(Key); }
+inline u64 hm_Hash(s32 Key) { return hm_HashInteger((u64)(u32)Key); }
+inline u64 hm_Hash(void const *Key) { return hm_HashInteger((u64)(size_t)Key); }
+inline u64 hm_Hash(st_ptr Key) { return hm_HashBytes(Key.String, Key.Length); }
+///@}
+
+///@{
+/** @brief Compare two keys. Overload this for other key types. **/
+template<typename K>
+inline b8 hm_AreKeysEqual(K const &Key1, K const &Key2) { return Key1 == Key2; }
+inline b8 hm_AreKeysEqual(st_ptr const &Key1, st_ptr const &Key2) { return st_AreStringsEqual(Key1, Key2); }
+///@}
+
+/** @private **/
+inline u32
+hm_FindFirstSet_(u32 Value)
+{
+#if defined(_MSC_VER)
+    unsigned long Result;
+    _BitScanForward(&Result, Value);
+    return (u32)Result;
+#else
+    return (u32)__builtin_ctz(Value);
+#endif
+}
+
+/** @private **/
+inline u32
+hm_FindLastSet_(u32 Value)
+{
+#if defined(_MSC_VER)
+    unsigned long Result;
+    _BitScanReverse(&Result, Value);
+    return (u32)Result;
+#else
+    return 31 - (u32)__builtin_clz(Value);
+#endif
+}
+
+/** @private Bitmask of the control bytes in the group at `Control` that equal `Byte`. **/
+inline u32
+hm_MatchGroup_(u8 const *Control, u8 Byte)
+{
+#if MEM_SSE2
+    __m128i Group = _mm_loadu_si128((__m128i const *)Control);
+    return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(Group, _mm_set1_epi8((char)Byte)));
+#else
+    u32 Result = 0;
+    for(u32 Index = 0; Index < HM_GROUP_SIZE; ++Index)
+    {
+        Result |= (u32)(Control[Index] == Byte) << Index;
+    }
+    return Result;
+#endif
+}
+
+/** @private Bitmask of the empty or deleted control bytes in the group at `Control`. **/
+inline u32
+hm_MatchFree_(u8 const *Control)
+{
+#if MEM_SSE2
+    // NOTE(amos): Empty and deleted are the only control bytes with the top bit set.
+    return (u32)_mm_movemask_epi8(_mm_loadu_si128((__m128i const *)Control));
+#else
+    u32 Result = 0;
+    for(u32 Index = 0; Index < HM_GROUP_SIZE; ++Index)
+    {
+        Result |= (u32)(Control[Index] >> 7) << Index;
+    }
+    return Result;
+#endif
+}
+
+/** @private **/
+template<typename K, typename V>
+inline void
+hm_SetControl_(hash_map<K, V> *Map, u32 Slot, u8 Byte)
+{
+    Map->Control[Slot] = Byte;
+    if(Slot < HM_GROUP_SIZE)
+    {
+        Map->Control[Map->Capacity + Slot] = Byte;
+    }
+}
+
+/** @private Find the first free slot along the probe sequence for a hash. **/
+template<typename K, typename V>
+u32
+hm_FindFreeSlot_(hash_map<K, V> *Map, u64 Hash)
+{
+    u32 Mask = Map->Capacity - 1;
+    u32 Position = (u32)(Hash >> 7) & Mask;
+    u32 Step = 0;
+    
+    u32 Free;
+    while(!(Free = hm_MatchFree_(Map->Control + Position)))
+    {
+        // NOTE(amos): Triangular steps of whole groups visit every group when the capacity is a power of 2.
+        Step += HM_GROUP_SIZE;
+        Position = (Position + Step) & Mask;
+    }
+    
+    return (Position + hm_FindFirstSet_(Free)) & Mask;
+}
+
+/** @private Allocate the arrays for a capacity, and add the keys from the old arrays. **/
+template<typename K, typename V>
+b8
+hm_Rehash_(hash_map<K, V> *Map, u32 NewCapacity)
+{
+    u8 *OldControl = Map->Control;
+    K *OldKeys = Map->Keys;
+    V *OldValues = Map->Values;
+    u32 OldCapacity = Map->Capacity;
+    
+    u8 *Control = (u8*)mem_PushSize_(Map->Arena, NewCapacity + HM_GROUP_SIZE, false, HM_GROUP_SIZE);
+    K *Keys = (K*)mem_PushSize_(Map->Arena, NewCapacity*sizeof(K), false, alignof(K));
+    V *Values = (V*)mem_PushSize_(Map->Arena, NewCapacity*sizeof(V), false, alignof(V));
+    if(!Control || !Keys || !Values)
+    {
+        return false;
+    }
+    
+    memset(Control, HM_EMPTY, NewCapacity + HM_GROUP_SIZE);
+    Map->Control = Control;
+    Map->Keys = Keys;
+    Map->Values = Values;
+    Map->Capacity = NewCapacity;
+    Map->GrowthLeft = NewCapacity - NewCapacity/8 - Map->Count;
+    
+    for(u32 OldSlot = 0; OldSlot < OldCapacity; ++OldSlot)
+    {
+        if(!(OldControl[OldSlot] & 0x80))
+        {
+            u64 Hash = hm_Hash(OldKeys[OldSlot]);
+            u32 Slot = hm_FindFreeSlot_(Map, Hash);
+            hm_SetControl_(Map, Slot, (u8)(Hash & 0x7F));
+            Keys[Slot] = OldKeys[OldSlot];
+            Values[Slot] = OldValues[OldSlot];
+        }
+    }
+    
+    return true;
+}
+
+/** @brief Set up an empty hash map.
+
+@param Map The map.
+@param Arena The arena for the map's arrays, now and as it grows.
+@param InitialCapacity Number of keys to make room for up front. The map grows past this as needed.
+@return False if the arena doesn't have room, or `InitialCapacity` is more than `HM_MAX_CAPACITY` can hold.
+**/
+template<typename K, typename V>
+b8
+hm_InitHashMap(hash_map<K, V> *Map, memory_arena *Arena, u32 InitialCapacity = 0)
+{
+    *Map = {};
+    if(InitialCapacity > (HM_MAX_CAPACITY - HM_MAX_CAPACITY/8))
+    {
+        return false;
+    }
+    
+    u32 Capacity = HM_GROUP_SIZE;
+    while((Capacity - Capacity/8) < InitialCapacity)
+    {
+        Capacity *= 2;
+    }
+    
+    Map->Arena = Arena;
+    
+    return hm_Rehash_(Map, Capacity);
+}
+
+/** @private Find the slot holding a key, or -1. **/
+template<typename K, typename V>
+s32
+hm_FindSlot_(hash_map<K, V> *Map, K const &Key, u64 Hash)
+{
+    u32 Mask = Map->Capacity - 1;
+    u32 Position = (u32)(Hash >> 7) & Mask;
+    u8 Tag = (u8)(Hash & 0x7F);
+    u32 Step = 0;
+    
+    for(;;)
+    {
+        u8 const *Group = Map->Control + Position;
+        u32 Matches = hm_MatchGroup_(Group, Tag);
+        while(Matches)
+        {
+            u32 Slot = (Position + hm_FindFirstSet_(Matches)) & Mask;
+            if(hm_AreKeysEqual(Map->Keys[Slot], Key))
+            {
+                return (s32)Slot;
+            }
+            Matches &= Matches - 1;
+        }
+        
+        // NOTE(amos): The key would have been put in the first empty slot along the way.
+        if(hm_MatchGroup_(Group, HM_EMPTY) || Step >= Map->Capacity)
+        {
+            return -1;
+        }
+        
+        Step += HM_GROUP_SIZE;
+        Position = (Position + Step) & Mask;
+    }
+}
+
+/** @brief Find the value for a key.
+
+@return Pointer to the value, or 0 if the key isn't in the map. Valid until the next insert.
+**/
+template<typename K, typename V>
+V *
+hm_Find(hash_map<K, V> *Map, K const &Key)
+{
+    s32 Slot = hm_FindSlot_(Map, Key, hm_Hash(Key));
+    
+    return (Slot < 0) ? 0 : &Map->Values[Slot];
+}
+
+/** @brief Find the value for a key, adding the key if it isn't there yet.
+
+@param Map The map.
+@param Key The key.
+@param isNewOut Optional, set to true if the key was added.
+@return Pointer to the value, cleared to 0 if the key was added. Valid until the next insert. 0 if the map needed to grow and the arena is full, or the map is already at `HM_MAX_CAPACITY`.
+**/
+template<typename K, typename V>
+V *
+hm_Insert(hash_map<K, V> *Map, K const &Key, b8 *isNewOut = 0)
+{
+    u64 Hash = hm_Hash(Key);
+    s32 Found = hm_FindSlot_(Map, Key, Hash);
+    if(isNewOut)
+    {
+        *isNewOut = (Found < 0);
+    }
+    
+    if(Found >= 0)
+    {
+        return &Map->Values[Found];
+    }
+    
+    u32 Slot = hm_FindFreeSlot_(Map, Hash);
+    if(!Map->GrowthLeft && Map->Control[Slot] == HM_EMPTY)
+    {
+        // NOTE(amos): Only grow if most of the used slots hold keys; otherwise rehashing at the same size clears out deleted slots.
+        u32 NewCapacity = ((Map->Count + 1) > (Map->Capacity/16*7)) ? Map->Capacity*2 : Map->Capacity;
+        if(NewCapacity > HM_MAX_CAPACITY || !hm_Rehash_(Map, NewCapacity))
+        {
+            return 0;
+        }
+        Slot = hm_FindFreeSlot_(Map, Hash);
+    }
+    
+    if(Map->Control[Slot] == HM_EMPTY)
+    {
+        --Map->GrowthLeft;
+    }
+    hm_SetControl_(Map, Slot, (u8)(Hash & 0x7F));
+    Map->Keys[Slot] = Key;
+    memset((void*)&Map->Values[Slot], 0, sizeof(V));
+    ++Map->Count;
+    
+    return &Map->Values[Slot];
+}
+
+/** @brief Remove a key from the map.
+
+@return True if the key was in the map.
+**/
+template<typename K, typename V>
+b8
+hm_Remove(hash_map<K, V> *Map, K const &Key)
+{
+    s32 Slot = hm_FindSlot_(Map, Key, hm_Hash(Key));
+    if(Slot < 0)
+    {
+        return false;
+    }
+    
+    // NOTE(amos): If the group around this slot has an empty slot, no probe ever passed through this one while it was
+    // full, so it can go straight back to empty. Otherwise lookups still need to probe past it.
+    u32 Mask = Map->Capacity - 1;
+    u32 Before = (u32)(Slot - HM_GROUP_SIZE) & Mask;
+    u32 EmptyAfter = hm_MatchGroup_(Map->Control + Slot, HM_EMPTY);
+    u32 EmptyBefore = hm_MatchGroup_(Map->Control + Before, HM_EMPTY);
+    b8 isNeverFull = EmptyBefore && EmptyAfter &&
+        ((HM_GROUP_SIZE - 1 - hm_FindLastSet_(EmptyBefore)) + hm_FindFirstSet_(EmptyAfter)) < HM_GROUP_SIZE;
+    
+    if(isNeverFull)
+    {
+        hm_SetControl_(Map, (u32)Slot, HM_EMPTY);
+        ++Map->GrowthLeft;
+    }
+    else
+    {
+        hm_SetControl_(Map, (u32)Slot, HM_DELETED);
+    }
+    --Map->Count;
+    
+    return true;
+}
+
+/** @brief Remove every key from the map, keeping its capacity. **/
+template<typename K, typename V>
+void
+hm_Clear(hash_map<K, V> *Map)
+{
+    memset(Map->Control, HM_EMPTY, Map->Capacity + HM_GROUP_SIZE);
+    Map->Count = 0;
+    Map->GrowthLeft = Map->Capacity - Map->Capacity/8;
+}
+
+/** @brief Check whether a slot holds a key, for iterating over `Keys` and `Values`. **/
+template<typename K, typename V>
+inline b8
+hm_IsSlotUsed(hash_map<K, V> *Map, u32 Slot)
+{
+    return !(Map->Control[Slot] & 0x80);
+}
+
+#endif // AB_HASHMAP_H
+
+/*************************************************/
+#ifdef AB_HASHMAP_SRC
+
+u64
+hm_HashBytes(void const *Data, size_t Size)
+{
+    u8 const *At = (u8 const *)Data;
+    u64 Hash = 0x9E3779B97F4A7C15ULL ^ (Size * 0xFF51AFD7ED558CCDULL);
+    
+    while(Size >= 8)
+    {
+        u64 Word;
+        memcpy(&Word, At, 8);
+        Hash = (Hash ^ hm_HashInteger(Word)) * 0x9E3779B97F4A7C15ULL;
+        At += 8;
+        Size -= 8;
+    }
+    
+    if(Size)
+    {
+        u64 Word = 0;
+        memcpy(&Word, At, Size);
+        Hash = (Hash ^ hm_HashInteger(Word)) * 0x9E3779B97F4A7C15ULL;
+    }
+    
+    return hm_HashInteger(Hash);
+}
+
+#undef AB_HASHMAP_SRC
+#endif // AB_HASHMAP_SRC
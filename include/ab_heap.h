@@ -0,0 +1,547 @@
+/** @file
+@brief General purpose allocator inside a memory arena.
+@author Amos Buchanan
+@version 1.0
+@date October 2026
+
+A variable-size allocator with free and realloc, for the parts of a project that really need them. The heap lives in a region taken from a `memory_arena`, so it stays within the pre-allocated block model of @ref ab_memory.h and never calls into malloc.
+
+The heap is a Two-Level Segregated Fit (TLSF) allocator. Free blocks are kept in lists by size class, with a first level of power-of-two sizes and a second level splitting each of those into `HP_SL_INDEX_COUNT` steps. Two levels of bitmaps find a free list that fits in constant time, so `hp_Alloc()`, `hp_Free()` and `hp_Realloc()` have a bounded worst case no matter how fragmented the heap gets. Neighbouring free blocks are merged as soon as they're freed.
+
+All memory returned is aligned to `HP_ALIGN`. The heap is not thread safe; use one heap per thread, or lock around it.
+
+This is a single-file library. You may include it as a header just as any other. Add the following define to include the source *once* per project:
+
+~~~c
+#define AB_HEAP_SRC
+#include "ab_heap.h"
+~~~
+
+Example Usage:
+~~~c
+memory_arena MainMemory = mem_InitMemory(OsMemory, MemorySize, true);
+heap *Heap = hp_CreateHeap(&MainMemory, Megabytes(16));
+
+message *Message = (message*)hp_Alloc(Heap, sizeof(message) + PayloadSize);
+Message = (message*)hp_Realloc(Heap, Message, sizeof(message) + 2*PayloadSize);
+hp_Free(Heap, Message);
+
+heap_stats Stats = hp_GetStats(Heap);
+printf("Heap %zu/%zu used, fragmentation %.2f\n", Stats.UsedSize, Stats.TotalSize, Stats.Fragmentation);
+~~~
+
+See also:
+- @ref ab_memory.h
+- [TLSF: a New Dynamic Memory Allocator for Real-Time Systems](http://www.gii.upv.es/tlsf/files/ecrts04_tlsf.pdf)
+
+**/
+
+#ifndef AB_HEAP_H
+#define AB_HEAP_H
+
+#include "ab_common.h"
+#include "ab_memory.h"
+
+/** @brief Alignment of all memory returned by the heap. **/
+#define HP_ALIGN_LOG2 4
+#define HP_ALIGN (1 << HP_ALIGN_LOG2)
+
+/** @brief Number of second-level size classes for each power of two. **/
+#define HP_SL_INDEX_COUNT_LOG2 5
+#define HP_SL_INDEX_COUNT (1 << HP_SL_INDEX_COUNT_LOG2)
+
+/** @private Blocks smaller than HP_SMALL_BLOCK_SIZE all share the first first-level list. **/
+#define HP_FL_INDEX_SHIFT (HP_SL_INDEX_COUNT_LOG2 + HP_ALIGN_LOG2)
+#define HP_SMALL_BLOCK_SIZE (1 << HP_FL_INDEX_SHIFT)
+
+/** @brief Blocks must be smaller than 2^HP_FL_INDEX_MAX bytes. **/
+#if defined(__LP64__) || defined(_WIN64)
+#define HP_FL_INDEX_MAX 38
+#else
+#define HP_FL_INDEX_MAX 30
+#endif
+#define HP_FL_INDEX_COUNT (HP_FL_INDEX_MAX - HP_FL_INDEX_SHIFT + 1)
+#define HP_MAX_BLOCK_SIZE (((size_t)1 << HP_FL_INDEX_MAX) - HP_SMALL_BLOCK_SIZE)
+
+/** @private
+
+`PrevPhysical` and `Size` are the header of every block. `NextFree` and `PrevFree` overlap the start of the memory handed out, and are only used while the block is free.
+**/
+struct hp_block
+{
+    hp_block *PrevPhysical;
+    // NOTE(amos): Size of the memory after the header. The low bits hold flags, since sizes are a multiple of HP_ALIGN.
+    size_t Size;
+    
+    hp_block *NextFree;
+    hp_block *PrevFree;
+};
+
+/** @private **/
+struct heap
+{
+    hp_block *FirstBlock;
+    size_t TotalSize;
+    
+    u32 FlBitmap;
+    u32 SlBitmap[HP_FL_INDEX_COUNT];
+    hp_block *FreeBlocks[HP_FL_INDEX_COUNT][HP_SL_INDEX_COUNT];
+};
+
+/** @brief Heap usage, from @ref hp_GetStats(). **/
+struct heap_stats
+{
+    /** @brief Memory available to the heap, including block headers. **/
+    size_t TotalSize;
+    /** @brief Memory in blocks currently allocated. **/
+    size_t UsedSize;
+    /** @brief Memory in free blocks. **/
+    size_t FreeSize;
+    /** @brief Size of the largest free block. Allocations close to this size may still fail, since they are rounded up to a size class. **/
+    size_t LargestFreeBlock;
+    u32 UsedBlockCount;
+    u32 FreeBlockCount;
+    /** @brief 0 when all free memory is in one block, approaching 1 as it's split up into many small blocks. **/
+    r32 Fragmentation;
+};
+
+/** @brief Create a heap in a region of a `memory_arena`.
+
+@param Arena The arena to take the heap's memory from.
+@param Size The amount of memory for the heap, including its bookkeeping.
+@return The new heap, or 0 if there isn't enough memory.
+**/
+heap *hp_CreateHeap(memory_arena *Arena, size_t Size);
+
+/** @brief Get memory from the heap.
+
+@param Heap The heap.
+@param Size Amount of memory to get.
+@param ClearMemory True to clear the memory to 0.
+@return Pointer to the memory, aligned to `HP_ALIGN`; 0 if there is no free block large enough, or `Size` is 0.
+**/
+void *hp_Alloc(heap *Heap, size_t Size, b8 ClearMemory = false);
+
+/** @brief Return memory to the heap.
+
+@param Heap The heap the memory came from.
+@param Memory Memory from `hp_Alloc()` or `hp_Realloc()`. May be 0.
+**/
+void hp_Free(heap *Heap, void *Memory);
+
+/** @brief Change the size of memory from the heap.
+
+Grows or shrinks in place when it can; otherwise moves the memory to a new block, copying the contents.
+
+@param Heap The heap the memory came from.
+@param Memory Memory from `hp_Alloc()` or `hp_Realloc()`. If 0, this is the same as `hp_Alloc()`.
+@param Size The new size. If 0, the memory is freed and 0 returned.
+@return Pointer to the memory, which may have moved; 0 if there isn't enough memory, in which case the original memory is untouched.
+**/
+void *hp_Realloc(heap *Heap, void *Memory, size_t Size);
+
+/** @brief Get the usable size of memory from the heap. This may be larger than what was asked for. **/
+size_t hp_GetSize(void *Memory);
+
+/** @brief Get the heap's usage and fragmentation.
+
+This walks every block in the heap, so don't call it somewhere latency matters.
+**/
+heap_stats hp_GetStats(heap *Heap);
+
+#endif // AB_HEAP_H
+
+/*************************************************/
+#ifdef AB_HEAP_SRC
+
+#define HP_BLOCK_HEADER_SIZE (2*sizeof(void*) > HP_ALIGN ? 2*sizeof(void*) : HP_ALIGN)
+#define HP_MIN_BLOCK_SIZE (sizeof(hp_block) - HP_BLOCK_HEADER_SIZE > HP_ALIGN ? sizeof(hp_block) - HP_BLOCK_HEADER_SIZE : HP_ALIGN)
+#define HP_BLOCK_FREE 1
+#define HP_BLOCK_FLAGS (HP_ALIGN - 1)
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+inline u32
+hp_FindFirstSet_(u32 Value)
+{
+#if defined(_MSC_VER)
+    unsigned long Result;
+    _BitScanForward(&Result, Value);
+    return (u32)Result;
+#else
+    return (u32)__builtin_ctz(Value);
+#endif
+}
+
+inline u32
+hp_FindLastSet_(size_t Value)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long Result;
+    _BitScanReverse64(&Result, Value);
+    return (u32)Result;
+#elif defined(_MSC_VER)
+    unsigned long Result;
+    _BitScanReverse(&Result, Value);
+    return (u32)Result;
+#else
+    return (u32)(8*sizeof(unsigned long long) - 1 - __builtin_clzll((unsigned long long)Value));
+#endif
+}
+
+inline size_t
+hp_BlockSize_(hp_block *Block)
+{
+    return Block->Size & ~(size_t)HP_BLOCK_FLAGS;
+}
+
+inline b8
+hp_IsFree_(hp_block *Block)
+{
+    return (Block->Size & HP_BLOCK_FREE) != 0;
+}
+
+inline void *
+hp_BlockMemory_(hp_block *Block)
+{
+    return ((u8*)Block) + HP_BLOCK_HEADER_SIZE;
+}
+
+inline hp_block *
+hp_BlockFromMemory_(void *Memory)
+{
+    return (hp_block*)(((u8*)Memory) - HP_BLOCK_HEADER_SIZE);
+}
+
+inline hp_block *
+hp_NextPhysical_(hp_block *Block)
+{
+    return (hp_block*)(((u8*)hp_BlockMemory_(Block)) + hp_BlockSize_(Block));
+}
+
+inline size_t
+hp_AdjustSize_(size_t Size)
+{
+    size_t Result = (Size + HP_ALIGN - 1) & ~(size_t)(HP_ALIGN - 1);
+    Result = MAXIMUM(Result, HP_MIN_BLOCK_SIZE);
+    
+    return Result;
+}
+
+// NOTE(amos): The free list a block of this size belongs in.
+inline void
+hp_MappingInsert_(size_t Size, u32 *FlOut, u32 *SlOut)
+{
+    if(Size < HP_SMALL_BLOCK_SIZE)
+    {
+        *FlOut = 0;
+        *SlOut = (u32)(Size / (HP_SMALL_BLOCK_SIZE / HP_SL_INDEX_COUNT));
+    }
+    else
+    {
+        u32 Fl = hp_FindLastSet_(Size);
+        *SlOut = (u32)(Size >> (Fl - HP_SL_INDEX_COUNT_LOG2)) ^ (1 << HP_SL_INDEX_COUNT_LOG2);
+        *FlOut = Fl - (HP_FL_INDEX_SHIFT - 1);
+    }
+}
+
+// NOTE(amos): The first free list where every block is at least this size. Rounds up to the next size class.
+inline void
+hp_MappingSearch_(size_t Size, u32 *FlOut, u32 *SlOut)
+{
+    if(Size >= HP_SMALL_BLOCK_SIZE)
+    {
+        Size += ((size_t)1 << (hp_FindLastSet_(Size) - HP_SL_INDEX_COUNT_LOG2)) - 1;
+    }
+    hp_MappingInsert_(Size, FlOut, SlOut);
+}
+
+hp_block *
+hp_FindFreeBlock_(heap *Heap, u32 *Fl, u32 *Sl)
+{
+    hp_block *Result = 0;
+    
+    u32 SlMap = Heap->SlBitmap[*Fl] & (~0U << *Sl);
+    if(!SlMap)
+    {
+        u32 FlMap = Heap->FlBitmap & (~0U << (*Fl + 1));
+        if(FlMap)
+        {
+            *Fl = hp_FindFirstSet_(FlMap);
+            SlMap = Heap->SlBitmap[*Fl];
+        }
+    }
+    
+    if(SlMap)
+    {
+        *Sl = hp_FindFirstSet_(SlMap);
+        Result = Heap->FreeBlocks[*Fl][*Sl];
+    }
+    
+    return Result;
+}
+
+void
+hp_InsertFreeBlock_(heap *Heap, hp_block *Block)
+{
+    u32 Fl, Sl;
+    hp_MappingInsert_(hp_BlockSize_(Block), &Fl, &Sl);
+    
+    hp_block *Head = Heap->FreeBlocks[Fl][Sl];
+    Block->NextFree = Head;
+    Block->PrevFree = 0;
+    if(Head)
+    {
+        Head->PrevFree = Block;
+    }
+    Heap->FreeBlocks[Fl][Sl] = Block;
+    
+    Heap->FlBitmap |= (1U << Fl);
+    Heap->SlBitmap[Fl] |= (1U << Sl);
+}
+
+void
+hp_RemoveFreeBlock_(heap *Heap, hp_block *Block)
+{
+    u32 Fl, Sl;
+    hp_MappingInsert_(hp_BlockSize_(Block), &Fl, &Sl);
+    
+    if(Block->PrevFree)
+    {
+        Block->PrevFree->NextFree = Block->NextFree;
+    }
+    else
+    {
+        Heap->FreeBlocks[Fl][Sl] = Block->NextFree;
+    }
+    
+    if(Block->NextFree)
+    {
+        Block->NextFree->PrevFree = Block->PrevFree;
+    }
+    
+    if(!Heap->FreeBlocks[Fl][Sl])
+    {
+        Heap->SlBitmap[Fl] &= ~(1U << Sl);
+        if(!Heap->SlBitmap[Fl])
+        {
+            Heap->FlBitmap &= ~(1U << Fl);
+        }
+    }
+}
+
+// NOTE(amos): Cut a block down to Size, returning the rest to the free lists. The rest is merged with the next block if
+// that's free.
+void
+hp_TrimBlock_(heap *Heap, hp_block *Block, size_t Size)
+{
+    size_t BlockSize = hp_BlockSize_(Block);
+    if(BlockSize >= (Size + HP_BLOCK_HEADER_SIZE + HP_MIN_BLOCK_SIZE))
+    {
+        hp_block *Remainder = (hp_block*)(((u8*)hp_BlockMemory_(Block)) + Size);
+        Remainder->PrevPhysical = Block;
+        Remainder->Size = (BlockSize - Size - HP_BLOCK_HEADER_SIZE) | HP_BLOCK_FREE;
+        Block->Size = Size | (Block->Size & HP_BLOCK_FLAGS);
+        
+        hp_block *Next = hp_NextPhysical_(Remainder);
+        if(hp_IsFree_(Next))
+        {
+            hp_RemoveFreeBlock_(Heap, Next);
+            Remainder->Size += HP_BLOCK_HEADER_SIZE + hp_BlockSize_(Next);
+        }
+        hp_NextPhysical_(Remainder)->PrevPhysical = Remainder;
+        
+        hp_InsertFreeBlock_(Heap, Remainder);
+    }
+}
+
+heap *
+hp_CreateHeap(memory_arena *Arena, size_t Size)
+{
+    heap *Heap = 0;
+    
+    size_t ControlSize = hp_AdjustSize_(sizeof(heap));
+    size_t RegionSize = (Size > ControlSize) ? ((Size - ControlSize) & ~(size_t)(HP_ALIGN - 1)) : 0;
+    if(RegionSize >= (2*HP_BLOCK_HEADER_SIZE + HP_MIN_BLOCK_SIZE) &&
+       RegionSize <= HP_MAX_BLOCK_SIZE)
+    {
+        Heap = (heap*)mem_PushSize_(Arena, ControlSize + RegionSize, false, HP_ALIGN);
+    }
+    
+    if(Heap)
+    {
+        *Heap = {};
+        Heap->TotalSize = RegionSize;
+        
+        // NOTE(amos): One free block covering the region, then a used, empty block so merging always stops at the end.
+        hp_block *First = (hp_block*)(((u8*)Heap) + ControlSize);
+        First->PrevPhysical = 0;
+        First->Size = (RegionSize - 2*HP_BLOCK_HEADER_SIZE) | HP_BLOCK_FREE;
+        
+        hp_block *Sentinel = hp_NextPhysical_(First);
+        Sentinel->PrevPhysical = First;
+        Sentinel->Size = 0;
+        
+        Heap->FirstBlock = First;
+        hp_InsertFreeBlock_(Heap, First);
+    }
+    
+    return Heap;
+}
+
+void *
+hp_Alloc(heap *Heap, size_t Size, b8 ClearMemory)
+{
+    void *Result = 0;
+    
+    if(Size && Size <= HP_MAX_BLOCK_SIZE)
+    {
+        size_t AdjustedSize = hp_AdjustSize_(Size);
+        
+        u32 Fl, Sl;
+        hp_MappingSearch_(AdjustedSize, &Fl, &Sl);
+        hp_block *Block = (Fl < HP_FL_INDEX_COUNT) ? hp_FindFreeBlock_(Heap, &Fl, &Sl) : 0;
+        if(Block)
+        {
+            hp_RemoveFreeBlock_(Heap, Block);
+            Block->Size &= ~(size_t)HP_BLOCK_FREE;
+            hp_TrimBlock_(Heap, Block, AdjustedSize);
+            
+            Result = hp_BlockMemory_(Block);
+            if(ClearMemory)
+            {
+                mem_ZeroSize(Result, Size);
+            }
+        }
+    }
+    
+    return Result;
+}
+
+void
+hp_Free(heap *Heap, void *Memory)
+{
+    if(Memory)
+    {
+        hp_block *Block = hp_BlockFromMemory_(Memory);
+        Assert(!hp_IsFree_(Block));
+        
+        Block->Size |= HP_BLOCK_FREE;
+        
+        hp_block *Prev = Block->PrevPhysical;
+        if(Prev && hp_IsFree_(Prev))
+        {
+            hp_RemoveFreeBlock_(Heap, Prev);
+            Prev->Size += HP_BLOCK_HEADER_SIZE + hp_BlockSize_(Block);
+            Block = Prev;
+        }
+        
+        hp_block *Next = hp_NextPhysical_(Block);
+        if(hp_IsFree_(Next))
+        {
+            hp_RemoveFreeBlock_(Heap, Next);
+            Block->Size += HP_BLOCK_HEADER_SIZE + hp_BlockSize_(Next);
+        }
+        hp_NextPhysical_(Block)->PrevPhysical = Block;
+        
+        hp_InsertFreeBlock_(Heap, Block);
+    }
+}
+
+void *
+hp_Realloc(heap *Heap, void *Memory, size_t Size)
+{
+    void *Result = 0;
+    
+    if(!Memory)
+    {
+        Result = hp_Alloc(Heap, Size);
+    }
+    else if(!Size)
+    {
+        hp_Free(Heap, Memory);
+    }
+    else if(Size <= HP_MAX_BLOCK_SIZE)
+    {
+        hp_block *Block = hp_BlockFromMemory_(Memory);
+        size_t AdjustedSize = hp_AdjustSize_(Size);
+        size_t BlockSize = hp_BlockSize_(Block);
+        hp_block *Next = hp_NextPhysical_(Block);
+        
+        if(AdjustedSize <= BlockSize)
+        {
+            hp_TrimBlock_(Heap, Block, AdjustedSize);
+            Result = Memory;
+        }
+        else if(hp_IsFree_(Next) &&
+                (BlockSize + HP_BLOCK_HEADER_SIZE + hp_BlockSize_(Next)) >= AdjustedSize)
+        {
+            hp_RemoveFreeBlock_(Heap, Next);
+            Block->Size += HP_BLOCK_HEADER_SIZE + hp_BlockSize_(Next);
+            hp_NextPhysical_(Block)->PrevPhysical = Block;
+            
+            hp_TrimBlock_(Heap, Block, AdjustedSize);
+            Result = Memory;
+        }
+        else
+        {
+            Result = hp_Alloc(Heap, Size);
+            if(Result)
+            {
+                memcpy(Result, Memory, BlockSize);
+                hp_Free(Heap, Memory);
+            }
+        }
+    }
+    
+    return Result;
+}
+
+size_t
+hp_GetSize(void *Memory)
+{
+    size_t Result = 0;
+    if(Memory)
+    {
+        Result = hp_BlockSize_(hp_BlockFromMemory_(Memory));
+    }
+    
+    return Result;
+}
+
+heap_stats
+hp_GetStats(heap *Heap)
+{
+    heap_stats Stats = {};
+    Stats.TotalSize = Heap->TotalSize;
+    
+    for(hp_block *Block = Heap->FirstBlock;
+        hp_BlockSize_(Block);
+        Block = hp_NextPhysical_(Block))
+    {
+        size_t BlockSize = hp_BlockSize_(Block);
+        if(hp_IsFree_(Block))
+        {
+            Stats.FreeSize += BlockSize;
+            ++Stats.FreeBlockCount;
+            Stats.LargestFreeBlock = MAXIMUM(Stats.LargestFreeBlock, BlockSize);
+        }
+        else
+        {
+            Stats.UsedSize += BlockSize;
+            ++Stats.UsedBlockCount;
+        }
+    }
+    
+    if(Stats.FreeSize)
+    {
+        Stats.Fragmentation = 1.0f - ((r32)Stats.LargestFreeBlock / (r32)Stats.FreeSize);
+    }
+    
+    return Stats;
+}
+
+#undef AB_HEAP_SRC
+#endif // AB_HEAP_SRC
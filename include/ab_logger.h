@@ -72,6 +72,12 @@ log_Shutdown(Logger);
 
 You can see an example of receiving the log messages with @ref ab_loggerclient.h.
 
+# Deferred Formatting
+
+Formatting a message with printf() takes about a microsecond, which is most of the cost of a log call. Build with `LOG_DEFERRED` defined as 1 to move that work to the client. Each log line then becomes a call site with a fixed ID, set up the first time it runs. A call only checks the level, copies its arguments into a small record, and sends the call site ID and the record. The format string and the argument types, which a variadic template works out at compile time, are sent once per call site, and again whenever someone new subscribes. @ref ab_loggerclient.h keeps them, and builds the text when a record comes in.
+
+In this mode the arguments can only be numbers, enums, pointers and C strings. Strings are copied into the record, and cut short if the arguments don't fit in `LOG_DEFERRED_BUFFER_SIZE` bytes. Formats with `%n` are not supported.
+
 # References
 
 - @ref ab_loggerclient.h
@@ -85,6 +91,9 @@ You can see an example of receiving the log messages with @ref ab_loggerclient.h
 
 #include "czmq.h"
 
+#include <string.h>
+#include <type_traits>
+
 #include "ab_common.h"
 #include "ab_memory.h"
 
@@ -108,15 +117,28 @@ struct logger;
 
 Logger: The logger struct.
 Port: TCP port for the ROUTER to bind to.
+Level: Lowest level that is sent.
 
 Format of zmq message:
 Frame 1: String, Level. Example: "INFO"
      Frame 2: u64, Timestamp, based on linux Epoch. 
 Frame 3: String, 'File:Line'. Example "main.cpp:123"
 Frame 4: String, Log Message, Example "Some Message."
+
+Deferred messages (see LOG_DEFERRED) have three frames instead:
+Frame 1: String, Level.
+Frame 2: u64, Timestamp.
+Frame 3: Binary, u32 call site ID followed by the packed arguments.
+
+The first time a call site is used, and again after anyone new subscribes, its format goes out before its message, in five frames:
+Frame 1: String, Level of the call site.
+Frame 2: u32, Call site ID.
+Frame 3: String, 'File:Line'.
+Frame 4: String, printf() format.
+Frame 5: String, Type of each argument: 'i' signed, 'u' unsigned, 'f' floating point, 'p' pointer, 's' string.
 */
 logger *
-log_InitializeLogger(memory_arena *Memory, s32 Port);
+log_InitializeLogger(memory_arena *Memory, s32 Port, log_level Level);
 
 /** @brief Set log level. 
 
@@ -134,6 +156,29 @@ void log_SetPause(logger *Logger, b8 doPause);
 /** @brief Shutdown the logger object. **/
 void log_Shutdown(logger *Logger);
 
+#ifndef LOG_DEFERRED
+/** @brief Define as 1 to send raw arguments instead of formatted text. See "Deferred Formatting" above. **/
+#define LOG_DEFERRED 0
+#endif
+
+#ifndef LOG_MAX_DEFERRED_SITES
+/** @brief Number of deferred call sites that can be sent without formatting. Later ones are formatted as usual. **/
+#define LOG_MAX_DEFERRED_SITES 4096
+#endif
+
+#ifndef LOG_DEFERRED_BUFFER_SIZE
+/** @brief Bytes of arguments a deferred message can carry. Strings that don't fit are cut short. **/
+#define LOG_DEFERRED_BUFFER_SIZE 256
+#endif
+
+#if LOG_DEFERRED
+#define log_trace(LOGGER, Fmt, ...) log_Deferred_(LOGGER, LOGGER_TRACE, Fmt, ##__VA_ARGS__)
+#define log_debug(LOGGER, Fmt, ...) log_Deferred_(LOGGER, LOGGER_DEBUG, Fmt, ##__VA_ARGS__)
+#define log_info(LOGGER, Fmt, ...)  log_Deferred_(LOGGER, LOGGER_INFO,  Fmt, ##__VA_ARGS__)
+#define log_warn(LOGGER, Fmt, ...)  log_Deferred_(LOGGER, LOGGER_WARN,  Fmt, ##__VA_ARGS__)
+#define log_error(LOGGER, Fmt, ...) log_Deferred_(LOGGER, LOGGER_ERROR, Fmt, ##__VA_ARGS__)
+#define log_fatal(LOGGER, Fmt, ...) log_Deferred_(LOGGER, LOGGER_FATAL, Fmt, ##__VA_ARGS__)
+#else
 /** @brief Log for a Trace message. **/
 #define log_trace(LOGGER, Fmt, ...) log_LogFunction(LOGGER, LOGGER_TRACE, __FILE__, __LINE__, Fmt, ##__VA_ARGS__)
 
@@ -151,6 +196,7 @@ void log_Shutdown(logger *Logger);
 
 /** @brief Log for a Fatal message. **/
 #define log_fatal(LOGGER, Fmt, ...) log_LogFunction(LOGGER, LOGGER_FATAL, __FILE__, __LINE__, Fmt, ##__VA_ARGS__)
+#endif
 
 /** @private 
 
@@ -158,11 +204,174 @@ Don't use this function directly. Use the defines, above.
 **/
 void log_LogFunction(logger *Logger, log_level Level, const char *File, s32 Line, const char *Fmt, ...);
 
+/** @private Everything about a deferred log call that doesn't change between calls. **/
+struct log_site
+{
+    u32 Id;
+    log_level Level;
+    char const *File;
+    s32 Line;
+    char const *Format;
+    char const *ArgTypes;
+};
+
+/** @private Type code for one argument of a deferred log. **/
+template<typename T>
+struct log_arg_type
+{
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+                  "Deferred logs can only take numbers, pointers and C strings.");
+    static constexpr char Code = (std::is_floating_point<T>::value ? 'f' :
+                                  std::is_pointer<T>::value ? 'p' :
+                                  (std::is_signed<T>::value || std::is_enum<T>::value) ? 'i' : 'u');
+};
+
+/** @private **/
+template<>
+struct log_arg_type<char *>
+{
+    static constexpr char Code = 's';
+};
+
+/** @private **/
+template<>
+struct log_arg_type<char const *>
+{
+    static constexpr char Code = 's';
+};
+
+/** @private Type codes for every argument of a deferred log, as a string. **/
+template<typename... Args>
+struct log_arg_types
+{
+    static constexpr char Types[sizeof...(Args) + 1] = {log_arg_type<Args>::Code..., 0};
+};
+
+/** @private Only used inside decltype(), to get the argument types without evaluating the arguments. **/
+template<typename... Args>
+log_arg_types<typename std::decay<Args>::type...> log_GetArgTypes_(Args &&...Arguments);
+
+/** @private **/
+struct log_packer
+{
+    u8 *At;
+    u8 *End;
+};
+
+/** @private Once something doesn't fit, nothing after it is written either. **/
+inline void
+log_Pack_(log_packer *Packer, void const *Data, size_t Size)
+{
+    if((size_t)(Packer->End - Packer->At) >= Size)
+    {
+        memcpy(Packer->At, Data, Size);
+        Packer->At += Size;
+    }
+    else
+    {
+        Packer->At = Packer->End;
+    }
+}
+
+/** @private Numbers are widened to 64 bits. Strings are copied as a u16 length and the characters, with a length of 0xFFFF for null. **/
+template<typename T>
+inline void
+log_PackArg_(log_packer *Packer, T Value)
+{
+    char const Code = log_arg_type<T>::Code;
+    if constexpr(Code == 's')
+    {
+        size_t Left = Packer->End - Packer->At;
+        if(Left >= sizeof(u16))
+        {
+            u16 Length = 0xFFFF;
+            if(Value)
+            {
+                size_t StringLength = strnlen(Value, Left - sizeof(u16));
+                Length = (u16)(StringLength < 0xFFFE ? StringLength : 0xFFFE);
+            }
+            log_Pack_(Packer, &Length, sizeof(u16));
+            if(Value)
+            {
+                log_Pack_(Packer, Value, Length);
+            }
+        }
+        else
+        {
+            Packer->At = Packer->End;
+        }
+    }
+    else if constexpr(Code == 'f')
+    {
+        r64 Number = (r64)Value;
+        log_Pack_(Packer, &Number, sizeof(r64));
+    }
+    else if constexpr(Code == 'p')
+    {
+        u64 Number = (u64)(uintptr_t)Value;
+        log_Pack_(Packer, &Number, sizeof(u64));
+    }
+    else if constexpr(Code == 'i')
+    {
+        s64 Number = (s64)Value;
+        log_Pack_(Packer, &Number, sizeof(s64));
+    }
+    else
+    {
+        u64 Number = (u64)Value;
+        log_Pack_(Packer, &Number, sizeof(u64));
+    }
+}
+
+/** @private Gives a call site its ID. **/
+log_site log_MakeSite_(log_level Level, char const *File, s32 Line, char const *Format, char const *ArgTypes);
+
+/** @private **/
+b8 log_IsLogging_(logger *Logger, log_level Level);
+
+/** @private Sends the packed record, and the call site's format first if this logger hasn't sent it yet. **/
+void log_SendDeferred_(logger *Logger, log_site const *Site, u8 const *Record, size_t RecordSize);
+
+/** @private **/
+template<typename... Args>
+void
+log_LogDeferred_(logger *Logger, log_site const *Site, Args... Arguments)
+{
+    if(log_IsLogging_(Logger, Site->Level))
+    {
+        if(Site->Id < LOG_MAX_DEFERRED_SITES)
+        {
+            u8 Record[LOG_DEFERRED_BUFFER_SIZE];
+            log_packer Packer = {Record, Record + sizeof(Record)};
+            log_Pack_(&Packer, &Site->Id, sizeof(u32));
+            (log_PackArg_(&Packer, Arguments), ...);
+            log_SendDeferred_(Logger, Site, Record, Packer.At - Record);
+        }
+        else
+        {
+            log_LogFunction(Logger, Site->Level, Site->File, Site->Line, Site->Format, Arguments...);
+        }
+    }
+}
+
+// NOTE(amos): The site is a static local, so it's set up once, the first time the line runs. After that a call only
+// checks the level and copies its arguments.
+/** @private **/
+#define log_Deferred_(LOGGER, LEVEL, Fmt, ...)                                                                    \
+do                                                                                                                \
+{                                                                                                                 \
+    static log_site const log_Site_ = log_MakeSite_(LEVEL, __FILE__, __LINE__, Fmt,                               \
+                                                    decltype(log_GetArgTypes_(__VA_ARGS__))::Types);              \
+    log_LogDeferred_(LOGGER, &log_Site_, ##__VA_ARGS__);                                                          \
+} while(0)
+
 #endif //AB_LOGGER_H
 
 /*************************************************/
 #ifdef AB_LOGGER_SRC
 
+#include <atomic>
+
 static const char *LevelNames[] = {
     "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
 };
@@ -174,8 +383,13 @@ struct logger
     s32 Port;
     log_level Level;
     b8 isPaused;
+    
+    // NOTE(amos): One bit per deferred call site, set once its format has been sent.
+    u64 SentSites[(LOG_MAX_DEFERRED_SITES + 63)/64];
 };
 
+static std::atomic<u32> log_SiteCount_(0);
+
 logger *
 log_InitializeLogger(memory_arena *Memory, s32 Port, log_level Level)
 {
@@ -185,7 +399,15 @@ log_InitializeLogger(memory_arena *Memory, s32 Port, log_level Level)
     
     zsys_handler_set(NULL);
     //zsock_t *Socket = zsock_new_pub("tcp://*:5555");
+#if LOG_DEFERRED
+    // NOTE(amos): XPUB sends just like PUB, but also hands us each new subscription, so deferred formats can be sent
+    // again for the new subscriber. Only the deferred path reads the subscriptions, so text mode keeps PUB, or
+    // they'd queue up forever.
+    zsock_t *Socket = zsock_new(ZMQ_XPUB);
+    zsock_set_xpub_verbose(Socket, 1);
+#else
     zsock_t *Socket = zsock_new(ZMQ_PUB);
+#endif
     //zsock_set_sndtimeo(Socket, ZcmqTimeoutMs);
     s32 BindPort = zsock_bind(Socket, "tcp://*:%d", Port);
     
@@ -202,6 +424,7 @@ log_InitializeLogger(memory_arena *Memory, s32 Port, log_level Level)
         Logger->Port = Port;
         Logger->Level = Level;
         Logger->isPaused = false;
+        memset(Logger->SentSites, 0, sizeof(Logger->SentSites));
         
         printf("Binding to port %d at log level %s\n", Port, LevelNames[Level]);
     }
@@ -267,8 +490,11 @@ void log_LogFunction(logger *Logger, log_level Level, const char *File, s32 Line
             //printf("[Message] ");
             va_list args;
             va_start(args, Fmt);
-            Response = zmsg_addstrf(Msg, Fmt, args);
+            char *Message = zsys_vprintf(Fmt, args);
             va_end(args);
+            
+            Response = Message ? zmsg_addstr(Msg, Message) : -1;
+            zstr_free(&Message);
         }
         
         if(Response > -1)
@@ -284,6 +510,82 @@ void log_LogFunction(logger *Logger, log_level Level, const char *File, s32 Line
     }
 }
 
+log_site
+log_MakeSite_(log_level Level, char const *File, s32 Line, char const *Format, char const *ArgTypes)
+{
+    log_site Result = {};
+    Result.Id = log_SiteCount_.fetch_add(1);
+    Result.Level = Level;
+    Result.File = File;
+    Result.Line = Line;
+    Result.Format = Format;
+    Result.ArgTypes = ArgTypes;
+    
+    return Result;
+}
+
+b8
+log_IsLogging_(logger *Logger, log_level Level)
+{
+    return Logger->Socket && Level >= Logger->Level && !Logger->isPaused;
+}
+
+static b8
+log_SendFormat_(logger *Logger, log_site const *Site)
+{
+    zmsg_t *Msg = zmsg_new();
+    zmsg_addstr(Msg, LevelNames[Site->Level]);
+    zmsg_addmem(Msg, &Site->Id, sizeof(u32));
+    zmsg_addstrf(Msg, "%s:%d", Site->File, Site->Line);
+    zmsg_addstr(Msg, Site->Format);
+    zmsg_addstr(Msg, Site->ArgTypes);
+    
+    // NOTE(amos): zmsg_send only takes the message when it succeeds.
+    b8 Result = zmsg_send(&Msg, Logger->Socket) == 0;
+    if(!Result)
+    {
+        zmsg_destroy(&Msg);
+    }
+    
+    return Result;
+}
+
+void
+log_SendDeferred_(logger *Logger, log_site const *Site, u8 const *Record, size_t RecordSize)
+{
+    // NOTE(amos): Someone who just subscribed hasn't seen any formats, so send each one again the next time it's used.
+    while(zsock_events(Logger->Socket) & ZMQ_POLLIN)
+    {
+        zframe_t *Subscription = zframe_recv(Logger->Socket);
+        if(Subscription && zframe_size(Subscription) > 0 && zframe_data(Subscription)[0] == 1)
+        {
+            memset(Logger->SentSites, 0, sizeof(Logger->SentSites));
+        }
+        zframe_destroy(&Subscription);
+    }
+    
+    u64 SiteBit = 1ull << (Site->Id % 64);
+    if(!(Logger->SentSites[Site->Id/64] & SiteBit))
+    {
+        // NOTE(amos): If the format didn't go out, leave the bit clear so the next call tries again.
+        if(log_SendFormat_(Logger, Site))
+        {
+            Logger->SentSites[Site->Id/64] |= SiteBit;
+        }
+    }
+    
+    // NOTE(amos): Straight to zmq, rather than through a zmsg_t; small frames are copied without touching the heap.
+    void *Socket = zsock_resolve(Logger->Socket);
+    char const *LevelName = LevelNames[Site->Level];
+    u64 Epochtime = (u64)time(NULL);
+    if(zmq_send(Socket, LevelName, strlen(LevelName), ZMQ_SNDMORE) == -1 ||
+       zmq_send(Socket, &Epochtime, sizeof(u64), ZMQ_SNDMORE) == -1 ||
+       zmq_send(Socket, Record, RecordSize, 0) == -1)
+    {
+        printf("Failed to send message.\n");
+    }
+}
+
 #undef AB_LOGGER_SRC
 #endif // defined(AB_LOGGER_SRC)
 
@@ -45,6 +45,10 @@ sleep(10);
 lc_Shutdown(Client);
 ~~~
 
+# Deferred Messages
+
+Loggers built with `LOG_DEFERRED` send a call site ID and the raw arguments instead of text. Each endpoint keeps the formats its logger sends, and the client formats the message itself before passing it on to the log function, so the log function sees the same @ref lc_message either way. A message whose format hasn't arrived, which can happen right after subscribing, is printed as its call site ID.
+
 # References
 
 - @ref test_loggerclient.cpp
@@ -162,12 +166,32 @@ lc_BasicLogger(lc_message *Message, char *EndpointLabel, b8 isPause, b8 isQuiet,
 #endif //AB_LOGGERCLIENT_H
 
 #ifdef AB_LOGGERCLIENT_SRC
+
+/** @brief Largest deferred message, after formatting. Longer messages are cut short. **/
+#ifndef LC_MESSAGE_SIZE
+#define LC_MESSAGE_SIZE 1024
+#endif
+
+/** @brief Call site IDs above this are treated as garbage. **/
+#define LC_MAX_FORMATS 65536
+
+struct lc_format
+{
+    char *File;
+    char *Format;
+    char *ArgTypes;
+};
+
 struct lc_endpoint
 {
     zsock_t *Socket;
     u32 Index;
     char *Name;
     
+    // NOTE(amos): Formats of deferred messages, indexed by call site ID.
+    lc_format *Formats;
+    u32 FormatCount;
+    
     lc_endpoint *Next;
 };
 
@@ -211,6 +235,16 @@ lc_RemoveEndpoint(lc_thread *Thread, u32 Index)
             }
             printf("Removing Endpoint %s.\n", Current->Name);
             free(Current->Name);
+            for(u32 FormatIndex = 0; FormatIndex < Current->FormatCount; ++FormatIndex)
+            {
+                lc_format *Format = Current->Formats + FormatIndex;
+                free(Format->File);
+                free(Format->Format);
+                free(Format->ArgTypes);
+            }
+            free(Current->Formats);
+            Current->Formats = 0;
+            Current->FormatCount = 0;
             zsock_destroy(&Current->Socket);
             Current->Socket = 0;
             Current->Next = Thread->DeadEndpointList;
@@ -226,6 +260,313 @@ lc_RemoveEndpoint(lc_thread *Thread, u32 Index)
     }
 } // lc_RemoveEndpoint
 
+static void
+lc_AddFormat(lc_endpoint *Endpoint, zmsg_t *FormatMsg)
+{
+    char *LogLevel = zmsg_popstr(FormatMsg);
+    zframe_t *IdFrame = zmsg_pop(FormatMsg);
+    char *File = zmsg_popstr(FormatMsg);
+    char *Format = zmsg_popstr(FormatMsg);
+    char *ArgTypes = zmsg_popstr(FormatMsg);
+    
+    u32 Id = LC_MAX_FORMATS;
+    if(zframe_size(IdFrame) == sizeof(u32))
+    {
+        memcpy(&Id, zframe_data(IdFrame), sizeof(u32));
+    }
+    
+    if(Id < LC_MAX_FORMATS && File && Format && ArgTypes)
+    {
+        if(Id >= Endpoint->FormatCount)
+        {
+            u32 NewCount = Endpoint->FormatCount ? Endpoint->FormatCount : 64;
+            while(NewCount <= Id)
+            {
+                NewCount *= 2;
+            }
+            
+            lc_format *NewFormats = (lc_format*)realloc(Endpoint->Formats, NewCount*sizeof(lc_format));
+            if(NewFormats)
+            {
+                memset(NewFormats + Endpoint->FormatCount, 0, (NewCount - Endpoint->FormatCount)*sizeof(lc_format));
+                Endpoint->Formats = NewFormats;
+                Endpoint->FormatCount = NewCount;
+            }
+        }
+        
+        if(Id < Endpoint->FormatCount)
+        {
+            // NOTE(amos): Formats are sent again for every new subscriber, so most of the time this replaces the same
+            // strings.
+            lc_format *Entry = Endpoint->Formats + Id;
+            free(Entry->File);
+            free(Entry->Format);
+            free(Entry->ArgTypes);
+            Entry->File = File;
+            Entry->Format = Format;
+            Entry->ArgTypes = ArgTypes;
+            File = Format = ArgTypes = 0;
+        }
+    }
+    
+    free(LogLevel);
+    zframe_destroy(&IdFrame);
+    free(File);
+    free(Format);
+    free(ArgTypes);
+} // lc_AddFormat
+
+struct lc_arg_reader
+{
+    char const *Types;
+    u8 const *At;
+    u8 const *End;
+};
+
+/* Reads the next argument of a deferred message. Returns its type code, or 0 if there are no arguments left. */
+static char
+lc_ReadArg(lc_arg_reader *Reader, u64 *Value, char const **String, u32 *StringLength)
+{
+    char Code = *Reader->Types;
+    if(Code)
+    {
+        ++Reader->Types;
+        if(Code == 's')
+        {
+            u16 Length = 0;
+            if(Reader->End - Reader->At >= (ptrdiff_t)sizeof(u16))
+            {
+                memcpy(&Length, Reader->At, sizeof(u16));
+                Reader->At += sizeof(u16);
+                if(Length == 0xFFFF)
+                {
+                    *String = "(null)";
+                    *StringLength = 6;
+                }
+                else if(Reader->End - Reader->At >= Length)
+                {
+                    *String = (char const *)Reader->At;
+                    *StringLength = Length;
+                    Reader->At += Length;
+                }
+                else
+                {
+                    Code = 0;
+                }
+            }
+            else
+            {
+                Code = 0;
+            }
+        }
+        else if(Reader->End - Reader->At >= (ptrdiff_t)sizeof(u64))
+        {
+            memcpy(Value, Reader->At, sizeof(u64));
+            Reader->At += sizeof(u64);
+        }
+        else
+        {
+            Code = 0;
+        }
+    }
+    
+    return Code;
+} // lc_ReadArg
+
+static void
+lc_AppendSpec(char *Spec, u32 *SpecLength, u32 SpecSize, char const *Text)
+{
+    while(*Text && *SpecLength + 1 < SpecSize)
+    {
+        Spec[(*SpecLength)++] = *Text++;
+    }
+    Spec[*SpecLength] = '\0';
+}
+
+/* Builds the text of a deferred message. Each conversion is passed to snprintf() on its own, with the length
+   changed to match how the argument was sent, so a type that doesn't fit its conversion prints "<?>" instead of
+   reading the wrong thing. */
+static void
+lc_FormatDeferred(char const *Format, char const *ArgTypes, u8 const *Args, size_t ArgsSize,
+                  char *Buffer, size_t BufferSize)
+{
+    lc_arg_reader Reader = {ArgTypes, Args, Args + ArgsSize};
+    size_t Used = 0;
+    char const *At = Format;
+    while(*At && Used + 1 < BufferSize)
+    {
+        if(*At != '%')
+        {
+            Buffer[Used++] = *At++;
+        }
+        else if(At[1] == '%')
+        {
+            Buffer[Used++] = '%';
+            At += 2;
+        }
+        else
+        {
+            char Spec[64];
+            u32 SpecLength = 0;
+            char Piece[2] = {};
+            u64 Value = 0;
+            char const *String = 0;
+            u32 StringLength = 0;
+            
+            lc_AppendSpec(Spec, &SpecLength, sizeof(Spec), "%");
+            ++At;
+            while(*At && strchr("-+ #0'", *At))
+            {
+                Piece[0] = *At++;
+                lc_AppendSpec(Spec, &SpecLength, sizeof(Spec), Piece);
+            }
+            
+            for(u32 Part = 0; Part < 2; ++Part)
+            {
+                if(Part == 1)
+                {
+                    if(*At != '.')
+                    {
+                        break;
+                    }
+                    lc_AppendSpec(Spec, &SpecLength, sizeof(Spec), ".");
+                    ++At;
+                }
+                
+                if(*At == '*')
+                {
+                    char Number[24];
+                    s64 Star = 0;
+                    char Code = lc_ReadArg(&Reader, &Value, &String, &StringLength);
+                    if(Code == 'i' || Code == 'u')
+                    {
+                        Star = (s64)Value;
+                    }
+                    ++At;
+                    
+                    if(Part == 1 && Star < 0)
+                    {
+                        // NOTE(amos): A negative precision counts as no precision at all.
+                        Spec[--SpecLength] = '\0';
+                    }
+                    else
+                    {
+                        snprintf(Number, sizeof(Number), "%lld", (long long)Star);
+                        lc_AppendSpec(Spec, &SpecLength, sizeof(Spec), Number);
+                    }
+                }
+                else
+                {
+                    while(*At >= '0' && *At <= '9')
+                    {
+                        Piece[0] = *At++;
+                        lc_AppendSpec(Spec, &SpecLength, sizeof(Spec), Piece);
+                    }
+                }
+            }
+            
+            while(*At && strchr("hlLqjzt", *At))
+            {
+                ++At;
+            }
+            
+            char Conversion = *At;
+            if(!Conversion)
+            {
+                break;
+            }
+            ++At;
+            
+            size_t Left = BufferSize - Used;
+            s32 Written = -1;
+            char Code = lc_ReadArg(&Reader, &Value, &String, &StringLength);
+            switch(Conversion)
+            {
+                case 'd': case 'i':
+                {
+                    if(Code == 'i' || Code == 'u')
+                    {
+                        char Length[] = {'l', 'l', Conversion, 0};
+                        lc_AppendSpec(Spec, &SpecLength, sizeof(Spec), Length);
+                        Written = snprintf(Buffer + Used, Left, Spec, (long long)Value);
+                    }
+                } break;
+                
+                case 'o': case 'u': case 'x': case 'X':
+                {
+                    if(Code == 'i' || Code == 'u')
+                    {
+                        char Length[] = {'l', 'l', Conversion, 0};
+                        lc_AppendSpec(Spec, &SpecLength, sizeof(Spec), Length);
+                        Written = snprintf(Buffer + Used, Left, Spec, (unsigned long long)Value);
+                    }
+                } break;
+                
+                case 'c':
+                {
+                    if(Code == 'i' || Code == 'u')
+                    {
+                        lc_AppendSpec(Spec, &SpecLength, sizeof(Spec), "c");
+                        Written = snprintf(Buffer + Used, Left, Spec, (int)Value);
+                    }
+                } break;
+                
+                case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                {
+                    if(Code == 'f')
+                    {
+                        r64 Number;
+                        memcpy(&Number, &Value, sizeof(r64));
+                        Piece[0] = Conversion;
+                        lc_AppendSpec(Spec, &SpecLength, sizeof(Spec), Piece);
+                        Written = snprintf(Buffer + Used, Left, Spec, Number);
+                    }
+                } break;
+                
+                case 's':
+                {
+                    if(Code == 's')
+                    {
+                        // NOTE(amos): The string isn't null terminated, so its length goes in as the precision,
+                        // unless the format asked for less.
+                        char const *Precision = strchr(Spec, '.');
+                        if(Precision)
+                        {
+                            u32 MaxLength = (u32)atoi(Precision + 1);
+                            StringLength = MaxLength < StringLength ? MaxLength : StringLength;
+                            SpecLength = (u32)(Precision - Spec);
+                            Spec[SpecLength] = '\0';
+                        }
+                        lc_AppendSpec(Spec, &SpecLength, sizeof(Spec), ".*s");
+                        Written = snprintf(Buffer + Used, Left, Spec, (int)StringLength, String);
+                    }
+                } break;
+                
+                case 'p':
+                {
+                    if(Code == 'p' || Code == 'u' || Code == 'i')
+                    {
+                        lc_AppendSpec(Spec, &SpecLength, sizeof(Spec), "p");
+                        Written = snprintf(Buffer + Used, Left, Spec, (void*)(uintptr_t)Value);
+                    }
+                } break;
+                
+                case 'n':
+                {
+                    Written = 0;
+                } break;
+            }
+            
+            if(Written < 0)
+            {
+                Written = snprintf(Buffer + Used, Left, "<?>");
+            }
+            Used += ((size_t)Written < Left) ? (size_t)Written : Left - 1;
+        }
+    }
+    Buffer[Used] = '\0';
+} // lc_FormatDeferred
+
 void
 lc_PrintMessage(lc_thread *Thread, zsock_t *Socket, zmsg_t *LogMsg)
 {
@@ -242,22 +583,68 @@ lc_PrintMessage(lc_thread *Thread, zsock_t *Socket, zmsg_t *LogMsg)
     }
     if(Name)
     {
-        lc_message Message = {};
-        Message.LogLevel = zmsg_popstr(LogMsg);
-        zframe_t *EpochFrame = zmsg_pop(LogMsg);
-        if(zframe_size(EpochFrame) == sizeof(u64))
+        // NOTE(amos): Text messages have 4 frames, deferred messages 3, and formats for deferred messages 5.
+        size_t FrameCount = zmsg_size(LogMsg);
+        if(FrameCount == 5)
         {
-            Message.Timestamp = *((u64*)zframe_data(EpochFrame));
+            lc_AddFormat(Current, LogMsg);
+        }
+        else
+        {
+            lc_message Message = {};
+            Message.LogLevel = zmsg_popstr(LogMsg);
+            zframe_t *EpochFrame = zmsg_pop(LogMsg);
+            if(zframe_size(EpochFrame) == sizeof(u64))
+            {
+                Message.Timestamp = *((u64*)zframe_data(EpochFrame));
+            }
+            zframe_destroy(&EpochFrame);
+            
+            if(FrameCount == 3)
+            {
+                char Text[LC_MESSAGE_SIZE];
+                char UnknownFile[] = "?";
+                zframe_t *Record = zmsg_pop(LogMsg);
+                size_t RecordSize = zframe_size(Record);
+                u8 const *RecordData = zframe_data(Record);
+                
+                u32 Id = LC_MAX_FORMATS;
+                if(RecordSize >= sizeof(u32))
+                {
+                    memcpy(&Id, RecordData, sizeof(u32));
+                }
+                
+                lc_format *Format = (Id < Current->FormatCount) ? Current->Formats + Id : 0;
+                if(Format && Format->Format)
+                {
+                    lc_FormatDeferred(Format->Format, Format->ArgTypes, RecordData + sizeof(u32), RecordSize - sizeof(u32),
+                                      Text, sizeof(Text));
+                    Message.File = Format->File;
+                }
+                else
+                {
+                    snprintf(Text, sizeof(Text), "<deferred message %u, format not received>", Id);
+                    Message.File = UnknownFile;
+                }
+                Message.Message = Text;
+                
+                Thread->LogFunction(&Message, Name, Thread->isPause, Thread->isQuiet, Thread->FilePointer);
+                
+                zframe_destroy(&Record);
+            }
+            else
+            {
+                Message.File = zmsg_popstr(LogMsg);
+                Message.Message = zmsg_popstr(LogMsg);
+                
+                Thread->LogFunction(&Message, Name, Thread->isPause, Thread->isQuiet, Thread->FilePointer);
+                
+                free(Message.File);
+                free(Message.Message);
+            }
+            
+            free(Message.LogLevel);
         }
-        zframe_destroy(&EpochFrame);
-        Message.File = zmsg_popstr(LogMsg);
-        Message.Message = zmsg_popstr(LogMsg);
-        
-        Thread->LogFunction(&Message, Name, Thread->isPause, Thread->isQuiet, Thread->FilePointer);
-        
-        free(Message.LogLevel);
-        free(Message.File);
-        free(Message.Message);
     }
     else
     {
@@ -343,6 +730,8 @@ lc_ActorThread(zsock_t *Pipe, void *Args)
                             }
                             
                             NewEndpoint->Name = Name;
+                            NewEndpoint->Formats = 0;
+                            NewEndpoint->FormatCount = 0;
                             NewEndpoint->Index = Data->LastIndex++;
                             NewEndpoint->Socket = NewSocket;
                             
@@ -10,7 +10,188 @@ The use case for this library fits with the two methods of memory used in my pro
 - An initial block of memory that is initialized during setup, and not added to afterwards.
 - Scratch memory that is wiped out at the beginning of each control loop.
 
-At this time, there isn't really functionality for freeing and re-using memory. It's generally not necessary in the use cases I current have, though if this changes that functionality will be added.
+Arenas don't free single allocations; memory comes back all at once, with `mem_ResetMemory()` or `mem_EndTemporaryMemory()`, and `mem_PopSize()` gives back the last push. Where memory does need to be freed and re-used, build one of these on top of an arena:
+- `memory_pool`, for many objects of one size. See @ref mem_PushPool().
+- @ref ab_slab.h, for small objects of many sizes.
+- @ref ab_heap.h, a general purpose allocator with free and realloc.
+
+An arena created with `mem_InitMemory()` is fixed in size; a push that doesn't fit returns 0 (and traps in debug builds). An arena created with `mem_InitGrowableMemory()` will instead chain a new block from the OS when the current one fills, with each new block twice the size of the last. Blocks added this way are returned to the OS by `mem_EndTemporaryMemory()` and `mem_ResetMemory()`, so the arena only holds on to the extra memory while it is actually in use.
+
+~~~c
+void *OsMemory = mem_AllocateOsMemory(NULL, Kilobytes(64));
+memory_arena ScratchMemory = mem_InitGrowableMemory(OsMemory, Kilobytes(64), Kilobytes(64));
+
+// Any pushes past the first 64kb spill into new blocks of 64kb, 128kb, 256kb, ...
+u8 *Buffer = mem_PushArray(&ScratchMemory, Megabytes(1), u8);
+
+// Frees the spilled blocks, leaving the original 64kb.
+mem_ResetMemory(&ScratchMemory);
+~~~
+
+An arena created with `mem_InitReservedMemory()` reserves a large range of address space up front, but only commits pages as `Used` moves forward. Pointers never move, and the arena can be sized for the worst case without paying for memory that is never touched. Pass `true` to `mem_ResetMemory()` to also hand the committed pages back to the OS, such as after a one-off spike.
+
+~~~c
+memory_arena ScratchMemory = mem_InitReservedMemory(Gigabytes(8));
+
+while(isRunning)
+{
+    // Keep the pages committed from frame to frame, unless the last frame was unusually large.
+    mem_ResetMemory(&ScratchMemory, ScratchMemory.Committed > Megabytes(64));
+    // ...
+}
+
+mem_ReleaseReservedMemory(&ScratchMemory);
+~~~
+
+The basic push functions pack allocations tightly, with no padding. Use the `Aligned` versions when data needs a particular alignment, such as `alignof(Type)`, 16/32 bytes for SIMD, `MEM_CACHE_LINE_SIZE` to keep data used by different threads from sharing a cache line, or `mem_GetPageSize()`.
+
+~~~c
+u8 *Flags = mem_PushArray(&MainMemory, 3, u8);
+r64 *Samples = mem_PushArrayAligned(&MainMemory, 1024, r64, 32);
+worker_data *Worker = mem_PushStructAligned(&MainMemory, worker_data, MEM_CACHE_LINE_SIZE);
+
+// Each worker arena starts on its own cache line, and doesn't share its last line with anything else.
+memory_arena WorkerMemory = mem_CreateSubArena(&MainMemory, Kilobytes(50), MEM_CACHE_LINE_SIZE);
+~~~
+
+The push functions clear memory to 0 using wide stores, switching to non-temporal stores for very large pushes so they don't flush the cache. Each arena also tracks how far into it has ever been written (`Dirty`). Memory past that point is known to still be 0, so it isn't cleared again. Blocks and pages the arena gets from the OS itself start out clean; for memory passed in to `mem_InitMemory()`, pass `isZeroed` as true if it came straight from `mem_AllocateOsMemory()`.
+
+Large, long-lived blocks can ask `mem_AllocateOsMemory()` for huge pages to cut down on TLB misses. On Linux this tries explicit huge pages (`MAP_HUGETLB`) first, which need to be set aside by the system administrator, and falls back to transparent huge pages. The flags actually applied are reported back.
+
+~~~c
+u32 AppliedFlags = 0;
+void *TableMemory = mem_AllocateOsMemory(NULL, Megabytes(512), MEM_HugePages, &AppliedFlags);
+if(!(AppliedFlags & (MEM_HugePages | MEM_TransparentHugePages)))
+{
+    printf("Lookup tables are using regular pages.\n");
+}
+~~~
+
+Memory is normally only given pages by the OS the first time it's touched, which means page faults in the middle of a control loop. For real-time loops, ask for the memory to be pre-faulted and locked in RAM up front. `mem_PrefaultMemory()` does the same for an arena that already exists, committing it first if it's reserved, and `mem_GetResidentPageCount()` reports how much of a range is actually in RAM.
+
+~~~c
+u32 AppliedFlags = 0;
+void *OsMemory = mem_AllocateOsMemory(NULL, MemorySize, MEM_Prefault | MEM_Lock, &AppliedFlags);
+if(!(AppliedFlags & MEM_Lock))
+{
+    printf("Unable to lock memory, check ulimit -l.\n");
+}
+
+memory_arena ScratchMemory = mem_InitReservedMemory(Gigabytes(1));
+mem_PrefaultMemory(&ScratchMemory, Megabytes(16), true);
+~~~
+
+On machines with more than one NUMA node, memory can be placed on a particular node. `mem_InitNumaArenas()` creates one arena per node, so each worker thread can use memory local to the CPU it runs on. On machines without NUMA, there is a single node and everything works the same.
+
+~~~c
+memory_numa_arenas NumaArenas = {};
+mem_InitNumaArenas(&NumaArenas, Megabytes(256));
+
+// In each worker thread, after it has been pinned to a CPU.
+memory_arena WorkerMemory = mem_CreateSubArena(mem_GetLocalNumaArena(&NumaArenas), Megabytes(16), MEM_CACHE_LINE_SIZE);
+~~~
+
+Functions that need some temporary memory can get it from a per-thread scratch arena, rather than being handed a `memory_arena` or falling back to malloc. Each thread has `MEM_SCRATCH_ARENA_COUNT` scratch arenas, which are reserved the first time they're used. Pass in any arena the caller gave you, and you'll get a scratch arena that isn't one of them; otherwise the scratch memory could wipe out the results you're building for the caller. In C++, `scratch_memory` releases the scratch memory when it goes out of scope.
+
+~~~c
+char *
+BuildLabel(memory_arena *ResultMemory, char const *Name)
+{
+    scratch_memory Scratch(ResultMemory);
+    char *Buffer = mem_PushArray(Scratch.Arena, 1024, char);
+    // ... build the label in Buffer, then copy the final result into ResultMemory.
+    
+    return Label;
+}
+~~~
+
+For many threads allocating from one block at once, use a `concurrent_arena`. Threads push with an atomic add on the shared offset. To keep them from fighting over that cache line, each thread can hand out memory from its own `concurrent_chunk`, only going back to the shared arena when the chunk runs out. `mem_ResetConcurrentArena()` clears the arena between frames, and any chunk handed out before the reset is dropped the next time it's used.
+
+~~~c
+concurrent_arena FrameMemory;
+mem_InitConcurrentArena(&FrameMemory, OsMemory, Megabytes(64), Kilobytes(64));
+
+// In each worker thread.
+concurrent_chunk Chunk = {};
+while(isRunning)
+{
+    frame_item *Item = mem_PushConcurrentStruct(&FrameMemory, &Chunk, frame_item);
+    // ...
+}
+
+// On the main thread, once all the workers are done with the frame.
+mem_ResetConcurrentArena(&FrameMemory);
+~~~
+
+To recycle objects of one type, such as connections or messages, push a `memory_pool` to an arena. Items are allocated and freed in constant time, with freed items kept on a free list inside the items themselves. The pool is safe to use from more than one thread. Threads that allocate and free a lot can keep a `memory_pool_cache`, which moves items to and from the pool in batches.
+
+~~~c
+memory_pool *ConnectionPool = mem_PushPool(&MainMemory, connection, 256);
+
+connection *Connection = mem_PoolAllocStruct(ConnectionPool, connection);
+// ...
+mem_PoolFree(ConnectionPool, Connection);
+
+// In a worker thread.
+memory_pool_cache Cache = mem_InitPoolCache(ConnectionPool);
+connection *Local = (connection*)mem_PoolAllocCached(&Cache);
+mem_PoolFreeCached(&Cache, Local);
+mem_FlushPoolCache(&Cache);
+~~~
+
+For arrays whose final size isn't known up front, `mem_InitVirtualArray()` reserves a separate range of address space for each array and commits pages as it grows. Elements never move, several arrays can be built at once, and the arena they're built alongside can still be used in the meantime.
+
+~~~c
+memory_virtual_array Visible = mem_InitVirtualArray(1000000, entity_id);
+memory_virtual_array Culled = mem_InitVirtualArray(1000000, entity_id);
+for(...)
+{
+    *mem_PushVirtualArray(isVisible ? &Visible : &Culled, 1, entity_id) = Id;
+}
+~~~
+
+Memory that takes a long time to build, such as lookup tables, can be kept in a file between runs with `mem_OpenFileMemory()`. The arena is mapped straight from the file, so a warm restart maps the saved arena back in rather than rebuilding it.
+
+Separate processes on the same machine can share an arena with `mem_OpenSharedArena()`. It's mapped from named shared memory, and each process can push to it, so data can be handed between processes without copying it through a socket.
+
+For streams of variable-length records, `memory_ring` is a ring buffer with its memory mapped twice in a row. A record that wraps past the end of the buffer is still contiguous, so it can be written and parsed in place.
+
+To size arenas from real numbers, build with `MEM_INSTRUMENT` defined as 1 in every file. Each push then records the file and line it came from, along with the size and the arena. Each arena's peak use is tracked across resets, along with how much every `temporary_memory` scope frees. `mem_PrintMemoryReport()` prints a sorted summary, and `mem_WriteMemoryReportJson()` writes everything as JSON. In a normal build these functions do nothing, and pushes cost exactly what they did before.
+
+~~~c
+mem_SetArenaName(&ScratchMemory, "Scratch");
+...
+if(isDumpRequested)
+{
+    mem_PrintMemoryReport(stdout);
+}
+~~~
+
+Often results from one frame are needed in the next, such as the previous control output. Rather than copying them out of `VolatileMemory` every cycle, use a `memory_frame_arenas` pair. Each frame pushes to one arena while the previous frame's arena is left alone, so its pointers stay valid for one more frame. Each arena is reset as it becomes current again. A consumer thread can also read the previous frame while the next is filled: the producer publishes a root pointer with `mem_PublishFrame()`, and the consumer picks up the latest frame with `mem_BeginFrameRead()` without ever waiting.
+
+~~~c
+memory_frame_arenas Frames;
+mem_InitFrameArenas(&Frames, OsMemory, Megabytes(2), true);
+
+while(isRunning)
+{
+    memory_arena *FrameMemory = mem_BeginFrame(&Frames);
+    control_state *State = mem_PushStruct(FrameMemory, control_state);
+    UpdateControl(State, LastState);
+    LastState = State; // Still valid next frame.
+    mem_PublishFrame(&Frames, State);
+}
+
+// On the consumer thread:
+control_state *State = (control_state*)mem_BeginFrameRead(&Frames);
+if(State)
+{
+    SendStatus(State);
+    mem_EndFrameRead(&Frames);
+}
+~~~
+
+Large, long-lived arenas can be checkpointed to a file with `mem_WriteCheckpoint()`, and rebuilt with `mem_RestoreCheckpoint()`. After the first full checkpoint, each one only appends the pages written to since the last, so checkpoints of a multi-gigabyte arena that mostly sits still are small and quick. Changed pages are found with the soft-dirty bits Linux keeps for each page, or by comparing a hash of each page where those aren't available.
 
 This is a single-file library. You may include it as a header just as any other. Add the following define to include the source *once* per project:
 
@@ -68,14 +249,77 @@ See also:
 #if !defined(MEM_MEMORY_H)
 #define MEM_MEMORY_H
 
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+
 #include "ab_common.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define MEM_SSE2 1
+#endif
+
+/** @brief Maximum number of times a growable arena doubles its block size. **/
+#define MEM_MAX_BLOCK_GROWTH 10
+
+/** @brief Reserved arenas commit memory in multiples of this, to keep the number of OS calls down. **/
+#define MEM_COMMIT_GRANULARITY Kilobytes(64)
+
+/** @brief Alignment that keeps data on its own cache line. **/
+#define MEM_CACHE_LINE_SIZE 64
+
+/** @brief Maximum number of NUMA nodes `mem_InitNumaArenas()` creates arenas for. **/
+#define MEM_MAX_NUMA_NODES 8
+
+/** @brief Use for the NUMA node when the memory may come from any node. **/
+#define MEM_NUMA_ANY -1
+
+/** @brief Clears at least this large use non-temporal stores, which bypass the cache. **/
+#define MEM_NONTEMPORAL_THRESHOLD Megabytes(1)
+
 /** @private **/
 struct memory_arena
 {
 	void *Start;
 	size_t Size;
 	size_t Used;
+    
+    // NOTE(amos): Only used by growable arenas. Zero for fixed arenas.
+    size_t MinimumBlockSize;
+    u32 BlockCount;
+    
+    // NOTE(amos): Memory past Committed is reserved but not yet usable. Equal to Size unless the arena is reserved.
+    size_t Committed;
+    b8 isReserved;
+    // NOTE(amos): Bumped each time pages are handed back to the OS, so checkpoints know pages went back to 0 without
+    // being written.
+    u32 DecommitCount;
+    
+    // NOTE(amos): Memory past Dirty has never been written, and is known to be 0.
+    size_t Dirty;
+};
+
+/** @brief One `memory_arena` for each NUMA node. See @ref mem_InitNumaArenas(). **/
+struct memory_numa_arenas
+{
+    memory_arena Arenas[MEM_MAX_NUMA_NODES];
+    size_t SizePerNode;
+    u32 NodeCount;
+};
+
+/** @private 
+
+Stored at the start of each block a growable arena gets from the OS, so the arena can step back to the previous block.
+**/
+struct memory_block_header
+{
+    void *PrevStart;
+    size_t PrevSize;
+    size_t PrevUsed;
+    size_t PrevCommitted;
+    size_t PrevDirty;
+    size_t BlockSize;
 };
 
 /** @private **/
@@ -83,6 +327,7 @@ struct temporary_memory
 {
 	memory_arena* Arena;
 	size_t Used;
+    u32 BlockCount;
 };
 
 /** @private **/
@@ -94,13 +339,38 @@ struct memory_array
     u32 MaxElementCount;
 };
 
+/** @brief Options for `mem_AllocateOsMemory()`.
+
+These flags may be or'd together for input. The same flags are used to report which options were actually applied.
+**/
+enum memory_flags
+{
+    /** @brief No flag. **/
+    MEM_Null = 0,
+    /** @brief Back the memory with 2MB huge pages. Size must be a multiple of 2MB. Falls back to transparent huge pages if none are available. **/
+    MEM_HugePages = 1 << 0,
+    /** @brief Back the memory with 1GB huge pages. Size must be a multiple of 1GB. Falls back to 2MB huge pages, then transparent huge pages. **/
+    MEM_HugePages1GB = 1 << 1,
+    /** @brief Reported only. The memory was marked for transparent huge pages, which the OS applies when it can. **/
+    MEM_TransparentHugePages = 1 << 2,
+    /** @brief Fault in every page when the memory is allocated, rather than on first touch. **/
+    MEM_Prefault = 1 << 3,
+    /** @brief Lock the memory in RAM so it's never paged out. This also faults in every page. Subject to the OS limit on locked memory. **/
+    MEM_Lock = 1 << 4,
+    /** @brief Reported only. The memory was placed on the requested NUMA node. **/
+    MEM_NumaNode = 1 << 5,
+};
+
 /** @brief Get memory from the OS. 
 
 @param Address The start address of the memory. Generally used for debugging.
 @param Size Amount of memory you want from the OS.
+@param Flags Options from @ref memory_flags, or'd together.
+@param[out] AppliedFlags If not 0, set to the @ref memory_flags that were actually applied.
+@param NumaNode The NUMA node the memory should come from, or `MEM_NUMA_ANY`. The node is preferred, not required; if it runs out of memory, the OS uses another node.
 @return A void* pointer to the start of the memory; 0 if memory allocation failed.
 **/
-void *mem_AllocateOsMemory(void *Address, size_t Size);
+void *mem_AllocateOsMemory(void *Address, size_t Size, u32 Flags = MEM_Null, u32 *AppliedFlags = 0, s32 NumaNode = MEM_NUMA_ANY);
 
 /** @brief Return memory to the OS.
 
@@ -109,9 +379,174 @@ void *mem_AllocateOsMemory(void *Address, size_t Size);
                                           **/
 void mem_DeallocateOsMemory(void *Address, size_t Size);
 
+/** @brief Reserve address space from the OS, without committing any memory to it.
+
+The memory may not be used until it is committed with `mem_CommitOsMemory()`. Return it to the OS with `mem_DeallocateOsMemory()`.
+
+@param Address The start address of the memory. Generally used for debugging.
+@param Size Amount of address space to reserve.
+@return A void* pointer to the start of the reserved range; 0 if the reservation failed.
+**/
+void *mem_ReserveOsMemory(void *Address, size_t Size);
+
+/** @brief Commit part of a range reserved with `mem_ReserveOsMemory()`, so it can be read and written.
+
+@param Address Page-aligned start of the memory to commit.
+@param Size Amount of memory to commit.
+@return True if the memory was committed.
+**/
+b8 mem_CommitOsMemory(void *Address, size_t Size);
+
+/** @brief Return committed memory to the OS, while keeping the address range reserved.
+
+The memory may not be used until it is committed again, at which point it reads as 0.
+
+@param Address Page-aligned start of the memory to decommit.
+@param Size Amount of memory to decommit.
+**/
+void mem_DecommitOsMemory(void *Address, size_t Size);
+
+/** @brief Get the OS page size. **/
+size_t mem_GetPageSize();
+
+/** @brief Touch every page in a range of memory, so the OS maps it in now rather than on first use.
+
+The contents of the memory are not changed.
+
+@param Address Start of the memory.
+@param Size Amount of memory to pre-fault.
+**/
+void mem_PrefaultOsMemory(void *Address, size_t Size);
+
+/** @brief Lock a range of memory in RAM, so it's never paged out.
+
+@param Address Start of the memory. Rounded down to the start of the page.
+@param Size Amount of memory to lock.
+@return True if the memory was locked.
+**/
+b8 mem_LockOsMemory(void *Address, size_t Size);
+
+/** @brief Unlock memory locked with `mem_LockOsMemory()`.
+
+@param Address Start of the memory.
+@param Size Amount of memory to unlock.
+**/
+void mem_UnlockOsMemory(void *Address, size_t Size);
+
+/** @brief Get the number of pages in a range of memory currently in RAM.
+
+@param Address Start of the memory. Rounded down to the start of the page.
+@param Size Size of the memory range.
+@return The number of resident pages, out of every page the range touches.
+**/
+size_t mem_GetResidentPageCount(void *Address, size_t Size);
+
+/** @brief Get the highest NUMA node number on the machine. 0 if the machine doesn't have NUMA.
+
+This is not the number of nodes: node numbers can have gaps, so there may be fewer nodes than this plus one.
+**/
+u32 mem_GetNumaMaxNode();
+
+/** @brief Get the NUMA node of the CPU the calling thread is running on. **/
+u32 mem_GetCurrentNumaNode();
+
+/** @brief Map a file into memory, shared with the file, creating the file if needed.
+
+Changes to the memory are written back to the file by the OS. The file is grown to `Size` if it's smaller.
+
+@param Path Path to the file.
+@param Size Number of bytes of the file to map.
+@param Address If not 0, the memory must be mapped at exactly this address. Fails if the address isn't free.
+@param[out] isNewOut If not 0, set to true if the file was empty before being mapped, so the memory is all 0.
+@return A pointer to the start of the mapped file; 0 if it couldn't be opened or mapped.
+**/
+void *mem_MapOsFile(char const *Path, size_t Size, void *Address = 0, b8 *isNewOut = 0);
+
+/** @brief Unmap a file mapped with `mem_MapOsFile()`. **/
+void mem_UnmapOsFile(void *Address, size_t Size);
+
+/** @brief Write changes to a mapped file out to disk, and wait for them to finish.
+
+@return True if the changes were written.
+**/
+b8 mem_SyncOsFile(void *Address, size_t Size);
+
+/** @brief Map a named block of shared memory, creating it if it doesn't exist yet.
+
+Any process that maps the same name sees the same memory. New memory is all 0.
+
+@param Name Name of the shared memory. On Linux, this must start with a '/', such as "/control_shared".
+@param Size Size of the memory.
+@param[out] isCreatedOut If not 0, set to true if this call created the memory.
+@param TimeoutMs How long to wait for the process that created the memory to set its size. Only reached if that process died before it could.
+@return A pointer to the start of the memory; 0 if it couldn't be created or mapped, or it already exists and is smaller than `Size`.
+**/
+void *mem_MapSharedOsMemory(char const *Name, size_t Size, b8 *isCreatedOut = 0, u32 TimeoutMs = 1000);
+
+/** @brief Unmap shared memory mapped with `mem_MapSharedOsMemory()`. **/
+void mem_UnmapSharedOsMemory(void *Address, size_t Size);
+
+/** @brief Remove the name of a block of shared memory, so the next `mem_MapSharedOsMemory()` creates a new one. Processes that already have it mapped keep it. Does nothing on Windows, where the memory goes away once every process has unmapped it. **/
+void mem_RemoveSharedOsMemory(char const *Name);
+
+/** @brief Give the rest of the calling thread's time slice to another thread. **/
+void mem_YieldOsThread();
+
+/** @brief Get the time in milliseconds from a clock that only moves forward. Only useful for measuring time between two calls. **/
+u64 mem_GetOsMilliseconds();
+
+/** @brief Get memory from the OS that is mapped twice in a row, so `Address[Index]` and `Address[Index + Size]` are the same byte.
+
+@param Size Size of the memory. Must be a multiple of `MEM_COMMIT_GRANULARITY`.
+@return A pointer to the first mapping, with the second right after it; 0 if it couldn't be mapped.
+**/
+void *mem_AllocateDoubleMappedOsMemory(size_t Size);
+
+/** @brief Return memory from `mem_AllocateDoubleMappedOsMemory()` to the OS. **/
+void mem_DeallocateDoubleMappedOsMemory(void *Address, size_t Size);
+
+/** @brief Clear the soft-dirty bit of every page in the process, so later writes can be found with `mem_GetOsSoftDirtyPages()`.
+
+Linux only. This affects the whole process, so anything else using soft-dirty bits loses track of its writes.
+
+@return True if the bits were cleared. False on Windows, or if `/proc/self/clear_refs` can't be written.
+**/
+b8 mem_ClearOsSoftDirty();
+
+/** @brief Find which pages have been written to since `mem_ClearOsSoftDirty()`.
+
+@param Address Start of the memory. Must be aligned to `MEM_CHECKPOINT_PAGE_SIZE`.
+@param PageCount Number of pages to check, each `MEM_CHECKPOINT_PAGE_SIZE` bytes.
+@param[out] DirtyOut One byte per page, set to 1 if the page was written to and 0 if not.
+@return True if the pages were checked. False on Windows, if `/proc/self/pagemap` can't be read, or if the OS page size isn't `MEM_CHECKPOINT_PAGE_SIZE`.
+**/
+b8 mem_GetOsSoftDirtyPages(void *Address, size_t PageCount, u8 *DirtyOut);
+
+/** @brief Write a stdio file's buffered data out to disk, and wait for it to finish.
+
+@return True if the data was written.
+**/
+b8 mem_SyncOsFileStream(FILE *File);
+
+/** @brief Rename a file, replacing any file already at the new path.
+
+On the same file system the replacement is atomic: anything opening `To` sees either the old file or the new one.
+
+@return True if the file was renamed.
+**/
+b8 mem_ReplaceOsFile(char const *From, char const *To);
+
+/** @brief Move a stdio file's position forward or back, by more than 2GB if need be.
+
+@param File The file.
+@param Offset Bytes to move from the current position; negative to move back.
+@return True if the position was moved. Moving past the end of the file succeeds; the next read fails.
+**/
+b8 mem_SeekOsFileStream(FILE *File, s64 Offset);
+
 /** @brief Get memory for the type or struct and return a pointer to the struct type.
 
-This will clear the memory to 0.
+This will clear the memory to 0. For all the push functions, a fixed arena returns 0 if there isn't enough memory left; a growable arena gets a new block from the OS, and only returns 0 if that fails.
 
 @param Arena A pointer to the memory arena.
 @param Type The struct type to allocate.
@@ -140,16 +575,105 @@ This will clear the memory to 0.
 **/
 #define mem_PushArray(Arena, Count, Type) (Type*)mem_PushSize_(Arena, (Count)*sizeof(Type))
 
+/** @brief Same as `mem_PushStruct()`, with the struct aligned in memory.
+
+@param Arena A pointer to the memory arena.
+@param Type The struct type to allocate.
+@param Alignment Alignment of the struct in bytes. Must be a power of 2, such as `alignof(Type)`, `MEM_CACHE_LINE_SIZE` or `mem_GetPageSize()`.
+@return A pointer to the struct type.
+**/
+#define mem_PushStructAligned(Arena, Type, Alignment) (Type*)mem_PushSize_(Arena, sizeof(Type), true, Alignment)
+
+/** @brief Same as `mem_PushSize()`, with the memory aligned.
+
+@param Arena A pointer to the memory_arena.
+@param Size `size_t` amount of memory to create.
+@param Alignment Alignment of the memory in bytes. Must be a power of 2.
+@return 'void*` pointer to the start of the memory.
+**/
+#define mem_PushSizeAligned(Arena, Size, Alignment) mem_PushSize_(Arena, Size, true, Alignment)
+
+/** @brief Same as `mem_PushArray()`, with the first element aligned.
+
+@param Arena A pointer to a `memory_arena` to hold the array.
+@param Count Number of array elements to allocate.
+@param Type The type of array to allocate. Can be any type.
+@param Alignment Alignment of the first element in bytes. Must be a power of 2.
+@return A pointer to the first element in the array.
+**/
+#define mem_PushArrayAligned(Arena, Count, Type, Alignment) (Type*)mem_PushSize_(Arena, (Count)*sizeof(Type), true, Alignment)
+
 
 /** @brief Begin an array of unknown size.
 
 This will set the start of an array of unknown size, with a maximum allowed element count.
 This must be ended by a mem_EndArray() call. Do not use any other memory functions between this and the end call.
+
+On a reserved arena, the array only gets the memory that's already committed, or `MEM_COMMIT_GRANULARITY` if less is committed, so it doesn't commit the whole reservation. Use mem_BeginArrayMax() for larger arrays.
 **/
 #define mem_BeginArray(Arena, Type, MemoryArrayPtrOut) (Type*)mem_BeginArray_(Arena, sizeof(Type), MemoryArrayPtrOut);
 
+/** @brief Begin an array of unknown size, with at most `MaxElementCount` elements.
+
+Same as mem_BeginArray(), but only takes room for `MaxElementCount` elements, or what's left in the arena if that's less. On a reserved arena, only that much is committed.
+**/
+#define mem_BeginArrayMax(Arena, Type, MaxElementCount, MemoryArrayPtrOut) (Type*)mem_BeginArray_(Arena, sizeof(Type), MemoryArrayPtrOut, MaxElementCount)
+
+#ifndef MEM_INSTRUMENT
+/** @brief Define as 1 to record every push for @ref mem_PrintMemoryReport(). Must be the same in every file of a project. **/
+#define MEM_INSTRUMENT 0
+#endif
+
+#if MEM_INSTRUMENT
+// NOTE(amos): Default arguments are evaluated at the call site, so these pick up the file and line of the push.
+/** @private **/
+#define MEM_LOCATION_PARAMS , char const *File = __builtin_FILE(), u32 Line = __builtin_LINE()
+/** @private **/
+#define MEM_LOCATION_ARGS , char const *File, u32 Line
+/** @private **/
+#define MEM_LOCATION , File, Line
+/** @private **/
+#define MEM_NO_LOCATION , 0, 0
+#else
+#define MEM_LOCATION_PARAMS
+#define MEM_LOCATION_ARGS
+#define MEM_LOCATION
+#define MEM_NO_LOCATION
+#endif
+
 /** @private */
-void *mem_PushSize_(memory_arena *Memory, size_t Size, b8 ClearMemory = true);
+void *mem_PushSize_(memory_arena *Memory, size_t Size, b8 ClearMemory = true, size_t Alignment = 1 MEM_LOCATION_PARAMS);
+
+/** @brief Get the number of bytes of padding the next push needs to be aligned.
+
+@param Memory The `memory_arena` to check.
+@param Alignment The alignment in bytes. Must be a power of 2.
+@return Number of bytes from the current position to the next aligned address.
+**/
+inline size_t
+mem_GetAlignmentOffset(memory_arena *Memory, size_t Alignment)
+{
+    Assert(Alignment && !(Alignment & (Alignment - 1)));
+    
+    size_t Result = 0;
+    size_t Address = (size_t)(((u8*)Memory->Start) + Memory->Used);
+    size_t AlignmentMask = Alignment - 1;
+    if(Address & AlignmentMask)
+    {
+        Result = Alignment - (Address & AlignmentMask);
+    }
+    
+    return Result;
+}
+
+/** @brief Clear memory to 0.
+
+Uses 16-byte stores where SSE2 is available, and non-temporal stores for clears of `MEM_NONTEMPORAL_THRESHOLD` or more.
+
+@param Address Start of the memory to clear.
+@param Size Amount of memory to clear.
+**/
+void mem_ZeroSize(void *Address, size_t Size);
 
 /** @brief Initialize a memory_arena.
 
@@ -158,183 +682,2841 @@ of one.
 
 @param Start The start of the memory block.
 @param Size The size of the memory arena.
+@param isZeroed True if the memory is known to be all 0, such as fresh from `mem_AllocateOsMemory()`. The arena then skips clearing it on the first use.
 @return A new memory_arena.
 **/
-memory_arena mem_InitMemory(void *Start, size_t Size);
+memory_arena mem_InitMemory(void *Start, size_t Size, b8 isZeroed = false);
 
-/** @brief Delete everything in a `memory_arena` and set the amount of memory used to 0. 
+/** @brief Initialize a growable memory_arena.
 
-This is used to wipe out everything in a memory arena. This is usually used at the beginning of a control
-loop to clear the volatile memory.
+The same as `mem_InitMemory()`, except that when the arena is full it gets a new block from the OS rather than failing. The first new block is `MinimumBlockSize`, and each one after is double the last, up to `MEM_MAX_BLOCK_GROWTH` doublings. A single push larger than that gets a block of its own.
 
-@param Memory The `memory_arena` to wipe.
+The initial block is owned by the caller and is never returned to the OS by the arena. `Start` may be 0 with a `Size` of 0, in which case all memory comes from new blocks.
+
+@param Start The start of the initial memory block.
+@param Size The size of the initial memory block.
+@param MinimumBlockSize The size of the first block to get from the OS when the arena fills.
+@param isZeroed True if the initial memory block is known to be all 0.
+@return A new memory_arena.
 **/
-void mem_ResetMemory(memory_arena *Memory);
+memory_arena mem_InitGrowableMemory(void *Start, size_t Size, size_t MinimumBlockSize, b8 isZeroed = false);
 
-/** @brief Get the amount of memory left in an arena.
+/** @brief Reserve address space from the OS and create a memory_arena in it.
 
-@param Memory A pointer to the `memory_arena` to check.
-@return The amount of unused memory in the arena.
-**/
-inline size_t mem_GetMemoryLeft(memory_arena *Memory);
+The arena commits memory as it's used, in chunks of `MEM_COMMIT_GRANULARITY`. The arena cannot grow past `ReserveSize`, but since reserving address space is cheap this can be much larger than the arena is ever expected to need. Release the memory with `mem_ReleaseReservedMemory()`.
 
-/** @brief Indicates the next section of memory is scratch, and will be cleared quickly.
+@param ReserveSize The amount of address space to reserve.
+@return A new memory_arena. `Start` is 0 if the address space couldn't be reserved.
+**/
+memory_arena mem_InitReservedMemory(size_t ReserveSize);
 
-This must be paired with `mem_EndTemporaryMemory()`. Memory used between `mem_BeginTemporyMemory()` and 
-`mem_EndTemporaryMemory()` will be wiped. This is generally used for brief scratch memory that's needed within 
-a single function, but is not otherwise needed.
+/** @brief Return all memory, committed and reserved, from an arena created with `mem_InitReservedMemory()`.
 
-Example Usage:
-~~~c
-temporary_memory TempMem = mem_BeginTemporaryMemory(&MemoryArena);
+@param Memory The `memory_arena` to release.
+**/
+void mem_ReleaseReservedMemory(memory_arena *Memory);
 
-my_struct *MyStruct = mem_PushStruct(&MemoryArena, my_struct);
-// Do some scratch work here, using the memory as normal.
+/** @brief Return the unused committed memory of a reserved arena to the OS.
 
-// Any memory used since mem_BeginTemporaryMemory() will be wiped out here.
-mem_EndTemporaryMemory(TempMem);
-~~~
+Everything past `KeepSize` (or `Used`, if that's larger) is decommitted. Does nothing for arenas that aren't reserved.
 
-@param Memory A pointer to the `memory_arena` to use.
-@return A `temporary_memory` struct that is used again to end the memory.
+@param Memory The reserved `memory_arena`.
+@param KeepSize Amount of memory to keep committed.
 **/
-temporary_memory mem_BeginTemporaryMemory(memory_arena *Memory);
+void mem_DecommitMemory(memory_arena *Memory, size_t KeepSize);
 
-/** @brief Ends the section of temporary memory.
+/** @brief Make sure the first part of an arena is in RAM before it's used.
 
-This will free all the memory used since `mem_BeginTemporaryMemory()`. See @ref mem_BeginTemporaryMemory() for more 
-details on usage.
+For a reserved arena, the memory is committed first. For a growable arena, this only applies to the current block.
 
-@param TempMem The `temporary_memory` struct created with `mem_BeginTemporaryMemory()`.
+@param Memory The `memory_arena` to pre-fault.
+@param Size Amount of memory, from the start of the arena, to pre-fault.
+@param Lock True to also lock the memory in RAM.
+@return True if the memory was committed, and locked if asked for.
+**/
+b8 mem_PrefaultMemory(memory_arena *Memory, size_t Size, b8 Lock);
+
+/** @brief Create one `memory_arena` for each NUMA node, with memory from that node.
+
+Machines without NUMA get a single arena. Arenas are indexed by node number, up to the highest node or `MEM_MAX_NUMA_NODES`, whichever is less. If the node numbers have gaps, the missing numbers still get arenas, with memory from any node.
+
+@param[out] NumaArenas The set of arenas to initialize.
+@param SizePerNode The size of each arena.
+@param Flags Options from @ref memory_flags, used for each arena's memory.
+@return True if every arena was created. If any failed, none are kept.
+**/
+b8 mem_InitNumaArenas(memory_numa_arenas *NumaArenas, size_t SizePerNode, u32 Flags = MEM_Null);
+
+/** @brief Get the arena for the NUMA node the calling thread is running on.
+
+@param NumaArenas The set of arenas, from `mem_InitNumaArenas()`.
+@return The arena local to the calling thread.
+**/
+memory_arena *mem_GetLocalNumaArena(memory_numa_arenas *NumaArenas);
+
+/** @brief Return the memory of every arena from `mem_InitNumaArenas()` to the OS.
+
+@param NumaArenas The set of arenas to release.
+**/
+void mem_ReleaseNumaArenas(memory_numa_arenas *NumaArenas);
+
+/** @brief Delete everything in a `memory_arena` and set the amount of memory used to 0. 
+
+This is used to wipe out everything in a memory arena. This is usually used at the beginning of a control
+loop to clear the volatile memory. For a growable arena, any blocks added since `mem_InitGrowableMemory()` are returned to the OS.
+
+@param Memory The `memory_arena` to wipe.
+@param Decommit For a reserved arena, also return all committed memory to the OS. See @ref mem_DecommitMemory().
+**/
+void mem_ResetMemory(memory_arena *Memory, b8 Decommit = false);
+
+/** @brief Get the amount of memory left in an arena.
+
+For a growable arena, this is the memory left in the current block.
+
+@param Memory A pointer to the `memory_arena` to check.
+@return The amount of unused memory in the arena.
+**/
+inline size_t
+mem_GetMemoryLeft(memory_arena *Memory)
+{
+    size_t Result = Memory->Size - Memory->Used;
+    
+    return Result;
+}
+
+/** @brief Indicates the next section of memory is scratch, and will be cleared quickly.
+
+This must be paired with `mem_EndTemporaryMemory()`. Memory used between `mem_BeginTemporyMemory()` and 
+`mem_EndTemporaryMemory()` will be wiped. This is generally used for brief scratch memory that's needed within 
+a single function, but is not otherwise needed.
+
+Example Usage:
+~~~c
+temporary_memory TempMem = mem_BeginTemporaryMemory(&MemoryArena);
+
+my_struct *MyStruct = mem_PushStruct(&MemoryArena, my_struct);
+// Do some scratch work here, using the memory as normal.
+
+// Any memory used since mem_BeginTemporaryMemory() will be wiped out here.
+mem_EndTemporaryMemory(TempMem);
+~~~
+
+@param Memory A pointer to the `memory_arena` to use.
+@return A `temporary_memory` struct that is used again to end the memory.
+**/
+temporary_memory mem_BeginTemporaryMemory(memory_arena *Memory);
+
+/** @brief Ends the section of temporary memory.
+
+This will free all the memory used since `mem_BeginTemporaryMemory()`. See @ref mem_BeginTemporaryMemory() for more 
+details on usage. For a growable arena, any blocks added since `mem_BeginTemporaryMemory()` are returned to the OS.
+
+@param TempMem The `temporary_memory` struct created with `mem_BeginTemporaryMemory()`.
 **/
 void mem_EndTemporaryMemory(temporary_memory TempMem);
 
-/** @brief Create a `memory_arena` inside an existing arena.
+/** @brief Give back the last push, if nothing has been pushed after it.
+
+This is for code that frees single allocations, such as a `std::pmr` resource. Anything other than the most recent 
+push in the current block is left alone, and is freed with the rest of the arena.
+
+@param Memory A pointer to the `memory_arena` the push came from.
+@param Block The pushed memory.
+@param Size The size that was pushed.
+@return True if the memory was given back.
+**/
+b8 mem_PopSize(memory_arena *Memory, void *Block, size_t Size);
+
+/** @brief Create a `memory_arena` inside an existing arena.
+
+@param Memory A pointer to the existing `memory_arena` within which to create a new arena.
+@param Size The amount of memory to use for the arena.
+@param Alignment Alignment of the start of the arena. The size is also rounded up to a multiple of this, so with `MEM_CACHE_LINE_SIZE` the arena shares no cache lines with anything else in the parent.
+@return A new `memory_arena` that may be used just as the parent arena. If the parent doesn't have room, the arena is empty, with `Start` and `Size` 0, and every push to it fails.
+**/
+memory_arena
+mem_CreateSubArena(memory_arena *Memory, size_t Size, size_t Alignment = 1);
+
+/** @private **/
+b8 mem_AddBlock_(memory_arena *Memory, size_t MinimumSize);
+
+/** @private **/
+void mem_FreeBlock_(memory_arena *Memory);
+
+/** @private **/
+b8 mem_CommitMemory_(memory_arena *Memory, size_t NewUsed);
+
+/** @private **/
+void *mem_BeginArray_(memory_arena *Memory, size_t ElementSize, memory_array *MemoryArrayOut, size_t MaxElementCount = 0);
+
+
+/** @brief End a previously started array, setting memory size to the given element count.
+
+Only the first `ElementCount` elements of the array may have been written.
+
+**/
+void mem_EndArray(memory_array *MemoryArray, u32 ElementCount);
+
+/** @brief A memory arena that many threads may push to at the same time. See @ref mem_InitConcurrentArena(). **/
+struct concurrent_arena
+{
+    void *Start;
+    size_t Size;
+    size_t ChunkSize;
+    // NOTE(amos): Read on every chunk push but only written on reset, so it stays with the other read-mostly fields.
+    std::atomic<u32> Generation;
+    
+    // NOTE(amos): Written by every pushing thread, so kept on its own cache line. The struct is padded out to a whole
+    // line after it.
+    alignas(MEM_CACHE_LINE_SIZE) std::atomic<size_t> Used;
+};
+
+/** @brief A part of a `concurrent_arena` owned by a single thread. Start it out zeroed, with `= {}`. **/
+struct concurrent_chunk
+{
+    u8 *At;
+    u8 *End;
+    u32 Generation;
+};
+
+/** @brief Get memory for the type or struct from a `concurrent_arena`, cleared to 0. See @ref mem_PushConcurrentSize_(). **/
+#define mem_PushConcurrentStruct(Arena, Chunk, Type) (Type*)mem_PushConcurrentSize_(Arena, Chunk, sizeof(Type), alignof(Type))
+
+/** @brief Get memory for an array from a `concurrent_arena`, cleared to 0. See @ref mem_PushConcurrentSize_(). **/
+#define mem_PushConcurrentArray(Arena, Chunk, Count, Type) (Type*)mem_PushConcurrentSize_(Arena, Chunk, (Count)*sizeof(Type), alignof(Type))
+
+/** @brief Initialize a `concurrent_arena`.
+
+@param[out] Arena The arena to initialize.
+@param Start The start of the memory block. Must be aligned to `MEM_CACHE_LINE_SIZE`.
+@param Size The size of the memory block.
+@param ChunkSize The amount of memory each `concurrent_chunk` takes from the arena at a time. Must be a multiple of `MEM_CACHE_LINE_SIZE`.
+**/
+void mem_InitConcurrentArena(concurrent_arena *Arena, void *Start, size_t Size, size_t ChunkSize);
+
+/** @brief Get memory from a `concurrent_arena`, cleared to 0.
+
+Safe to call from any number of threads at once, as long as each uses its own `Chunk`. Pushes larger than a quarter of the chunk size go straight to the arena.
+
+@param Arena The shared arena.
+@param Chunk The calling thread's chunk, or 0 to always push straight to the arena.
+@param Size Amount of memory to get.
+@param Alignment Alignment of the memory in bytes. Must be a power of 2, no larger than `MEM_CACHE_LINE_SIZE`.
+@return Pointer to the memory; 0 if the arena is full.
+**/
+void *mem_PushConcurrentSize_(concurrent_arena *Arena, concurrent_chunk *Chunk, size_t Size, size_t Alignment = 8);
+
+/** @brief Wipe everything in a `concurrent_arena`.
+
+Not safe to call while any thread is pushing. Chunks handed out before the reset are dropped the next time they're pushed to.
+
+@param Arena The arena to reset.
+**/
+void mem_ResetConcurrentArena(concurrent_arena *Arena);
+
+/** @brief Number of items a `memory_pool_cache` holds. It moves half this many to or from the pool at a time. **/
+#define MEM_POOL_CACHE_COUNT 32
+
+/** @private **/
+struct memory_pool_item
+{
+    memory_pool_item *Next;
+};
+
+/** @brief A pool of fixed-size items inside a `memory_arena`. See @ref mem_PushPool(). **/
+struct memory_pool
+{
+    u8 *Items;
+    size_t ItemSize;
+    u32 ItemCount;
+    
+    // NOTE(amos): Items past UnusedIndex have never been handed out, and aren't on the free list.
+    u32 UnusedIndex;
+    u32 FreeCount;
+    memory_pool_item *FreeList;
+    
+    std::atomic_flag Lock;
+};
+
+/** @brief A per-thread cache of items for a `memory_pool`. See @ref mem_InitPoolCache(). **/
+struct memory_pool_cache
+{
+    memory_pool *Pool;
+    u32 Count;
+    memory_pool_item *Items;
+};
+
+/** @brief Create a pool of items of the given type in an arena.
+
+@param Arena A pointer to the `memory_arena` to hold the pool.
+@param Type The type of item in the pool.
+@param Count The number of items in the pool.
+@return A pointer to the pool, or 0 if there isn't enough memory.
+**/
+#define mem_PushPool(Arena, Type, Count) mem_PushPool_(Arena, sizeof(Type), alignof(Type), Count)
+
+/** @brief Get an item from a pool, cleared to 0. See @ref mem_PoolAlloc(). **/
+#define mem_PoolAllocStruct(Pool, Type) (Type*)mem_PoolAlloc(Pool)
+
+/** @private **/
+memory_pool *mem_PushPool_(memory_arena *Arena, size_t ItemSize, size_t Alignment, u32 Count);
+
+/** @brief Get an item from a pool, cleared to 0.
+
+@param Pool The pool.
+@return Pointer to the item, or 0 if every item in the pool is in use.
+**/
+void *mem_PoolAlloc(memory_pool *Pool);
+
+/** @brief Return an item to its pool.
+
+@param Pool The pool the item came from.
+@param Item The item to return. May be 0.
+**/
+void mem_PoolFree(memory_pool *Pool, void *Item);
+
+/** @brief Get the number of items in a pool that are free to allocate. Items held in a `memory_pool_cache` are not counted. **/
+u32 mem_GetPoolItemsLeft(memory_pool *Pool);
+
+/** @brief Create a cache for one thread to use with a pool. **/
+memory_pool_cache mem_InitPoolCache(memory_pool *Pool);
+
+/** @brief Get an item from a thread's pool cache, cleared to 0. Refills the cache from the pool when it's empty.
+
+@param Cache The calling thread's cache.
+@return Pointer to the item, or 0 if every item in the pool is in use.
+**/
+void *mem_PoolAllocCached(memory_pool_cache *Cache);
+
+/** @brief Return an item to a thread's pool cache. Returns half the cache to the pool when it's full.
+
+@param Cache The calling thread's cache. The item may have come from any cache of the same pool.
+@param Item The item to return. May be 0.
+**/
+void mem_PoolFreeCached(memory_pool_cache *Cache, void *Item);
+
+/** @brief Return every item in a cache to its pool. Call this before the thread that owns the cache exits. **/
+void mem_FlushPoolCache(memory_pool_cache *Cache);
+
+
+/** @brief An array that grows in place, in its own reserved range of address space. See @ref mem_InitVirtualArray(). **/
+struct memory_virtual_array
+{
+    /** @brief The reserved arena holding the elements. **/
+    memory_arena Arena;
+    /** @brief Size of each element in bytes. **/
+    size_t ElementSize;
+    /** @brief Number of elements in the array. **/
+    size_t Count;
+};
+
+/** @brief Create an array that grows in place.
+
+Unlike `mem_BeginArray()`, the array has its own reserved address space rather than taking over the rest of an arena, so any number of them may be open at once, and other arenas can be used while they grow. Pages are committed as the array grows, and elements never move.
+
+~~~c
+memory_virtual_array Hits = mem_InitVirtualArray(100000, hit_result);
+for(...)
+{
+    hit_result *Hit = mem_PushVirtualArray(&Hits, 1, hit_result);
+    ...
+}
+hit_result *AllHits = mem_GetVirtualArray(&Hits, hit_result);
+mem_ClearVirtualArray(&Hits);
+...
+mem_ReleaseVirtualArray(&Hits);
+~~~
+
+@param MaxCount The most elements the array can ever hold. Only address space is reserved for them.
+@param Type The element type.
+@return The array. `Arena.Start` is 0 if the address space couldn't be reserved.
+**/
+#define mem_InitVirtualArray(MaxCount, Type) mem_InitVirtualArray_((MaxCount), sizeof(Type))
+
+/** @brief Add elements to the end of a virtual array.
+
+@param Array The array.
+@param Count Number of elements to add.
+@param Type The element type.
+@return A pointer to the first new element, cleared to 0.
+**/
+#define mem_PushVirtualArray(Array, Count, Type) (Type*)mem_PushVirtualArray_(Array, Count)
+
+/** @brief Get a pointer to the first element of a virtual array. **/
+#define mem_GetVirtualArray(Array, Type) ((Type*)(Array)->Arena.Start)
+
+/** @private **/
+memory_virtual_array mem_InitVirtualArray_(size_t MaxCount, size_t ElementSize);
+
+/** @private **/
+void *mem_PushVirtualArray_(memory_virtual_array *Array, size_t Count, b8 ClearMemory = true MEM_LOCATION_PARAMS);
+
+/** @brief Remove elements from the end of a virtual array. **/
+void mem_PopVirtualArray(memory_virtual_array *Array, size_t Count);
+
+/** @brief Empty a virtual array.
+
+@param Array The array.
+@param Decommit True to also return the committed pages to the OS.
+**/
+void mem_ClearVirtualArray(memory_virtual_array *Array, b8 Decommit = false);
+
+/** @brief Release a virtual array's address space. **/
+void mem_ReleaseVirtualArray(memory_virtual_array *Array);
+
+
+/** @brief Size of the header at the start of a file-backed arena's file. The arena's memory starts after it. **/
+#define MEM_FILE_HEADER_SIZE Kilobytes(4)
+
+/** @private **/
+#define MEM_FILE_MAGIC 0x454C49464D454D41ULL
+
+/** @private The header at the start of a file-backed arena's file. **/
+struct memory_file_header
+{
+    // NOTE(amos): Only written once the contents have been saved, so a file from a crashed run isn't restored.
+    u64 Magic;
+    u64 Size;
+    u64 Used;
+    u64 BaseAddress;
+    u32 Version;
+};
+
+/** @brief Open an arena backed by a memory-mapped file, restoring what was saved in it last time.
+
+The file holds a small header followed by the arena's memory. If the file has a saved arena with the same `Version` and `Size`, the arena is restored with its old `Used`, and `isRestoredOut` is set. Otherwise the arena starts empty. Call `mem_SaveFileMemory()` once the arena has been built to mark it as saved.
+
+Restored data may hold pointers into the arena, so by default the file is mapped at the same address it was saved from. If that address isn't free, the arena starts empty rather than restoring data with pointers that no longer point at the right place. Data that only uses offsets can pass `isRelocatable` as true to restore at any address.
+
+~~~c
+b8 isRestored = false;
+memory_arena InitMemory = mem_OpenFileMemory("/var/cache/control/init.arena", Gigabytes(2), LOOKUP_TABLE_VERSION, &isRestored);
+lookup_tables *Tables = (lookup_tables*)InitMemory.Start;
+if(!isRestored)
+{
+    Tables = mem_PushStruct(&InitMemory, lookup_tables);
+    BuildLookupTables(Tables, &InitMemory);
+    mem_SaveFileMemory(&InitMemory);
+}
+...
+mem_CloseFileMemory(&InitMemory);
+~~~
+
+@param Path Path to the file. Created if it doesn't exist.
+@param Size Size of the arena. The file is `Size + MEM_FILE_HEADER_SIZE` bytes.
+@param Version Version of the data layout. Bump this whenever the data stored in the arena changes, so old files aren't restored.
+@param[out] isRestoredOut If not 0, set to true if saved data was restored.
+@param isRelocatable True if the data has no pointers into the arena, so it can be restored at any address.
+@return The arena. `Start` is 0 if the file couldn't be opened or mapped.
+**/
+memory_arena mem_OpenFileMemory(char const *Path, size_t Size, u32 Version, b8 *isRestoredOut = 0, b8 isRelocatable = false);
+
+/** @brief Save a file-backed arena, so it's restored the next time it's opened.
+
+The contents are written to disk first, then the header is updated to mark them as saved.
+
+@return True if the arena was written to disk.
+**/
+b8 mem_SaveFileMemory(memory_arena *Memory);
+
+/** @brief Unmap a file-backed arena. This doesn't save it; changes since `mem_SaveFileMemory()` are written to the file, but the header still has the old `Used`. **/
+void mem_CloseFileMemory(memory_arena *Memory);
+
+
+/** @private **/
+#define MEM_SHARED_MAGIC 0x4445524148534D41ULL
+
+/** @private The header at the start of a shared arena's memory, seen by every process. **/
+struct shared_arena_header
+{
+    // NOTE(amos): Set by the creating process once the rest of the header is ready.
+    std::atomic<u64> Magic;
+    u64 Size;
+    std::atomic<u64> RootOffset;
+    alignas(MEM_CACHE_LINE_SIZE) std::atomic<u64> Used;
+};
+
+// NOTE(amos): An atomic that falls back to a lock keeps the lock in this process, so other processes would ignore it.
+static_assert(std::atomic<u64>::is_always_lock_free, "Shared arenas need lock-free 64-bit atomics.");
+
+/** @brief A process's view of an arena in memory shared between processes. See @ref mem_OpenSharedArena(). **/
+struct shared_arena
+{
+    /** @private **/
+    shared_arena_header *Header;
+    /** @brief Start of the arena in this process. Different in each process. **/
+    u8 *Start;
+    /** @brief Size of the arena. **/
+    size_t Size;
+};
+
+/** @brief Get memory for the type or struct from a `shared_arena`, cleared to 0. See @ref mem_PushSharedSize_(). **/
+#define mem_PushSharedStruct(Arena, Type) (Type*)mem_PushSharedSize_(Arena, sizeof(Type), alignof(Type))
+
+/** @brief Get memory for an array from a `shared_arena`, cleared to 0. See @ref mem_PushSharedSize_(). **/
+#define mem_PushSharedArray(Arena, Count, Type) (Type*)mem_PushSharedSize_(Arena, (Count)*sizeof(Type), alignof(Type))
+
+/** @brief Open an arena shared between processes, creating it if this is the first process to open it.
+
+Every process that opens the same name can push to the arena at the same time; the offset of the next push is kept in an atomic in the shared memory. The arena is mapped at a different address in each process, so data in it should refer to other data by offset, with `mem_GetSharedOffset()`, or with `rel_ptr` from @ref ab_relptr.h. `mem_SetSharedRoot()` lets the other processes find where to start.
+
+~~~c
+// In the logger:
+shared_arena LogMemory = mem_OpenSharedArena("/control_log", Megabytes(256));
+log_ring *Ring = mem_PushSharedStruct(&LogMemory, log_ring);
+mem_SetSharedRoot(&LogMemory, Ring);
+
+// In the control process:
+shared_arena LogMemory = mem_OpenSharedArena("/control_log", Megabytes(256));
+log_ring *Ring = (log_ring*)mem_GetSharedRoot(&LogMemory);
+~~~
+
+@param Name Name of the shared memory. On Linux, this must start with a '/'.
+@param Size Size of the arena. Every process must use the same size.
+@param TimeoutMs How long to wait for the process that created the arena to finish setting it up, covering both sizing the memory and filling in the header. Only reached if that process died partway through.
+@return The arena. `Start` is 0 if the memory couldn't be mapped, it was created with a different size, or it wasn't set up within `TimeoutMs`.
+**/
+shared_arena mem_OpenSharedArena(char const *Name, size_t Size, u32 TimeoutMs = 1000);
+
+/** @brief Get memory from a `shared_arena`, cleared to 0. Safe to call from any number of threads and processes at once.
+
+@param Arena The arena.
+@param Size Amount of memory to get.
+@param Alignment Alignment of the memory in bytes. Must be a power of 2.
+@return Pointer to the memory in this process; 0 if the arena is full.
+**/
+void *mem_PushSharedSize_(shared_arena *Arena, size_t Size, size_t Alignment = 8);
+
+/** @brief Get the offset of memory in a shared arena, which is the same in every process. **/
+inline u64
+mem_GetSharedOffset(shared_arena *Arena, void *Address)
+{
+    Assert((u8*)Address >= Arena->Start && (u8*)Address < (Arena->Start + Arena->Size));
+    
+    return (u64)(((u8*)Address) - Arena->Start);
+}
+
+/** @brief Get the address of an offset from `mem_GetSharedOffset()` in this process. **/
+inline void *
+mem_GetSharedAddress(shared_arena *Arena, u64 Offset)
+{
+    return Arena->Start + Offset;
+}
+
+/** @brief Publish the top-level structure of a shared arena, for other processes to find with `mem_GetSharedRoot()`. **/
+void mem_SetSharedRoot(shared_arena *Arena, void *Root);
+
+/** @brief Get the structure published with `mem_SetSharedRoot()`, or 0 if there isn't one yet. **/
+void *mem_GetSharedRoot(shared_arena *Arena);
+
+/** @brief Wipe everything in a shared arena. Not safe while any process is still using the memory. **/
+void mem_ResetSharedArena(shared_arena *Arena);
+
+/** @brief Unmap a shared arena from this process. The memory stays for the other processes; use `mem_RemoveSharedOsMemory()` to remove its name once it's no longer needed. **/
+void mem_CloseSharedArena(shared_arena *Arena);
+
+
+/** @brief A ring buffer where records that wrap around the end are still contiguous in memory. See @ref mem_CreateRing(). **/
+struct memory_ring
+{
+    /** @brief Start of the buffer. The same memory is mapped again right after it. **/
+    u8 *Start;
+    /** @brief Size of the buffer. **/
+    size_t Size;
+    
+    /** @private Total bytes ever written. Only moved by the writer. **/
+    alignas(MEM_CACHE_LINE_SIZE) std::atomic<u64> WritePosition;
+    /** @private Total bytes ever read. Only moved by the reader. **/
+    alignas(MEM_CACHE_LINE_SIZE) std::atomic<u64> ReadPosition;
+};
+
+/** @brief Create a ring buffer whose memory is mapped twice, back to back.
+
+Since the second mapping follows the first, a record that runs off the end of the buffer carries on into the start of it without a break. Records can be written and parsed in place, with no special case for the wrap.
+
+One thread may write while another reads, with no locks.
+
+~~~c
+memory_ring Ring;
+mem_CreateRing(&Ring, Megabytes(4));
+
+// Writer:
+u8 *Record = (u8*)mem_BeginRingWrite(&Ring, RecordSize);
+if(Record)
+{
+    WriteRecord(Record, RecordSize);
+    mem_EndRingWrite(&Ring, RecordSize);
+}
+
+// Reader:
+size_t Available = 0;
+u8 *Data = (u8*)mem_BeginRingRead(&Ring, &Available);
+size_t Parsed = ParseRecords(Data, Available);
+mem_EndRingRead(&Ring, Parsed);
+~~~
+
+@param[out] Ring The ring to create.
+@param Size Size of the buffer. Rounded up to a multiple of `MEM_COMMIT_GRANULARITY`.
+@return True if the memory was mapped.
+**/
+b8 mem_CreateRing(memory_ring *Ring, size_t Size);
+
+/** @brief Return a ring buffer's memory to the OS. **/
+void mem_ReleaseRing(memory_ring *Ring);
+
+/** @brief Get space to write to at the end of a ring buffer. Call `mem_EndRingWrite()` once it's written.
+
+@param Ring The ring.
+@param Size Amount of space needed.
+@return Pointer to `Size` contiguous bytes; 0 if there isn't that much free space yet, or the ring wasn't created.
+**/
+void *mem_BeginRingWrite(memory_ring *Ring, size_t Size);
+
+/** @brief Make `Size` bytes written since `mem_BeginRingWrite()` available to the reader. **/
+void mem_EndRingWrite(memory_ring *Ring, size_t Size);
+
+/** @brief Get everything written to a ring buffer that hasn't been read yet, as one contiguous block.
+
+@param Ring The ring.
+@param[out] SizeOut Number of bytes available.
+@return Pointer to the first unread byte; 0, with `SizeOut` set to 0, if the ring wasn't created or has been released.
+**/
+void *mem_BeginRingRead(memory_ring *Ring, size_t *SizeOut);
+
+/** @brief Free `Size` bytes from the front of a ring buffer for the writer. **/
+void mem_EndRingRead(memory_ring *Ring, size_t Size);
+
+
+/** @private Total used across every block of a growable arena. **/
+size_t mem_GetTotalUsed_(memory_arena *Memory);
+
+/** @brief Number of distinct push call sites the instrumented build keeps track of. **/
+#define MEM_INSTRUMENT_SITE_COUNT 4096
+
+/** @brief Number of arenas the instrumented build keeps track of. **/
+#define MEM_INSTRUMENT_ARENA_COUNT 256
+
+/** @brief Pushes made from one line of code, recorded when `MEM_INSTRUMENT` is 1. **/
+struct memory_site_stats
+{
+    char const *File;
+    u32 Line;
+    u64 PushCount;
+    u64 TotalSize;
+    u64 MaxSize;
+};
+
+/** @brief Use of one arena, recorded when `MEM_INSTRUMENT` is 1. **/
+struct memory_arena_stats
+{
+    memory_arena *Arena;
+    char const *Name;
+    u64 PushCount;
+    /** @brief The most the arena has held at once, including every block of a growable arena, across resets. **/
+    u64 PeakUsed;
+    u64 ResetCount;
+    /** @brief Number of `temporary_memory` scopes ended. **/
+    u64 TemporaryCount;
+    /** @brief Memory freed by all `temporary_memory` scopes together. **/
+    u64 TemporaryTotalSize;
+    /** @brief The most memory freed by a single `temporary_memory` scope. **/
+    u64 TemporaryMaxSize;
+    /** @brief Number of pushes given back with `mem_PopSize()`. **/
+    u64 PopCount;
+    /** @brief Memory given back by all `mem_PopSize()` calls together. **/
+    u64 PopTotalSize;
+};
+
+/** @brief Give an arena a name in the memory report. Does nothing unless `MEM_INSTRUMENT` is 1.
+
+@param Memory The arena.
+@param Name The name. Must stay valid, such as a string literal.
+**/
+void mem_SetArenaName(memory_arena *Memory, char const *Name);
+
+/** @brief Print the memory report: arenas by peak use, and push call sites by total size. Does nothing unless `MEM_INSTRUMENT` is 1.
+
+@param Out Where to print, such as `stdout`.
+@param MaxSiteCount The most call sites to print.
+**/
+void mem_PrintMemoryReport(FILE *Out, u32 MaxSiteCount = 50);
+
+/** @brief Write the memory report as JSON, with every arena and call site. Does nothing unless `MEM_INSTRUMENT` is 1. **/
+void mem_WriteMemoryReportJson(FILE *Out);
+
+/** @brief Clear everything recorded so far, such as after startup. Arena names are kept. **/
+void mem_ClearMemoryReport();
+
+#if MEM_INSTRUMENT
+/** @private **/
+void mem_RecordPush_(memory_arena *Memory, size_t Size, char const *File, u32 Line);
+/** @private **/
+void mem_RecordReset_(memory_arena *Memory);
+/** @private **/
+void mem_RecordTemporaryMemory_(memory_arena *Memory, size_t Size);
+/** @private **/
+void mem_RecordPop_(memory_arena *Memory, size_t Size);
+#endif
+
+
+/** @brief Two arenas that take turns, so memory from one frame stays valid through the next. See @ref mem_InitFrameArenas(). **/
+struct memory_frame_arenas
+{
+    memory_arena Arenas[2];
+    /** @private Root pointer published for each arena. **/
+    void *Roots[2];
+    
+    // NOTE(amos): Written by the producer, read by the consumer, and the other way around, so each is on its own cache line.
+    /** @private **/
+    alignas(MEM_CACHE_LINE_SIZE) std::atomic<u64> CurrentFrame;
+    /** @private **/
+    std::atomic<u64> PublishedFrame;
+    /** @private **/
+    alignas(MEM_CACHE_LINE_SIZE) std::atomic<u64> ReadFrame;
+};
+
+/** @brief Initialize a pair of frame arenas, splitting a block of memory between them.
+
+@param[out] Frames The frame arenas to initialize.
+@param Start The start of the memory block.
+@param Size The size of the memory block. Each arena gets half.
+@param isZeroed True if the memory block is known to be zeroed, such as fresh from the OS.
+**/
+void mem_InitFrameArenas(memory_frame_arenas *Frames, void *Start, size_t Size, b8 isZeroed = false);
+
+/** @brief Start the next frame, and get its arena.
+
+The arena is reset, wiping out the frame before last. The previous frame's memory is left alone. If a consumer thread is still reading the frame before last, waits for it to call @ref mem_EndFrameRead().
+
+@param Frames The frame arenas.
+@return The arena to push to for this frame.
+**/
+memory_arena *mem_BeginFrame(memory_frame_arenas *Frames);
+
+/** @brief Get the arena of the frame being filled, from @ref mem_BeginFrame(). **/
+memory_arena *mem_GetCurrentFrame(memory_frame_arenas *Frames);
+
+/** @brief Get the arena of the frame before the current one. Everything pushed to it is still valid. **/
+memory_arena *mem_GetPreviousFrame(memory_frame_arenas *Frames);
+
+/** @brief Hand the current frame off to a consumer thread.
+
+Call after the frame is filled. The consumer can read it with @ref mem_BeginFrameRead() while the next frame is filled.
+
+@param Frames The frame arenas.
+@param Root A pointer into the current frame for the consumer to start from, such as a struct of results.
+**/
+void mem_PublishFrame(memory_frame_arenas *Frames, void *Root);
+
+/** @brief Start reading the most recently published frame from a consumer thread.
+
+Never waits. The frame stays valid until @ref mem_EndFrameRead(), which must be called before the producer gets two frames further along, or the producer waits. Only one consumer thread may read at a time.
+
+@param Frames The frame arenas.
+@param[out] FrameOut The number of the frame being read, counting from 1. May be 0.
+@return The root pointer passed to @ref mem_PublishFrame(); 0 if nothing has been published yet, or the producer has moved two frames past the last one published. No read is started when 0 is returned.
+**/
+void *mem_BeginFrameRead(memory_frame_arenas *Frames, u64 *FrameOut = 0);
+
+/** @brief Finish reading a frame from @ref mem_BeginFrameRead(). **/
+void mem_EndFrameRead(memory_frame_arenas *Frames);
+
+
+/** @brief Size of the pages `memory_checkpoint` tracks. **/
+#define MEM_CHECKPOINT_PAGE_SIZE Kilobytes(4)
+
+/** @private **/
+#define MEM_CHECKPOINT_MAGIC 0x54504B434D454D41ULL
+
+/** @private **/
+#define MEM_CHECKPOINT_RECORD_MAGIC 0x41544C444D454D41ULL
+
+/** @private The header at the start of a checkpoint file. **/
+struct memory_checkpoint_header
+{
+    u64 Magic;
+    u64 Size;
+    u32 Version;
+    u32 PageSize;
+};
+
+/** @private The header of each checkpoint in a checkpoint file. It's followed by the page indexes, the pages, and the sequence number again to show the checkpoint was written in full. **/
+struct memory_checkpoint_record
+{
+    u64 Magic;
+    u64 Sequence;
+    u64 Used;
+    u64 PageCount;
+};
+
+/** @brief Writes checkpoints of an arena to a file, saving only the pages changed since the last checkpoint. See @ref mem_OpenCheckpoints(). **/
+struct memory_checkpoint
+{
+    memory_arena *Arena;
+    char Path[MAX_FILENAME_SIZE + 1];
+    u32 Version;
+    FILE *File;
+    /** @brief True if changes are found from the OS's soft-dirty bits, false if by comparing a hash of each page. **/
+    b8 isSoftDirty;
+    
+    /** @private **/
+    size_t PageCount;
+    /** @private One per page, for hashing. **/
+    u64 *PageHashes;
+    /** @private One per page. **/
+    u8 *DirtyPages;
+    /** @private One per page. **/
+    u64 *PageIndexes;
+    /** @private **/
+    size_t BookkeepingSize;
+    /** @private **/
+    u64 Sequence;
+    /** @private **/
+    size_t LastUsed;
+    /** @private The arena's `DecommitCount` at the last checkpoint. **/
+    u32 LastDecommitCount;
+};
+
+/** @brief Start writing checkpoints of an arena to a file.
+
+The first call to `mem_WriteCheckpoint()` writes every used page of the arena. Later calls only append the pages written to since the checkpoint before, found with the OS's soft-dirty page bits where it has them (Linux), or by comparing a hash of each page otherwise. Soft-dirty bits cover the whole process, so only one `memory_checkpoint` at a time uses them; any others hash. Pages handed back with `mem_DecommitMemory()` read as 0 without being written, so the next checkpoint after one is full when soft-dirty bits are in use.
+
+The arena must be a single block, such as from `mem_InitMemory()` or `mem_InitReservedMemory()`. Its `Start` and `Size` must both be multiples of `MEM_CHECKPOINT_PAGE_SIZE`.
+
+~~~c
+memory_arena StateMemory = mem_InitReservedMemory(Gigabytes(16));
+if(!mem_RestoreCheckpoint(&StateMemory, "/var/lib/control/state.ckpt", STATE_VERSION))
+{
+    BuildState(&StateMemory);
+}
+
+memory_checkpoint Checkpoint;
+mem_OpenCheckpoints(&Checkpoint, &StateMemory, "/var/lib/control/state.ckpt", STATE_VERSION);
+while(isRunning)
+{
+    UpdateState(&StateMemory);
+    if(isCheckpointDue)
+    {
+        // Compact the file now and then, so restoring doesn't replay every change.
+        mem_WriteCheckpoint(&Checkpoint, ++CheckpointCount % 100 == 0);
+    }
+}
+mem_CloseCheckpoints(&Checkpoint);
+~~~
+
+@param[out] Checkpoint The checkpoint state to initialize.
+@param Arena The arena to checkpoint.
+@param Path Path of the checkpoint file. The first checkpoint replaces any file already there.
+@param Version Version of the data layout, checked by `mem_RestoreCheckpoint()`.
+@param isHashing True to always compare page hashes, rather than using soft-dirty bits.
+@return True if ready to write checkpoints.
+**/
+b8 mem_OpenCheckpoints(memory_checkpoint *Checkpoint, memory_arena *Arena, char const *Path, u32 Version, b8 isHashing = false);
+
+/** @brief Write a checkpoint of the arena to the checkpoint file, and wait for it to reach the disk.
+
+The arena must not be changed while the checkpoint is written.
+
+@param Checkpoint The checkpoint state from `mem_OpenCheckpoints()`.
+@param isFull True to write every used page to a new file, replacing the old one. The replacement is atomic, so a crash leaves either the old file or the new one.
+@param[out] PageCountOut If not 0, set to the number of pages written.
+@return True if the checkpoint was written.
+**/
+b8 mem_WriteCheckpoint(memory_checkpoint *Checkpoint, b8 isFull = false, size_t *PageCountOut = 0);
+
+/** @brief Stop writing checkpoints, and close the checkpoint file. **/
+void mem_CloseCheckpoints(memory_checkpoint *Checkpoint);
+
+/** @brief Rebuild an arena from a checkpoint file.
+
+Replays the full checkpoint and every change after it, up to the last one written completely. The arena must be the same size as the one checkpointed. Data with pointers into the arena must also be at the same address, unless it only uses offsets such as `rel_ptr`.
+
+@param Arena The arena to restore into. Must be a single block, with `Start` and `Size` multiples of `MEM_CHECKPOINT_PAGE_SIZE`.
+@param Path Path of the checkpoint file.
+@param Version Version of the data layout. The file is only restored if it matches.
+@return True if the arena was restored. A checkpoint is only put in place once it's known to be complete, so if false, the arena is unchanged unless reading the file failed partway through the full checkpoint.
+**/
+b8 mem_RestoreCheckpoint(memory_arena *Arena, char const *Path, u32 Version);
+
+/** @brief Number of scratch arenas each thread has. One more than the number of conflicting arenas a caller may pass in. **/
+#define MEM_SCRATCH_ARENA_COUNT 2
+
+#ifndef MEM_SCRATCH_RESERVE_SIZE
+/** @brief Address space reserved for each scratch arena. Only the memory actually used is committed. **/
+#define MEM_SCRATCH_RESERVE_SIZE ((sizeof(void*) == 8) ? Gigabytes(8) : Megabytes(64))
+#endif
+
+/** @brief Get temporary memory from one of the calling thread's scratch arenas.
+
+The scratch arena is guaranteed not to be, or be inside, any of the `Conflicts` arenas. Must be paired with `mem_ReleaseScratch()`.
+
+@param Conflicts Arenas the scratch memory must not come from, usually any arenas passed in by the caller. May be 0.
+@param ConflictCount Number of arenas in `Conflicts`.
+@return A `temporary_memory` for the scratch arena. Push to `Arena`, and pass it to `mem_ReleaseScratch()` when done. `Arena` is 0 if every scratch arena conflicts, or the memory couldn't be reserved.
+**/
+temporary_memory mem_GetScratch(memory_arena **Conflicts = 0, u32 ConflictCount = 0);
+
+/** @brief Get temporary memory from a scratch arena that isn't `Conflict`. See @ref mem_GetScratch(memory_arena**, u32). **/
+temporary_memory mem_GetScratch(memory_arena *Conflict);
+
+/** @brief Release memory from `mem_GetScratch()`. Everything pushed to the scratch arena since is wiped out. **/
+void mem_ReleaseScratch(temporary_memory Scratch);
+
+/** @brief Return the calling thread's scratch arenas to the OS. Call before a thread that used scratch memory exits. **/
+void mem_ReleaseThreadScratch();
+
+/** @brief Scratch memory that is released when it goes out of scope. See @ref mem_GetScratch(). **/
+struct scratch_memory
+{
+    /** @brief The scratch arena to push to. **/
+    memory_arena *Arena;
+    /** @private **/
+    temporary_memory TempMem;
+    
+    scratch_memory(memory_arena *Conflict = 0) : TempMem(mem_GetScratch(Conflict)) { Arena = TempMem.Arena; }
+    scratch_memory(memory_arena **Conflicts, u32 ConflictCount) : TempMem(mem_GetScratch(Conflicts, ConflictCount)) { Arena = TempMem.Arena; }
+    ~scratch_memory() { if(Arena) { mem_ReleaseScratch(TempMem); } }
+    
+    scratch_memory(scratch_memory const &) = delete;
+    scratch_memory &operator=(scratch_memory const &) = delete;
+};
+
+#endif
+
+#if _WINDOWS
+#include "ab_memory_win32.h"
+#elif _LINUX
+#include "ab_memory_linux.h"
+#endif
+
+
+#if defined(MEMORY_SRC)
+
+memory_arena
+mem_InitMemory(void *Start, size_t Size, b8 isZeroed)
+{
+    Assert(Start);
+    
+    memory_arena Memory = {};
+    Memory.Start = Start;
+    Memory.Size = Size;
+    Memory.Used = 0;
+    Memory.Committed = Size;
+    Memory.Dirty = isZeroed ? 0 : Size;
+    
+    return Memory;
+}
+
+memory_arena
+mem_InitGrowableMemory(void *Start, size_t Size, size_t MinimumBlockSize, b8 isZeroed)
+{
+    Assert(Start || !Size);
+    Assert(MinimumBlockSize);
+    
+    memory_arena Memory = {};
+    Memory.Start = Start;
+    Memory.Size = Size;
+    Memory.Used = 0;
+    Memory.MinimumBlockSize = MinimumBlockSize;
+    Memory.BlockCount = 0;
+    Memory.Committed = Size;
+    Memory.Dirty = isZeroed ? 0 : Size;
+    
+    return Memory;
+}
+
+memory_arena
+mem_InitReservedMemory(size_t ReserveSize)
+{
+    memory_arena Memory = {};
+    Memory.Start = mem_ReserveOsMemory(0, ReserveSize);
+    if(Memory.Start)
+    {
+        Memory.Size = ReserveSize;
+        Memory.Used = 0;
+        Memory.Committed = 0;
+        Memory.isReserved = true;
+        Memory.Dirty = 0;
+    }
+    
+    return Memory;
+}
+
+void
+mem_ReleaseReservedMemory(memory_arena *Memory)
+{
+    Assert(Memory->isReserved);
+    
+    mem_DeallocateOsMemory(Memory->Start, Memory->Size);
+    *Memory = {};
+}
+
+b8
+mem_CommitMemory_(memory_arena *Memory, size_t NewUsed)
+{
+    Assert(Memory->isReserved);
+    
+    size_t NewCommitted = ((NewUsed + MEM_COMMIT_GRANULARITY - 1) / MEM_COMMIT_GRANULARITY) * MEM_COMMIT_GRANULARITY;
+    NewCommitted = MINIMUM(NewCommitted, Memory->Size);
+    
+    b8 Result = mem_CommitOsMemory(((u8*)Memory->Start) + Memory->Committed, NewCommitted - Memory->Committed);
+    if(Result)
+    {
+        Memory->Committed = NewCommitted;
+    }
+    
+    return Result;
+}
+
+void
+mem_DecommitMemory(memory_arena *Memory, size_t KeepSize)
+{
+    if(Memory->isReserved)
+    {
+        KeepSize = MAXIMUM(KeepSize, Memory->Used);
+        size_t KeepCommitted = ((KeepSize + MEM_COMMIT_GRANULARITY - 1) / MEM_COMMIT_GRANULARITY) * MEM_COMMIT_GRANULARITY;
+        
+        if(KeepCommitted < Memory->Committed)
+        {
+            mem_DecommitOsMemory(((u8*)Memory->Start) + KeepCommitted, Memory->Committed - KeepCommitted);
+            Memory->Committed = KeepCommitted;
+            Memory->Dirty = MINIMUM(Memory->Dirty, KeepCommitted);
+            ++Memory->DecommitCount;
+        }
+    }
+}
+
+b8
+mem_PrefaultMemory(memory_arena *Memory, size_t Size, b8 Lock)
+{
+    b8 Result = true;
+    
+    Size = MINIMUM(Size, Memory->Size);
+    if(Size > Memory->Committed)
+    {
+        Result = mem_CommitMemory_(Memory, Size);
+    }
+    
+    if(Result)
+    {
+        mem_PrefaultOsMemory(Memory->Start, Size);
+        if(Lock)
+        {
+            Result = mem_LockOsMemory(Memory->Start, Size);
+        }
+    }
+    
+    return Result;
+}
+
+b8
+mem_InitNumaArenas(memory_numa_arenas *NumaArenas, size_t SizePerNode, u32 Flags)
+{
+    b8 Result = true;
+    
+    *NumaArenas = {};
+    NumaArenas->SizePerNode = SizePerNode;
+    
+    u32 NodeCount = MINIMUM(mem_GetNumaMaxNode() + 1, MEM_MAX_NUMA_NODES);
+    for(u32 Node = 0; Node < NodeCount; ++Node)
+    {
+        s32 NumaNode = (NodeCount > 1) ? (s32)Node : MEM_NUMA_ANY;
+        void *OsMemory = mem_AllocateOsMemory(0, SizePerNode, Flags, 0, NumaNode);
+        if(!OsMemory)
+        {
+            Result = false;
+            break;
+        }
+        
+        NumaArenas->Arenas[Node] = mem_InitMemory(OsMemory, SizePerNode, true);
+        ++NumaArenas->NodeCount;
+    }
+    
+    if(!Result)
+    {
+        mem_ReleaseNumaArenas(NumaArenas);
+    }
+    
+    return Result;
+}
+
+memory_arena *
+mem_GetLocalNumaArena(memory_numa_arenas *NumaArenas)
+{
+    Assert(NumaArenas->NodeCount);
+    
+    u32 Node = mem_GetCurrentNumaNode();
+    if(Node >= NumaArenas->NodeCount)
+    {
+        Node = 0;
+    }
+    
+    memory_arena *Result = &NumaArenas->Arenas[Node];
+    return Result;
+}
+
+void
+mem_ReleaseNumaArenas(memory_numa_arenas *NumaArenas)
+{
+    for(u32 Node = 0; Node < NumaArenas->NodeCount; ++Node)
+    {
+        mem_DeallocateOsMemory(NumaArenas->Arenas[Node].Start, NumaArenas->SizePerNode);
+    }
+    
+    *NumaArenas = {};
+}
+
+void
+mem_PrefaultOsMemory(void *Address, size_t Size)
+{
+    size_t PageSize = mem_GetPageSize();
+    volatile u8 *Start = (volatile u8*)Address;
+    volatile u8 *End = Start + Size;
+    
+    // NOTE(amos): Write back what's already there, so the OS has to give each page real memory. Steps by page
+    // boundary rather than from Address, so a range that doesn't start on a page still touches its last page. Only
+    // bytes inside the range are written.
+    for(volatile u8 *At = Start; At < End; At = (volatile u8*)(((uintptr_t)At & ~(uintptr_t)(PageSize - 1)) + PageSize))
+    {
+        *At = *At;
+    }
+}
+
+b8
+mem_AddBlock_(memory_arena *Memory, size_t MinimumSize)
+{
+    b8 Result = false;
+    if(MinimumSize > (SIZE_MAX - sizeof(memory_block_header)))
+    {
+        return Result;
+    }
+    
+    u32 GrowthShift = MINIMUM(Memory->BlockCount, MEM_MAX_BLOCK_GROWTH);
+    size_t BlockSize = Memory->MinimumBlockSize << GrowthShift;
+    size_t NeededSize = MinimumSize + sizeof(memory_block_header);
+    if(BlockSize < NeededSize)
+    {
+        BlockSize = NeededSize;
+    }
+    
+    memory_block_header *Header = (memory_block_header*)mem_AllocateOsMemory(0, BlockSize);
+    if(Header)
+    {
+        Header->PrevStart = Memory->Start;
+        Header->PrevSize = Memory->Size;
+        Header->PrevUsed = Memory->Used;
+        Header->PrevCommitted = Memory->Committed;
+        Header->PrevDirty = Memory->Dirty;
+        Header->BlockSize = BlockSize;
+        
+        Memory->Start = Header + 1;
+        Memory->Size = BlockSize - sizeof(memory_block_header);
+        Memory->Used = 0;
+        Memory->Committed = Memory->Size;
+        Memory->Dirty = 0;
+        ++Memory->BlockCount;
+        
+        Result = true;
+    }
+    
+    return Result;
+}
+
+void
+mem_FreeBlock_(memory_arena *Memory)
+{
+    Assert(Memory->BlockCount > 0);
+    
+    memory_block_header *Header = ((memory_block_header*)Memory->Start) - 1;
+    Memory->Start = Header->PrevStart;
+    Memory->Size = Header->PrevSize;
+    Memory->Used = Header->PrevUsed;
+    Memory->Committed = Header->PrevCommitted;
+    Memory->Dirty = Header->PrevDirty;
+    --Memory->BlockCount;
+    
+    mem_DeallocateOsMemory(Header, Header->BlockSize);
+}
+
+memory_arena
+mem_CreateSubArena(memory_arena *Memory, size_t Size, size_t Alignment)
+{
+    memory_arena SubArena = {};
+    if(Size > (SIZE_MAX - (Alignment - 1)))
+    {
+        Assert(!"Sub-arena is too large.");
+        return SubArena;
+    }
+    Size = ((Size + Alignment - 1) / Alignment) * Alignment;
+    
+    SubArena.Start = mem_PushSize_(Memory, Size, true, Alignment);
+    if(SubArena.Start)
+    {
+        SubArena.Size = Size;
+        SubArena.Used = 0;
+        SubArena.Committed = Size;
+        // NOTE(amos): The push above cleared the memory.
+        SubArena.Dirty = 0;
+    }
+    
+    return SubArena;
+}
+
+void *
+mem_PushSize_(memory_arena *Memory, size_t Size, b8 ClearMemory, size_t Alignment MEM_LOCATION_ARGS)
+{
+    void* Result = 0;
+    
+    // NOTE(amos): Written so nothing is added to Size before it's checked, so a huge size fails rather than wrapping
+    // around to a small one.
+    size_t AlignmentOffset = mem_GetAlignmentOffset(Memory, Alignment);
+    size_t Left = Memory->Size - Memory->Used;
+    if(Size > Left || AlignmentOffset > (Left - Size))
+    {
+        if(!Memory->MinimumBlockSize ||
+           Size > (SIZE_MAX - (Alignment - 1)) ||
+           !mem_AddBlock_(Memory, Size + Alignment - 1))
+        {
+            Assert(!"Out of arena memory.");
+            return Result;
+        }
+        AlignmentOffset = mem_GetAlignmentOffset(Memory, Alignment);
+    }
+    
+    size_t OldUsed = Memory->Used + AlignmentOffset;
+    if((OldUsed + Size) > Memory->Committed)
+    {
+        if(!mem_CommitMemory_(Memory, OldUsed + Size))
+        {
+            Assert(!"Unable to commit arena memory.");
+            return Result;
+        }
+    }
+    
+    Result = (((u8*)Memory->Start) + OldUsed);
+    Memory->Used = OldUsed + Size;
+    
+    if(OldUsed < Memory->Dirty)
+    {
+        if(ClearMemory)
+        {
+            size_t DirtyEnd = MINIMUM(Memory->Used, Memory->Dirty);
+            mem_ZeroSize(Result, DirtyEnd - OldUsed);
+        }
+    }
+    
+    if(Memory->Used > Memory->Dirty)
+    {
+        Memory->Dirty = Memory->Used;
+    }
+    
+#if MEM_INSTRUMENT
+    mem_RecordPush_(Memory, Size, File, Line);
+#endif
+    
+    return Result;
+}
+
+void
+mem_ZeroSize(void *Address, size_t Size)
+{
+#if MEM_SSE2
+    u8 *At = (u8*)Address;
+    
+    if(Size >= 64)
+    {
+        while((uintptr_t)At & 15)
+        {
+            *At++ = 0;
+            --Size;
+        }
+        
+        __m128i Zero = _mm_setzero_si128();
+        if(Size >= MEM_NONTEMPORAL_THRESHOLD)
+        {
+            while(Size >= 64)
+            {
+                _mm_stream_si128((__m128i*)(At + 0), Zero);
+                _mm_stream_si128((__m128i*)(At + 16), Zero);
+                _mm_stream_si128((__m128i*)(At + 32), Zero);
+                _mm_stream_si128((__m128i*)(At + 48), Zero);
+                At += 64;
+                Size -= 64;
+            }
+            _mm_sfence();
+        }
+        else
+        {
+            while(Size >= 64)
+            {
+                _mm_store_si128((__m128i*)(At + 0), Zero);
+                _mm_store_si128((__m128i*)(At + 16), Zero);
+                _mm_store_si128((__m128i*)(At + 32), Zero);
+                _mm_store_si128((__m128i*)(At + 48), Zero);
+                At += 64;
+                Size -= 64;
+            }
+        }
+    }
+    
+    memset(At, 0, Size);
+#else
+    memset(Address, 0, Size);
+#endif
+}
+
+temporary_memory
+mem_BeginTemporaryMemory(memory_arena *Memory)
+{
+    temporary_memory Result = {};
+    Result.Arena = Memory;
+    Result.Used = Memory->Used;
+    Result.BlockCount = Memory->BlockCount;
+    
+    return Result;
+}
+
+void
+mem_EndTemporaryMemory(temporary_memory TempMem)
+{
+    memory_arena *Memory = TempMem.Arena;
+#if MEM_INSTRUMENT
+    size_t TotalUsed = mem_GetTotalUsed_(Memory);
+#endif
+    
+    while(Memory->BlockCount > TempMem.BlockCount)
+    {
+        mem_FreeBlock_(Memory);
+    }
+    
+    Assert(Memory->Used >= TempMem.Used);
+    Memory->Used = TempMem.Used;
+    
+#if MEM_INSTRUMENT
+    mem_RecordTemporaryMemory_(Memory, TotalUsed - mem_GetTotalUsed_(Memory));
+#endif
+}
+
+b8
+mem_PopSize(memory_arena *Memory, void *Block, size_t Size)
+{
+    b8 Result = false;
+    
+    u8 *Start = (u8*)Memory->Start;
+    u8 *At = (u8*)Block;
+    if(At >= Start && Size <= Memory->Used && (At + Size) == (Start + Memory->Used))
+    {
+        Memory->Used -= Size;
+        Result = true;
+        
+#if MEM_INSTRUMENT
+        mem_RecordPop_(Memory, Size);
+#endif
+    }
+    
+    return Result;
+}
+
+
+void
+mem_ResetMemory(memory_arena *Memory, b8 Decommit)
+{
+#if MEM_INSTRUMENT
+    mem_RecordReset_(Memory);
+#endif
+    
+    while(Memory->BlockCount > 0)
+    {
+        mem_FreeBlock_(Memory);
+    }
+    
+    Memory->Used = 0;
+    
+    if(Decommit)
+    {
+        mem_DecommitMemory(Memory, 0);
+    }
+}
+
+void *
+mem_BeginArray_(memory_arena *Memory, size_t ElementSize, memory_array *ArrayDataOut, size_t MaxElementCount)
+{
+    size_t MaxMemorySize = mem_GetMemoryLeft(Memory) - 1;
+    if(MaxElementCount)
+    {
+        MaxMemorySize = MINIMUM(MaxMemorySize, MaxElementCount*ElementSize);
+    }
+    else if(Memory->isReserved)
+    {
+        // NOTE(amos): Everything left would commit the whole reservation.
+        size_t CommittedLeft = (Memory->Committed > Memory->Used) ? (Memory->Committed - Memory->Used) : 0;
+        MaxMemorySize = MINIMUM(MaxMemorySize, MAXIMUM(CommittedLeft, MEM_COMMIT_GRANULARITY));
+    }
+    
+    ArrayDataOut->Memory = Memory;
+    ArrayDataOut->Used = Memory->Used;
+    ArrayDataOut->ElementSize = ElementSize;
+    ArrayDataOut->MaxElementCount = MaxMemorySize/ElementSize;
+    
+    // NOTE(amos): The array isn't written past ElementCount, so mem_EndArray() marks how much is dirty.
+    size_t Dirty = Memory->Dirty;
+    // NOTE(amos): Not recorded, since it would count the whole arena as used. mem_EndArray() records the real size.
+    void *Result = mem_PushSize_(Memory, MaxMemorySize, false, 1 MEM_NO_LOCATION);
+    Memory->Dirty = Dirty;
+    return Result;
+}
+
+void
+mem_EndArray(memory_array *MemoryArray, u32 ElementCount)
+{
+    Assert(ElementCount <= MemoryArray->MaxElementCount);
+           
+    MemoryArray->Memory->Used = MemoryArray->Used;
+    mem_PushSize_(MemoryArray->Memory, (MemoryArray->ElementSize*ElementCount), false);
+}
+
+thread_local memory_arena mem_ScratchArenas_[MEM_SCRATCH_ARENA_COUNT];
+
+temporary_memory
+mem_GetScratch(memory_arena **Conflicts, u32 ConflictCount)
+{
+    temporary_memory Result = {};
+    
+    for(u32 ScratchIndex = 0; ScratchIndex < MEM_SCRATCH_ARENA_COUNT; ++ScratchIndex)
+    {
+        memory_arena *Scratch = &mem_ScratchArenas_[ScratchIndex];
+        u8 *ScratchStart = (u8*)Scratch->Start;
+        
+        b8 isConflict = false;
+        for(u32 ConflictIndex = 0; ConflictIndex < ConflictCount; ++ConflictIndex)
+        {
+            memory_arena *Conflict = Conflicts[ConflictIndex];
+            if(Conflict)
+            {
+                u8 *ConflictStart = (u8*)Conflict->Start;
+                if(Conflict == Scratch ||
+                   (ScratchStart &&
+                    ConflictStart >= ScratchStart &&
+                    ConflictStart < (ScratchStart + Scratch->Size)))
+                {
+                    isConflict = true;
+                    break;
+                }
+            }
+        }
+        
+        if(!isConflict)
+        {
+            if(!Scratch->Start)
+            {
+                *Scratch = mem_InitReservedMemory(MEM_SCRATCH_RESERVE_SIZE);
+            }
+            
+            if(Scratch->Start)
+            {
+                Result = mem_BeginTemporaryMemory(Scratch);
+            }
+            break;
+        }
+    }
+    
+    Assert(Result.Arena);
+    return Result;
+}
+
+temporary_memory
+mem_GetScratch(memory_arena *Conflict)
+{
+    temporary_memory Result = mem_GetScratch(&Conflict, 1);
+    
+    return Result;
+}
+
+void
+mem_ReleaseScratch(temporary_memory Scratch)
+{
+    mem_EndTemporaryMemory(Scratch);
+}
+
+void
+mem_ReleaseThreadScratch()
+{
+    for(u32 ScratchIndex = 0; ScratchIndex < MEM_SCRATCH_ARENA_COUNT; ++ScratchIndex)
+    {
+        memory_arena *Scratch = &mem_ScratchArenas_[ScratchIndex];
+        if(Scratch->Start)
+        {
+            mem_ReleaseReservedMemory(Scratch);
+        }
+    }
+}
+
+void
+mem_InitConcurrentArena(concurrent_arena *Arena, void *Start, size_t Size, size_t ChunkSize)
+{
+    Assert(Start && !((size_t)Start % MEM_CACHE_LINE_SIZE));
+    Assert(ChunkSize && ChunkSize <= Size && !(ChunkSize % MEM_CACHE_LINE_SIZE));
+    
+    Arena->Start = Start;
+    Arena->Size = Size;
+    Arena->ChunkSize = ChunkSize;
+    Arena->Used.store(0, std::memory_order_relaxed);
+    Arena->Generation.store(1, std::memory_order_relaxed);
+}
+
+void *
+mem_PushConcurrentSize_(concurrent_arena *Arena, concurrent_chunk *Chunk, size_t Size, size_t Alignment)
+{
+    Assert(Alignment && !(Alignment & (Alignment - 1)) && Alignment <= MEM_CACHE_LINE_SIZE);
+    
+    u8 *Result = 0;
+    size_t AlignmentMask = Alignment - 1;
+    
+    if(Chunk && Size <= (Arena->ChunkSize / 4))
+    {
+        u32 Generation = Arena->Generation.load(std::memory_order_relaxed);
+        if(Chunk->Generation != Generation)
+        {
+            Chunk->At = Chunk->End = 0;
+            Chunk->Generation = Generation;
+        }
+        
+        u8 *Aligned = (u8*)(((size_t)Chunk->At + AlignmentMask) & ~AlignmentMask);
+        if(!Chunk->At || (Aligned + Size) > Chunk->End)
+        {
+            // NOTE(amos): Chunks start on a cache line, so no two threads ever write to the same line.
+            size_t Offset = Arena->Used.fetch_add(Arena->ChunkSize, std::memory_order_relaxed);
+            if((Offset + Arena->ChunkSize) > Arena->Size)
+            {
+                Assert(!"Out of concurrent arena memory.");
+                return Result;
+            }
+            
+            Chunk->At = ((u8*)Arena->Start) + Offset;
+            Chunk->End = Chunk->At + Arena->ChunkSize;
+            Aligned = Chunk->At;
+        }
+        
+        Result = Aligned;
+        Chunk->At = Aligned + Size;
+    }
+    else
+    {
+        // NOTE(amos): Round up to whole cache lines, so the next push by any thread starts on a new line.
+        size_t PushSize = (Size + MEM_CACHE_LINE_SIZE - 1) & ~((size_t)MEM_CACHE_LINE_SIZE - 1);
+        size_t Offset = Arena->Used.fetch_add(PushSize, std::memory_order_relaxed);
+        if((Offset + PushSize) > Arena->Size)
+        {
+            Assert(!"Out of concurrent arena memory.");
+            return Result;
+        }
+        
+        Result = ((u8*)Arena->Start) + Offset;
+    }
+    
+    mem_ZeroSize(Result, Size);
+    
+    return Result;
+}
+
+void
+mem_ResetConcurrentArena(concurrent_arena *Arena)
+{
+    Arena->Used.store(0, std::memory_order_relaxed);
+    Arena->Generation.fetch_add(1, std::memory_order_release);
+}
+
+memory_pool *
+mem_PushPool_(memory_arena *Arena, size_t ItemSize, size_t Alignment, u32 Count)
+{
+    Alignment = MAXIMUM(Alignment, alignof(memory_pool_item));
+    ItemSize = MAXIMUM(ItemSize, sizeof(memory_pool_item));
+    ItemSize = ((ItemSize + Alignment - 1) / Alignment) * Alignment;
+    
+    memory_pool *Pool = 0;
+    temporary_memory TempMem = mem_BeginTemporaryMemory(Arena);
+    memory_pool *NewPool = mem_PushStruct(Arena, memory_pool);
+    u8 *Items = NewPool ? (u8*)mem_PushSize_(Arena, ItemSize*Count, false, Alignment) : 0;
+    if(Items)
+    {
+        Pool = NewPool;
+        Pool->Items = Items;
+        Pool->ItemSize = ItemSize;
+        Pool->ItemCount = Count;
+        Pool->Lock.clear();
+    }
+    else
+    {
+        mem_EndTemporaryMemory(TempMem);
+    }
+    
+    return Pool;
+}
+
+inline void
+mem_LockPool_(memory_pool *Pool)
+{
+    while(Pool->Lock.test_and_set(std::memory_order_acquire))
+    {
+#if MEM_SSE2
+        _mm_pause();
+#endif
+    }
+}
+
+inline void
+mem_UnlockPool_(memory_pool *Pool)
+{
+    Pool->Lock.clear(std::memory_order_release);
+}
+
+// NOTE(amos): Pool must be locked.
+memory_pool_item *
+mem_PopPoolItem_(memory_pool *Pool)
+{
+    memory_pool_item *Result = Pool->FreeList;
+    if(Result)
+    {
+        Pool->FreeList = Result->Next;
+        --Pool->FreeCount;
+    }
+    else if(Pool->UnusedIndex < Pool->ItemCount)
+    {
+        Result = (memory_pool_item*)(Pool->Items + Pool->ItemSize*Pool->UnusedIndex++);
+    }
+    
+    return Result;
+}
+
+// NOTE(amos): Pool must be locked.
+inline void
+mem_PushPoolItem_(memory_pool *Pool, memory_pool_item *Item)
+{
+    Assert((u8*)Item >= Pool->Items && (u8*)Item < (Pool->Items + Pool->ItemSize*Pool->ItemCount));
+    Assert((((u8*)Item - Pool->Items) % Pool->ItemSize) == 0);
+    
+    Item->Next = Pool->FreeList;
+    Pool->FreeList = Item;
+    ++Pool->FreeCount;
+}
+
+void *
+mem_PoolAlloc(memory_pool *Pool)
+{
+    mem_LockPool_(Pool);
+    memory_pool_item *Result = mem_PopPoolItem_(Pool);
+    mem_UnlockPool_(Pool);
+    
+    if(Result)
+    {
+        mem_ZeroSize(Result, Pool->ItemSize);
+    }
+    
+    return Result;
+}
+
+void
+mem_PoolFree(memory_pool *Pool, void *Item)
+{
+    if(Item)
+    {
+        mem_LockPool_(Pool);
+        mem_PushPoolItem_(Pool, (memory_pool_item*)Item);
+        mem_UnlockPool_(Pool);
+    }
+}
+
+u32
+mem_GetPoolItemsLeft(memory_pool *Pool)
+{
+    mem_LockPool_(Pool);
+    u32 Result = Pool->FreeCount + (Pool->ItemCount - Pool->UnusedIndex);
+    mem_UnlockPool_(Pool);
+    
+    return Result;
+}
+
+memory_pool_cache
+mem_InitPoolCache(memory_pool *Pool)
+{
+    memory_pool_cache Cache = {};
+    Cache.Pool = Pool;
+    
+    return Cache;
+}
+
+void *
+mem_PoolAllocCached(memory_pool_cache *Cache)
+{
+    if(!Cache->Items)
+    {
+        memory_pool *Pool = Cache->Pool;
+        mem_LockPool_(Pool);
+        while(Cache->Count < (MEM_POOL_CACHE_COUNT / 2))
+        {
+            memory_pool_item *Item = mem_PopPoolItem_(Pool);
+            if(!Item)
+            {
+                break;
+            }
+            Item->Next = Cache->Items;
+            Cache->Items = Item;
+            ++Cache->Count;
+        }
+        mem_UnlockPool_(Pool);
+    }
+    
+    memory_pool_item *Result = Cache->Items;
+    if(Result)
+    {
+        Cache->Items = Result->Next;
+        --Cache->Count;
+        mem_ZeroSize(Result, Cache->Pool->ItemSize);
+    }
+    
+    return Result;
+}
+
+void
+mem_PoolFreeCached(memory_pool_cache *Cache, void *Item)
+{
+    if(Item)
+    {
+        memory_pool_item *FreeItem = (memory_pool_item*)Item;
+        FreeItem->Next = Cache->Items;
+        Cache->Items = FreeItem;
+        ++Cache->Count;
+        
+        if(Cache->Count >= MEM_POOL_CACHE_COUNT)
+        {
+            memory_pool *Pool = Cache->Pool;
+            mem_LockPool_(Pool);
+            while(Cache->Count > (MEM_POOL_CACHE_COUNT / 2))
+            {
+                memory_pool_item *ReturnItem = Cache->Items;
+                Cache->Items = ReturnItem->Next;
+                --Cache->Count;
+                mem_PushPoolItem_(Pool, ReturnItem);
+            }
+            mem_UnlockPool_(Pool);
+        }
+    }
+}
+
+void
+mem_FlushPoolCache(memory_pool_cache *Cache)
+{
+    memory_pool *Pool = Cache->Pool;
+    mem_LockPool_(Pool);
+    while(Cache->Items)
+    {
+        memory_pool_item *ReturnItem = Cache->Items;
+        Cache->Items = ReturnItem->Next;
+        mem_PushPoolItem_(Pool, ReturnItem);
+    }
+    Cache->Count = 0;
+    mem_UnlockPool_(Pool);
+}
+
+
+memory_virtual_array
+mem_InitVirtualArray_(size_t MaxCount, size_t ElementSize)
+{
+    memory_virtual_array Array = {};
+    Array.Arena = mem_InitReservedMemory(MaxCount*ElementSize);
+    Array.ElementSize = ElementSize;
+    Array.Count = 0;
+    
+    return Array;
+}
+
+void *
+mem_PushVirtualArray_(memory_virtual_array *Array, size_t Count, b8 ClearMemory MEM_LOCATION_ARGS)
+{
+    void *Result = mem_PushSize_(&Array->Arena, Count*Array->ElementSize, ClearMemory, 1 MEM_LOCATION);
+    if(Result)
+    {
+        Array->Count += Count;
+    }
+    
+    return Result;
+}
+
+void
+mem_PopVirtualArray(memory_virtual_array *Array, size_t Count)
+{
+    Assert(Count <= Array->Count);
+    
+    Array->Count -= Count;
+    Array->Arena.Used = Array->Count*Array->ElementSize;
+}
+
+void
+mem_ClearVirtualArray(memory_virtual_array *Array, b8 Decommit)
+{
+    mem_ResetMemory(&Array->Arena, Decommit);
+    Array->Count = 0;
+}
+
+void
+mem_ReleaseVirtualArray(memory_virtual_array *Array)
+{
+    mem_ReleaseReservedMemory(&Array->Arena);
+    *Array = {};
+}
+
+
+memory_arena
+mem_OpenFileMemory(char const *Path, size_t Size, u32 Version, b8 *isRestoredOut, b8 isRelocatable)
+{
+    memory_arena Memory = {};
+    b8 isRestored = false;
+    b8 isNew = false;
+    size_t MapSize = Size + MEM_FILE_HEADER_SIZE;
+    
+    u8 *Base = (u8*)mem_MapOsFile(Path, MapSize, 0, &isNew);
+    if(Base)
+    {
+        memory_file_header *Header = (memory_file_header*)Base;
+        isRestored = (Header->Magic == MEM_FILE_MAGIC &&
+                      Header->Version == Version &&
+                      Header->Size == Size &&
+                      Header->Used <= Size);
+        
+        if(isRestored && !isRelocatable && Header->BaseAddress != (u64)(size_t)Base)
+        {
+            void *SavedAddress = (void*)(size_t)Header->BaseAddress;
+            mem_UnmapOsFile(Base, MapSize);
+            
+            Base = (u8*)mem_MapOsFile(Path, MapSize, SavedAddress);
+            if(!Base)
+            {
+                isRestored = false;
+                Base = (u8*)mem_MapOsFile(Path, MapSize);
+            }
+        }
+    }
+    
+    if(Base)
+    {
+        memory_file_header *Header = (memory_file_header*)Base;
+        if(!isRestored)
+        {
+            Header->Magic = 0;
+            Header->Version = Version;
+            Header->Size = Size;
+            Header->Used = 0;
+        }
+        Header->BaseAddress = (u64)(size_t)Base;
+        
+        Memory.Start = Base + MEM_FILE_HEADER_SIZE;
+        Memory.Size = Size;
+        Memory.Used = isRestored ? (size_t)Header->Used : 0;
+        Memory.Committed = Size;
+        // NOTE(amos): Old data past Used in a reused file still needs to be cleared.
+        Memory.Dirty = isNew ? Memory.Used : Size;
+    }
+    
+    if(isRestoredOut)
+    {
+        *isRestoredOut = isRestored;
+    }
+    
+    return Memory;
+}
+
+b8
+mem_SaveFileMemory(memory_arena *Memory)
+{
+    u8 *Base = ((u8*)Memory->Start) - MEM_FILE_HEADER_SIZE;
+    memory_file_header *Header = (memory_file_header*)Base;
+    
+    Header->Magic = 0;
+    b8 Result = mem_SyncOsFile(Base, Memory->Size + MEM_FILE_HEADER_SIZE);
+    if(Result)
+    {
+        Header->Used = Memory->Used;
+        Header->Magic = MEM_FILE_MAGIC;
+        Result = mem_SyncOsFile(Base, MEM_FILE_HEADER_SIZE);
+    }
+    
+    return Result;
+}
+
+void
+mem_CloseFileMemory(memory_arena *Memory)
+{
+    if(Memory->Start)
+    {
+        mem_UnmapOsFile(((u8*)Memory->Start) - MEM_FILE_HEADER_SIZE, Memory->Size + MEM_FILE_HEADER_SIZE);
+    }
+    *Memory = {};
+}
+
+
+shared_arena
+mem_OpenSharedArena(char const *Name, size_t Size, u32 TimeoutMs)
+{
+    shared_arena Arena = {};
+    b8 isCreated = false;
+    size_t MapSize = sizeof(shared_arena_header) + Size;
+    
+    u64 StartMs = mem_GetOsMilliseconds();
+    u8 *Base = (u8*)mem_MapSharedOsMemory(Name, MapSize, &isCreated, TimeoutMs);
+    if(Base)
+    {
+        shared_arena_header *Header = (shared_arena_header*)Base;
+        if(isCreated)
+        {
+            Header->Size = Size;
+            Header->RootOffset.store(0, std::memory_order_relaxed);
+            Header->Used.store(0, std::memory_order_relaxed);
+            Header->Magic.store(MEM_SHARED_MAGIC, std::memory_order_release);
+        }
+        else
+        {
+            // NOTE(amos): The creating process may still be filling in the header, or may have died before it finished.
+            while(Header->Magic.load(std::memory_order_acquire) != MEM_SHARED_MAGIC &&
+                  (mem_GetOsMilliseconds() - StartMs) < TimeoutMs)
+            {
+                mem_YieldOsThread();
+            }
+        }
+        
+        if(Header->Magic.load(std::memory_order_acquire) == MEM_SHARED_MAGIC &&
+           Header->Size == Size)
+        {
+            Arena.Header = Header;
+            Arena.Start = Base + sizeof(shared_arena_header);
+            Arena.Size = Size;
+        }
+        else
+        {
+            // NOTE(amos): Decided by another process, so not an Assert.
+            mem_UnmapSharedOsMemory(Base, MapSize);
+        }
+    }
+    
+    return Arena;
+}
+
+void *
+mem_PushSharedSize_(shared_arena *Arena, size_t Size, size_t Alignment)
+{
+    Assert(Alignment && !(Alignment & (Alignment - 1)));
+    
+    u8 *Result = 0;
+    size_t AlignmentMask = Alignment - 1;
+    
+    // NOTE(amos): The start of the arena is cache line aligned in every process, so offsets align the same everywhere.
+    u64 Used = Arena->Header->Used.load(std::memory_order_relaxed);
+    u64 Offset;
+    do
+    {
+        Offset = (Used + AlignmentMask) & ~(u64)AlignmentMask;
+        if((Offset + Size) > Arena->Size)
+        {
+            Assert(!"Out of shared arena memory.");
+            return Result;
+        }
+    } while(!Arena->Header->Used.compare_exchange_weak(Used, Offset + Size, std::memory_order_relaxed));
+    
+    Result = Arena->Start + Offset;
+    mem_ZeroSize(Result, Size);
+    
+    return Result;
+}
+
+void
+mem_SetSharedRoot(shared_arena *Arena, void *Root)
+{
+    // NOTE(amos): Offset 0 is reserved for no root, so store it one past.
+    u64 RootOffset = Root ? mem_GetSharedOffset(Arena, Root) + 1 : 0;
+    Arena->Header->RootOffset.store(RootOffset, std::memory_order_release);
+}
+
+void *
+mem_GetSharedRoot(shared_arena *Arena)
+{
+    u64 RootOffset = Arena->Header->RootOffset.load(std::memory_order_acquire);
+    
+    return RootOffset ? mem_GetSharedAddress(Arena, RootOffset - 1) : 0;
+}
+
+void
+mem_ResetSharedArena(shared_arena *Arena)
+{
+    Arena->Header->RootOffset.store(0, std::memory_order_relaxed);
+    Arena->Header->Used.store(0, std::memory_order_release);
+}
+
+void
+mem_CloseSharedArena(shared_arena *Arena)
+{
+    if(Arena->Header)
+    {
+        mem_UnmapSharedOsMemory(Arena->Header, sizeof(shared_arena_header) + Arena->Size);
+    }
+    *Arena = {};
+}
+
+
+b8
+mem_CreateRing(memory_ring *Ring, size_t Size)
+{
+    Size = ((Size + MEM_COMMIT_GRANULARITY - 1) / MEM_COMMIT_GRANULARITY) * MEM_COMMIT_GRANULARITY;
+    
+    Ring->Start = (u8*)mem_AllocateDoubleMappedOsMemory(Size);
+    Ring->Size = Ring->Start ? Size : 0;
+    Ring->WritePosition.store(0, std::memory_order_relaxed);
+    Ring->ReadPosition.store(0, std::memory_order_relaxed);
+    
+    return (Ring->Start != 0);
+}
+
+void
+mem_ReleaseRing(memory_ring *Ring)
+{
+    if(Ring->Start)
+    {
+        mem_DeallocateDoubleMappedOsMemory(Ring->Start, Ring->Size);
+    }
+    Ring->Start = 0;
+    Ring->Size = 0;
+}
+
+void *
+mem_BeginRingWrite(memory_ring *Ring, size_t Size)
+{
+    void *Result = 0;
+    
+    u64 Write = Ring->WritePosition.load(std::memory_order_relaxed);
+    u64 Read = Ring->ReadPosition.load(std::memory_order_acquire);
+    if(Ring->Size && (Write - Read + Size) <= Ring->Size)
+    {
+        Result = Ring->Start + (Write % Ring->Size);
+    }
+    
+    return Result;
+}
+
+void
+mem_EndRingWrite(memory_ring *Ring, size_t Size)
+{
+    u64 Write = Ring->WritePosition.load(std::memory_order_relaxed);
+    Assert((Write + Size - Ring->ReadPosition.load(std::memory_order_relaxed)) <= Ring->Size);
+    
+    Ring->WritePosition.store(Write + Size, std::memory_order_release);
+}
+
+void *
+mem_BeginRingRead(memory_ring *Ring, size_t *SizeOut)
+{
+    *SizeOut = 0;
+    if(!Ring->Size)
+    {
+        return 0;
+    }
+    
+    u64 Read = Ring->ReadPosition.load(std::memory_order_relaxed);
+    u64 Write = Ring->WritePosition.load(std::memory_order_acquire);
+    *SizeOut = (size_t)(Write - Read);
+    
+    return Ring->Start + (Read % Ring->Size);
+}
+
+void
+mem_EndRingRead(memory_ring *Ring, size_t Size)
+{
+    u64 Read = Ring->ReadPosition.load(std::memory_order_relaxed);
+    Assert(Size <= (Ring->WritePosition.load(std::memory_order_relaxed) - Read));
+    
+    Ring->ReadPosition.store(Read + Size, std::memory_order_release);
+}
+
+
+size_t
+mem_GetTotalUsed_(memory_arena *Memory)
+{
+    size_t Result = Memory->Used;
+    
+    void *Start = Memory->Start;
+    for(u32 Block = 0; Block < Memory->BlockCount; ++Block)
+    {
+        memory_block_header *Header = ((memory_block_header*)Start) - 1;
+        Result += Header->PrevUsed;
+        Start = Header->PrevStart;
+    }
+    
+    return Result;
+}
+
+#if MEM_INSTRUMENT
+#include <stdlib.h>
+
+memory_site_stats mem_SiteStats_[MEM_INSTRUMENT_SITE_COUNT];
+memory_arena_stats mem_ArenaStats_[MEM_INSTRUMENT_ARENA_COUNT];
+// NOTE(amos): Records that had nowhere to go once a table filled up, so the report can say it's incomplete.
+u64 mem_DroppedSiteCount_;
+u64 mem_DroppedArenaCount_;
+std::atomic_flag mem_InstrumentLock_ = ATOMIC_FLAG_INIT;
+
+inline void
+mem_LockInstrument_()
+{
+    while(mem_InstrumentLock_.test_and_set(std::memory_order_acquire))
+    {
+#if MEM_SSE2
+        _mm_pause();
+#endif
+    }
+}
+
+inline void
+mem_UnlockInstrument_()
+{
+    mem_InstrumentLock_.clear(std::memory_order_release);
+}
+
+// NOTE(amos): Each file that includes a header has its own copy of the file name string, so sites are matched by
+// contents rather than by pointer.
+memory_site_stats *
+mem_FindSiteStats_(char const *File, u32 Line)
+{
+    u32 Hash = Line * 2654435761u;
+    for(char const *At = File; *At; ++At)
+    {
+        Hash = (Hash ^ (u8)*At) * 16777619u;
+    }
+    
+    for(u32 Probe = 0; Probe < MEM_INSTRUMENT_SITE_COUNT; ++Probe)
+    {
+        memory_site_stats *Site = &mem_SiteStats_[(Hash + Probe) % MEM_INSTRUMENT_SITE_COUNT];
+        if(!Site->File)
+        {
+            Site->File = File;
+            Site->Line = Line;
+            return Site;
+        }
+        if(Site->Line == Line && (Site->File == File || strcmp(Site->File, File) == 0))
+        {
+            return Site;
+        }
+    }
+    
+    ++mem_DroppedSiteCount_;
+    return 0;
+}
+
+memory_arena_stats *
+mem_FindArenaStats_(memory_arena *Memory)
+{
+    size_t Hash = ((size_t)Memory >> 4) * 2654435761u;
+    for(u32 Probe = 0; Probe < MEM_INSTRUMENT_ARENA_COUNT; ++Probe)
+    {
+        memory_arena_stats *Stats = &mem_ArenaStats_[(Hash + Probe) % MEM_INSTRUMENT_ARENA_COUNT];
+        if(!Stats->Arena)
+        {
+            Stats->Arena = Memory;
+            return Stats;
+        }
+        if(Stats->Arena == Memory)
+        {
+            return Stats;
+        }
+    }
+    
+    ++mem_DroppedArenaCount_;
+    return 0;
+}
+
+void
+mem_RecordPush_(memory_arena *Memory, size_t Size, char const *File, u32 Line)
+{
+    if(File)
+    {
+        mem_LockInstrument_();
+        
+        memory_site_stats *Site = mem_FindSiteStats_(File, Line);
+        if(Site)
+        {
+            ++Site->PushCount;
+            Site->TotalSize += Size;
+            Site->MaxSize = MAXIMUM(Site->MaxSize, Size);
+        }
+        
+        memory_arena_stats *Stats = mem_FindArenaStats_(Memory);
+        if(Stats)
+        {
+            ++Stats->PushCount;
+            Stats->PeakUsed = MAXIMUM(Stats->PeakUsed, mem_GetTotalUsed_(Memory));
+        }
+        
+        mem_UnlockInstrument_();
+    }
+}
+
+void
+mem_RecordReset_(memory_arena *Memory)
+{
+    mem_LockInstrument_();
+    memory_arena_stats *Stats = mem_FindArenaStats_(Memory);
+    if(Stats)
+    {
+        ++Stats->ResetCount;
+    }
+    mem_UnlockInstrument_();
+}
 
-@param Memory A pointer to the existing `memory_arena` within which to create a new arena.
-@param Size The amount of memory to use for the arena.
-@return A new `memory_arena` that may be used just as the parent arena.
-**/
-memory_arena
-mem_CreateSubArena(memory_arena *Memory, size_t Size);
+void
+mem_RecordTemporaryMemory_(memory_arena *Memory, size_t Size)
+{
+    mem_LockInstrument_();
+    memory_arena_stats *Stats = mem_FindArenaStats_(Memory);
+    if(Stats)
+    {
+        ++Stats->TemporaryCount;
+        Stats->TemporaryTotalSize += Size;
+        Stats->TemporaryMaxSize = MAXIMUM(Stats->TemporaryMaxSize, Size);
+    }
+    mem_UnlockInstrument_();
+}
 
-/** @private **/
-void *mem_BeginArray_(memory_arena *Memory, size_t ElementSize, memory_array *MemoryArrayOut);
+void
+mem_RecordPop_(memory_arena *Memory, size_t Size)
+{
+    mem_LockInstrument_();
+    memory_arena_stats *Stats = mem_FindArenaStats_(Memory);
+    if(Stats)
+    {
+        ++Stats->PopCount;
+        Stats->PopTotalSize += Size;
+    }
+    mem_UnlockInstrument_();
+}
 
+int
+mem_CompareSites_(void const *A, void const *B)
+{
+    u64 SizeA = ((memory_site_stats const *)A)->TotalSize;
+    u64 SizeB = ((memory_site_stats const *)B)->TotalSize;
+    
+    return (SizeA < SizeB) - (SizeA > SizeB);
+}
 
-/** @brief End a previously started array, setting memory size to the given element count.
+int
+mem_CompareArenas_(void const *A, void const *B)
+{
+    u64 PeakA = ((memory_arena_stats const *)A)->PeakUsed;
+    u64 PeakB = ((memory_arena_stats const *)B)->PeakUsed;
+    
+    return (PeakA < PeakB) - (PeakA > PeakB);
+}
 
+// NOTE(amos): Sorted copies of the tables, so reports don't hold the lock while printing. Static, since they're too big for the stack.
+static memory_site_stats mem_SortedSites_[MEM_INSTRUMENT_SITE_COUNT];
+static memory_arena_stats mem_SortedArenas_[MEM_INSTRUMENT_ARENA_COUNT];
 
-**/
-void mem_EndArray(memory_array *MemoryArray, u32 ElementCount);
+void
+mem_SortStats_(u32 *SiteCountOut, u32 *ArenaCountOut, u64 *DroppedSiteCountOut, u64 *DroppedArenaCountOut)
+{
+    u32 SiteCount = 0;
+    u32 ArenaCount = 0;
+    
+    mem_LockInstrument_();
+    *DroppedSiteCountOut = mem_DroppedSiteCount_;
+    *DroppedArenaCountOut = mem_DroppedArenaCount_;
+    for(u32 Index = 0; Index < MEM_INSTRUMENT_SITE_COUNT; ++Index)
+    {
+        if(mem_SiteStats_[Index].PushCount)
+        {
+            mem_SortedSites_[SiteCount++] = mem_SiteStats_[Index];
+        }
+    }
+    for(u32 Index = 0; Index < MEM_INSTRUMENT_ARENA_COUNT; ++Index)
+    {
+        if(mem_ArenaStats_[Index].Arena)
+        {
+            mem_SortedArenas_[ArenaCount++] = mem_ArenaStats_[Index];
+        }
+    }
+    mem_UnlockInstrument_();
+    
+    qsort(mem_SortedSites_, SiteCount, sizeof(memory_site_stats), mem_CompareSites_);
+    qsort(mem_SortedArenas_, ArenaCount, sizeof(memory_arena_stats), mem_CompareArenas_);
+    
+    *SiteCountOut = SiteCount;
+    *ArenaCountOut = ArenaCount;
+}
 
+void
+mem_WriteJsonString_(FILE *Out, char const *String)
+{
+    fputc('"', Out);
+    for(char const *At = String; At && *At; ++At)
+    {
+        if(*At == '"' || *At == '\\')
+        {
+            fputc('\\', Out);
+        }
+        fputc(*At, Out);
+    }
+    fputc('"', Out);
+}
 #endif
 
-#if _WINDOWS
-#include "ab_memory_win32.h"
-#elif _LINUX
-#include "ab_memory_linux.h"
+void
+mem_SetArenaName(memory_arena *Memory, char const *Name)
+{
+#if MEM_INSTRUMENT
+    mem_LockInstrument_();
+    memory_arena_stats *Stats = mem_FindArenaStats_(Memory);
+    if(Stats)
+    {
+        Stats->Name = Name;
+    }
+    mem_UnlockInstrument_();
 #endif
+}
 
-
-#if defined(MEMORY_SRC)
-
-memory_arena
-mem_InitMemory(void *Start, size_t Size)
+void
+mem_PrintMemoryReport(FILE *Out, u32 MaxSiteCount)
 {
-    Assert(Start);
+#if MEM_INSTRUMENT
+    u32 SiteCount, ArenaCount;
+    u64 DroppedSiteCount, DroppedArenaCount;
+    mem_SortStats_(&SiteCount, &ArenaCount, &DroppedSiteCount, &DroppedArenaCount);
     
-    memory_arena Memory = {};
-    Memory.Start = Start;
-    Memory.Size = Size;
-    Memory.Used = 0;
+    if(DroppedSiteCount || DroppedArenaCount)
+    {
+        fprintf(Out, "Tables full: %llu arena records and %llu site records were dropped.\n\n",
+                (unsigned long long)DroppedArenaCount, (unsigned long long)DroppedSiteCount);
+    }
     
-    return Memory;
-}
-
-memory_arena
-mem_CreateSubArena(memory_arena *Memory, size_t Size)
-{
-    memory_arena SubArena = {};
-    SubArena.Start = mem_PushSize(Memory, Size);
-    SubArena.Size = Size;
-    SubArena.Used = 0;
+    fprintf(Out, "%-24s %14s %12s %8s %10s %14s %14s %10s %14s\n", "Arena", "Peak Used", "Pushes", "Resets", "Temp", "Temp Total", "Temp Max", "Pops", "Pop Total");
+    for(u32 Index = 0; Index < ArenaCount; ++Index)
+    {
+        memory_arena_stats *Stats = &mem_SortedArenas_[Index];
+        char Name[32];
+        if(Stats->Name)
+        {
+            snprintf(Name, sizeof(Name), "%s", Stats->Name);
+        }
+        else
+        {
+            snprintf(Name, sizeof(Name), "%p", (void*)Stats->Arena);
+        }
+        fprintf(Out, "%-24s %14llu %12llu %8llu %10llu %14llu %14llu %10llu %14llu\n", Name,
+                (unsigned long long)Stats->PeakUsed, (unsigned long long)Stats->PushCount,
+                (unsigned long long)Stats->ResetCount, (unsigned long long)Stats->TemporaryCount,
+                (unsigned long long)Stats->TemporaryTotalSize, (unsigned long long)Stats->TemporaryMaxSize,
+                (unsigned long long)Stats->PopCount, (unsigned long long)Stats->PopTotalSize);
+    }
     
-    return SubArena;
+    fprintf(Out, "\n%14s %12s %12s  %s\n", "Total Size", "Pushes", "Max Size", "Location");
+    for(u32 Index = 0; Index < SiteCount && Index < MaxSiteCount; ++Index)
+    {
+        memory_site_stats *Site = &mem_SortedSites_[Index];
+        fprintf(Out, "%14llu %12llu %12llu  %s:%u\n",
+                (unsigned long long)Site->TotalSize, (unsigned long long)Site->PushCount,
+                (unsigned long long)Site->MaxSize, Site->File, Site->Line);
+    }
+#endif
 }
 
-void *
-mem_PushSize_(memory_arena *Memory, size_t Size, b8 ClearMemory)
+void
+mem_WriteMemoryReportJson(FILE *Out)
 {
-    void* Result = 0;
+#if MEM_INSTRUMENT
+    u32 SiteCount, ArenaCount;
+    u64 DroppedSiteCount, DroppedArenaCount;
+    mem_SortStats_(&SiteCount, &ArenaCount, &DroppedSiteCount, &DroppedArenaCount);
     
-    Assert((Memory->Size - Memory->Used) > Size);
-    Result = (((u8*)Memory->Start) + Memory->Used);
-    Memory->Used += Size;
-    
-    if(ClearMemory)
+    fprintf(Out, "{\n  \"dropped_arenas\": %llu,\n  \"dropped_sites\": %llu,\n  \"arenas\": [",
+            (unsigned long long)DroppedArenaCount, (unsigned long long)DroppedSiteCount);
+    for(u32 Index = 0; Index < ArenaCount; ++Index)
     {
-        for(size_t Index = 0; Index < Size; ++Index)
+        memory_arena_stats *Stats = &mem_SortedArenas_[Index];
+        fprintf(Out, "%s\n    {\"name\": ", Index ? "," : "");
+        if(Stats->Name)
+        {
+            mem_WriteJsonString_(Out, Stats->Name);
+        }
+        else
         {
-            ((u8*)Result)[Index] = 0;
+            fprintf(Out, "null");
         }
+        fprintf(Out, ", \"address\": \"%p\", \"peak_used\": %llu, \"pushes\": %llu, \"resets\": %llu, "
+                "\"temporary_count\": %llu, \"temporary_total\": %llu, \"temporary_max\": %llu, "
+                "\"pops\": %llu, \"pop_total\": %llu}",
+                (void*)Stats->Arena, (unsigned long long)Stats->PeakUsed, (unsigned long long)Stats->PushCount,
+                (unsigned long long)Stats->ResetCount, (unsigned long long)Stats->TemporaryCount,
+                (unsigned long long)Stats->TemporaryTotalSize, (unsigned long long)Stats->TemporaryMaxSize,
+                (unsigned long long)Stats->PopCount, (unsigned long long)Stats->PopTotalSize);
     }
     
-    return Result;
+    fprintf(Out, "\n  ],\n  \"sites\": [");
+    for(u32 Index = 0; Index < SiteCount; ++Index)
+    {
+        memory_site_stats *Site = &mem_SortedSites_[Index];
+        fprintf(Out, "%s\n    {\"file\": ", Index ? "," : "");
+        mem_WriteJsonString_(Out, Site->File);
+        fprintf(Out, ", \"line\": %u, \"pushes\": %llu, \"total_size\": %llu, \"max_size\": %llu}",
+                Site->Line, (unsigned long long)Site->PushCount,
+                (unsigned long long)Site->TotalSize, (unsigned long long)Site->MaxSize);
+    }
+    fprintf(Out, "\n  ]\n}\n");
+#endif
 }
 
-temporary_memory
-mem_BeginTemporaryMemory(memory_arena *Memory)
+void
+mem_ClearMemoryReport()
 {
-    temporary_memory Result = {};
-    Result.Arena = Memory;
-    Result.Used = Memory->Used;
+#if MEM_INSTRUMENT
+    mem_LockInstrument_();
+    memset(mem_SiteStats_, 0, sizeof(mem_SiteStats_));
+    mem_DroppedSiteCount_ = 0;
+    mem_DroppedArenaCount_ = 0;
+    for(u32 Index = 0; Index < MEM_INSTRUMENT_ARENA_COUNT; ++Index)
+    {
+        memory_arena_stats *Stats = &mem_ArenaStats_[Index];
+        memory_arena *Arena = Stats->Arena;
+        char const *Name = Stats->Name;
+        *Stats = {};
+        Stats->Arena = Arena;
+        Stats->Name = Name;
+    }
+    mem_UnlockInstrument_();
+#endif
+}
+
+
+void
+mem_InitFrameArenas(memory_frame_arenas *Frames, void *Start, size_t Size, b8 isZeroed)
+{
+    size_t HalfSize = (Size / 2) & ~(size_t)(MEM_CACHE_LINE_SIZE - 1);
+    Frames->Arenas[0] = mem_InitMemory(Start, HalfSize, isZeroed);
+    Frames->Arenas[1] = mem_InitMemory((u8*)Start + HalfSize, HalfSize, isZeroed);
+    Frames->Roots[0] = 0;
+    Frames->Roots[1] = 0;
+    Frames->CurrentFrame.store(0);
+    Frames->PublishedFrame.store(0);
+    Frames->ReadFrame.store(0);
+}
+
+memory_arena *
+mem_BeginFrame(memory_frame_arenas *Frames)
+{
+    u64 Frame = Frames->CurrentFrame.load(std::memory_order_relaxed) + 1;
+    Frames->CurrentFrame.store(Frame);
+    
+    // NOTE(amos): Paired with the checks in mem_BeginFrameRead(). Either the consumer sees the new frame and backs
+    // off, or this sees the consumer reading the frame before last and waits for it.
+    u64 ReadFrame = Frames->ReadFrame.load();
+    while(ReadFrame && ReadFrame + 2 <= Frame)
+    {
+#if MEM_SSE2
+        _mm_pause();
+#endif
+        ReadFrame = Frames->ReadFrame.load();
+    }
+    
+    memory_arena *Result = &Frames->Arenas[Frame & 1];
+    mem_ResetMemory(Result);
+    Frames->Roots[Frame & 1] = 0;
     
     return Result;
 }
 
+memory_arena *
+mem_GetCurrentFrame(memory_frame_arenas *Frames)
+{
+    u64 Frame = Frames->CurrentFrame.load(std::memory_order_relaxed);
+    return &Frames->Arenas[Frame & 1];
+}
+
+memory_arena *
+mem_GetPreviousFrame(memory_frame_arenas *Frames)
+{
+    u64 Frame = Frames->CurrentFrame.load(std::memory_order_relaxed);
+    return &Frames->Arenas[(Frame + 1) & 1];
+}
+
 void
-mem_EndTemporaryMemory(temporary_memory TempMem)
+mem_PublishFrame(memory_frame_arenas *Frames, void *Root)
 {
-    TempMem.Arena->Used = TempMem.Used;
+    u64 Frame = Frames->CurrentFrame.load(std::memory_order_relaxed);
+    Frames->Roots[Frame & 1] = Root;
+    Frames->PublishedFrame.store(Frame, std::memory_order_release);
 }
 
+void *
+mem_BeginFrameRead(memory_frame_arenas *Frames, u64 *FrameOut)
+{
+    for(;;)
+    {
+        u64 Frame = Frames->PublishedFrame.load(std::memory_order_acquire);
+        if(!Frame)
+        {
+            return 0;
+        }
+        
+        Frames->ReadFrame.store(Frame);
+        if(Frames->CurrentFrame.load() < Frame + 2)
+        {
+            // NOTE(amos): The producer can't reset this frame's arena now until mem_EndFrameRead().
+            if(FrameOut)
+            {
+                *FrameOut = Frame;
+            }
+            return Frames->Roots[Frame & 1];
+        }
+        
+        // NOTE(amos): The producer may already be resetting this frame's arena; try the newer frame. If nothing newer
+        // was published, the producer skipped a publish, and there's no frame left to read.
+        Frames->ReadFrame.store(0);
+        if(Frames->PublishedFrame.load(std::memory_order_acquire) == Frame)
+        {
+            return 0;
+        }
+    }
+}
 
 void
-mem_ResetMemory(memory_arena *Memory)
+mem_EndFrameRead(memory_frame_arenas *Frames)
 {
-    Memory->Used = 0;
+    Frames->ReadFrame.store(0, std::memory_order_release);
 }
 
-inline size_t
-mem_GetMemoryLeft(memory_arena *Memory)
+
+static std::atomic<b8> mem_isSoftDirtyInUse_(false);
+
+// NOTE(amos): Four lanes of the xxHash64 round, so it runs about as fast as the page can be read.
+u64
+mem_HashPage_(void *Page)
 {
-    size_t Result = Memory->Size - Memory->Used;
+    const u64 Prime1 = 0x9E3779B185EBCA87ULL;
+    const u64 Prime2 = 0xC2B2AE3D27D4EB4FULL;
+    
+    u64 const *Words = (u64 const *)Page;
+    u64 Lanes[4] = {Prime1 + Prime2, Prime2, 0, Prime1};
+    for(u32 Index = 0; Index < MEM_CHECKPOINT_PAGE_SIZE / sizeof(u64); Index += 4)
+    {
+        for(u32 Lane = 0; Lane < 4; ++Lane)
+        {
+            u64 Value = Lanes[Lane] + Words[Index + Lane]*Prime2;
+            Lanes[Lane] = ((Value << 31) | (Value >> 33))*Prime1;
+        }
+    }
+    
+    u64 Result = Lanes[0] ^ (Lanes[1]*Prime1) ^ (Lanes[2]*Prime2) ^ ((Lanes[3] << 17) | (Lanes[3] >> 47));
+    Result ^= Result >> 29;
+    Result *= Prime2;
+    Result ^= Result >> 32;
     
     return Result;
 }
 
-void *
-mem_BeginArray_(memory_arena *Memory, size_t ElementSize, memory_array *ArrayDataOut)
+b8
+mem_OpenCheckpoints(memory_checkpoint *Checkpoint, memory_arena *Arena, char const *Path, u32 Version, b8 isHashing)
 {
-    size_t MaxMemorySize = mem_GetMemoryLeft(Memory) - 1;
+    *Checkpoint = {};
     
-    ArrayDataOut->Memory = Memory;
-    ArrayDataOut->Used = Memory->Used;
-    ArrayDataOut->ElementSize = ElementSize;
-    ArrayDataOut->MaxElementCount = MaxMemorySize/ElementSize;
+    size_t PathLength = strlen(Path);
+    if(Arena->BlockCount != 0 ||
+       ((size_t)Arena->Start % MEM_CHECKPOINT_PAGE_SIZE) != 0 ||
+       (Arena->Size % MEM_CHECKPOINT_PAGE_SIZE) != 0 ||
+       PathLength > MAX_FILENAME_SIZE)
+    {
+        return false;
+    }
+    
+    Checkpoint->Arena = Arena;
+    memcpy(Checkpoint->Path, Path, PathLength + 1);
+    Checkpoint->Version = Version;
+    Checkpoint->PageCount = Arena->Size / MEM_CHECKPOINT_PAGE_SIZE;
+    
+    if(!isHashing && !mem_isSoftDirtyInUse_.exchange(true))
+    {
+        // NOTE(amos): Check the OS really tracks soft-dirty bits, by writing to a page on the stack after clearing.
+        volatile u64 Probe = 0;
+        u8 isProbeDirty = 0;
+        if(mem_ClearOsSoftDirty())
+        {
+            Probe = 1;
+            void *ProbePage = (void*)((size_t)&Probe & ~(size_t)(MEM_CHECKPOINT_PAGE_SIZE - 1));
+            mem_GetOsSoftDirtyPages(ProbePage, 1, &isProbeDirty);
+        }
+        
+        Checkpoint->isSoftDirty = (isProbeDirty != 0);
+        if(!Checkpoint->isSoftDirty)
+        {
+            mem_isSoftDirtyInUse_.store(false);
+        }
+    }
+    
+    size_t HashSize = Checkpoint->isSoftDirty ? 0 : Checkpoint->PageCount*sizeof(u64);
+    Checkpoint->BookkeepingSize = HashSize + Checkpoint->PageCount*(sizeof(u64) + sizeof(u8));
+    u8 *Bookkeeping = (u8*)mem_AllocateOsMemory(NULL, Checkpoint->BookkeepingSize);
+    if(!Bookkeeping)
+    {
+        mem_CloseCheckpoints(Checkpoint);
+        return false;
+    }
+    
+    Checkpoint->PageIndexes = (u64*)Bookkeeping;
+    Checkpoint->PageHashes = HashSize ? (u64*)(Bookkeeping + Checkpoint->PageCount*sizeof(u64)) : 0;
+    Checkpoint->DirtyPages = Bookkeeping + Checkpoint->PageCount*sizeof(u64) + HashSize;
+    
+    return true;
+}
+
+b8
+mem_WriteCheckpoint(memory_checkpoint *Checkpoint, b8 isFull, size_t *PageCountOut)
+{
+    memory_arena *Arena = Checkpoint->Arena;
+    u8 *Start = (u8*)Arena->Start;
+    size_t UsedPages = (Arena->Used + MEM_CHECKPOINT_PAGE_SIZE - 1) / MEM_CHECKPOINT_PAGE_SIZE;
+    size_t LastUsedPages = (Checkpoint->LastUsed + MEM_CHECKPOINT_PAGE_SIZE - 1) / MEM_CHECKPOINT_PAGE_SIZE;
+    isFull = isFull || !Checkpoint->File;
+    // NOTE(amos): Decommitted pages that are pushed again read as 0 without being written, so their soft-dirty bits
+    // stay clear, and the checkpoint file still has what was there before. Start over rather than miss them.
+    isFull = isFull || (Checkpoint->isSoftDirty && Arena->DecommitCount != Checkpoint->LastDecommitCount);
+    
+    // NOTE(amos): Pages past the last checkpoint's Used weren't saved, even if they haven't changed since.
+    size_t DirtyCount = 0;
+    if(isFull)
+    {
+        memset(Checkpoint->DirtyPages, 1, UsedPages);
+    }
+    else if(Checkpoint->isSoftDirty)
+    {
+        if(!mem_GetOsSoftDirtyPages(Start, UsedPages, Checkpoint->DirtyPages))
+        {
+            return false;
+        }
+        memset(Checkpoint->DirtyPages + MINIMUM(LastUsedPages, UsedPages), 1, UsedPages - MINIMUM(LastUsedPages, UsedPages));
+    }
+    
+    for(size_t Page = 0; Page < UsedPages; ++Page)
+    {
+        if(Checkpoint->PageHashes)
+        {
+            u64 Hash = mem_HashPage_(Start + Page*MEM_CHECKPOINT_PAGE_SIZE);
+            if(isFull || Page >= LastUsedPages || Hash != Checkpoint->PageHashes[Page])
+            {
+                Checkpoint->DirtyPages[Page] = 1;
+            }
+            else
+            {
+                Checkpoint->DirtyPages[Page] = 0;
+            }
+            Checkpoint->PageHashes[Page] = Hash;
+        }
+        
+        if(Checkpoint->DirtyPages[Page])
+        {
+            Checkpoint->PageIndexes[DirtyCount++] = Page;
+        }
+    }
+    
+    char TempPath[MAX_FILENAME_SIZE + 5];
+    FILE *File = Checkpoint->File;
+    if(isFull)
+    {
+        snprintf(TempPath, sizeof(TempPath), "%s.tmp", Checkpoint->Path);
+        File = fopen(TempPath, "wb");
+        if(!File)
+        {
+            return false;
+        }
+        
+        memory_checkpoint_header Header = {};
+        Header.Magic = MEM_CHECKPOINT_MAGIC;
+        Header.Size = Arena->Size;
+        Header.Version = Checkpoint->Version;
+        Header.PageSize = MEM_CHECKPOINT_PAGE_SIZE;
+        fwrite(&Header, sizeof(Header), 1, File);
+    }
+    
+    u64 Sequence = Checkpoint->Sequence + 1;
+    memory_checkpoint_record Record = {};
+    Record.Magic = MEM_CHECKPOINT_RECORD_MAGIC;
+    Record.Sequence = Sequence;
+    Record.Used = Arena->Used;
+    Record.PageCount = DirtyCount;
+    
+    b8 Result = fwrite(&Record, sizeof(Record), 1, File) == 1;
+    Result = Result && fwrite(Checkpoint->PageIndexes, sizeof(u64), DirtyCount, File) == DirtyCount;
+    for(size_t Index = 0; Result && Index < DirtyCount; ++Index)
+    {
+        Result = fwrite(Start + Checkpoint->PageIndexes[Index]*MEM_CHECKPOINT_PAGE_SIZE, MEM_CHECKPOINT_PAGE_SIZE, 1, File) == 1;
+    }
+    Result = Result && fwrite(&Sequence, sizeof(Sequence), 1, File) == 1;
+    Result = Result && mem_SyncOsFileStream(File);
+    
+    if(isFull)
+    {
+        Result = Result && mem_ReplaceOsFile(TempPath, Checkpoint->Path);
+        if(Result)
+        {
+            if(Checkpoint->File)
+            {
+                fclose(Checkpoint->File);
+            }
+            Checkpoint->File = File;
+        }
+        else
+        {
+            fclose(File);
+            remove(TempPath);
+        }
+    }
+    
+    if(Result)
+    {
+        // NOTE(amos): Cleared only once everything is safely written, so a failed checkpoint is retried in full.
+        if(Checkpoint->isSoftDirty)
+        {
+            mem_ClearOsSoftDirty();
+        }
+        Checkpoint->Sequence = Sequence;
+        Checkpoint->LastUsed = Arena->Used;
+        Checkpoint->LastDecommitCount = Arena->DecommitCount;
+        
+        if(PageCountOut)
+        {
+            *PageCountOut = DirtyCount;
+        }
+    }
+    else if(Checkpoint->File)
+    {
+        // NOTE(amos): The file may end with part of a checkpoint, and the page hashes may match pages that weren't
+        // saved, so start over with a full checkpoint.
+        fclose(Checkpoint->File);
+        Checkpoint->File = 0;
+    }
     
-    void *Result = mem_PushSize_(Memory, MaxMemorySize, false);
     return Result;
 }
 
 void
-mem_EndArray(memory_array *MemoryArray, u32 ElementCount)
+mem_CloseCheckpoints(memory_checkpoint *Checkpoint)
 {
-    Assert(ElementCount <= MemoryArray->MaxElementCount);
-           
-    MemoryArray->Memory->Used = MemoryArray->Used;
-    mem_PushSize_(MemoryArray->Memory, (MemoryArray->ElementSize*ElementCount), false);
+    if(Checkpoint->File)
+    {
+        fclose(Checkpoint->File);
+    }
+    if(Checkpoint->PageIndexes)
+    {
+        mem_DeallocateOsMemory(Checkpoint->PageIndexes, Checkpoint->BookkeepingSize);
+    }
+    if(Checkpoint->isSoftDirty)
+    {
+        mem_isSoftDirtyInUse_.store(false);
+    }
+    *Checkpoint = {};
+}
+
+b8
+mem_RestoreCheckpoint(memory_arena *Arena, char const *Path, u32 Version)
+{
+    if(Arena->BlockCount != 0 ||
+       ((size_t)Arena->Start % MEM_CHECKPOINT_PAGE_SIZE) != 0 ||
+       (Arena->Size % MEM_CHECKPOINT_PAGE_SIZE) != 0)
+    {
+        return false;
+    }
+    
+    FILE *File = fopen(Path, "rb");
+    if(!File)
+    {
+        return false;
+    }
+    
+    memory_checkpoint_header Header = {};
+    b8 Result = fread(&Header, sizeof(Header), 1, File) == 1 &&
+        Header.Magic == MEM_CHECKPOINT_MAGIC &&
+        Header.Size == Arena->Size &&
+        Header.Version == Version &&
+        Header.PageSize == MEM_CHECKPOINT_PAGE_SIZE;
+    
+    u8 *Start = (u8*)Arena->Start;
+    size_t PageCount = Arena->Size / MEM_CHECKPOINT_PAGE_SIZE;
+    u64 *PageIndexes = Result ? (u64*)mem_AllocateOsMemory(NULL, PageCount*sizeof(u64)) : 0;
+    Result = Result && PageIndexes;
+    
+    b8 isFirst = true;
+    size_t Used = 0;
+    while(Result)
+    {
+        memory_checkpoint_record Record = {};
+        b8 isComplete = fread(&Record, sizeof(Record), 1, File) == 1 &&
+            Record.Magic == MEM_CHECKPOINT_RECORD_MAGIC &&
+            Record.Used <= Arena->Size &&
+            Record.PageCount <= PageCount &&
+            fread(PageIndexes, sizeof(u64), Record.PageCount, File) == Record.PageCount;
+        for(u64 Index = 0; isComplete && Index < Record.PageCount; ++Index)
+        {
+            isComplete = PageIndexes[Index] < PageCount;
+        }
+        
+        // NOTE(amos): Skip to the trailer first, so a checkpoint cut off by a crash is found before any of its pages
+        // are put in place over the checkpoint before.
+        s64 PagesSize = (s64)(Record.PageCount*MEM_CHECKPOINT_PAGE_SIZE);
+        u64 Sequence = 0;
+        isComplete = isComplete &&
+            mem_SeekOsFileStream(File, PagesSize) &&
+            fread(&Sequence, sizeof(Sequence), 1, File) == 1 &&
+            Sequence == Record.Sequence;
+        if(!isComplete)
+        {
+            // NOTE(amos): The end of the file, or a checkpoint cut off by a crash.
+            Result = !isFirst;
+            break;
+        }
+        
+        Result = mem_SeekOsFileStream(File, -PagesSize - (s64)sizeof(Sequence));
+        for(u64 Index = 0; Result && Index < Record.PageCount; ++Index)
+        {
+            u64 Page = PageIndexes[Index];
+            size_t PageEnd = (Page + 1)*MEM_CHECKPOINT_PAGE_SIZE;
+            if(Arena->isReserved && PageEnd > Arena->Committed)
+            {
+                Result = mem_CommitMemory_(Arena, PageEnd);
+            }
+            
+            Result = Result && fread(Start + Page*MEM_CHECKPOINT_PAGE_SIZE, MEM_CHECKPOINT_PAGE_SIZE, 1, File) == 1;
+        }
+        Result = Result && mem_SeekOsFileStream(File, sizeof(Sequence));
+        if(!Result)
+        {
+            break;
+        }
+        
+        Used = Record.Used;
+        isFirst = false;
+    }
+    
+    if(PageIndexes)
+    {
+        mem_DeallocateOsMemory(PageIndexes, PageCount*sizeof(u64));
+    }
+    fclose(File);
+    
+    if(Result)
+    {
+        if(Arena->isReserved && Used > Arena->Committed)
+        {
+            Result = mem_CommitMemory_(Arena, Used);
+        }
+        Arena->Used = Used;
+        // NOTE(amos): Pages that weren't in any checkpoint still have whatever was there before.
+        Arena->Dirty = Arena->Size;
+    }
+    
+    return Result;
 }
 
 #undef MEMORY_SRC
@@ -17,14 +17,130 @@ Linux specific implementation of functions. See @ref ab_memory.h for function us
 #if defined(MEMORY_SRC)
 
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
+#include <sys/stat.h>
+#include <sched.h>
+#include <time.h>
 
-void *mem_AllocateOsMemory(void *Address, size_t Size)
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#define MEM_HUGE_PAGE_SIZE Megabytes(2)
+#define MEM_HUGE_PAGE_SIZE_1GB Gigabytes(1)
+
+// NOTE(amos): From linux/mempolicy.h. Defined here so there's no dependency on libnuma.
+#define MEM_MPOL_PREFERRED 1
+#define MEM_MPOL_MAX_NODES 1024
+
+b8 mem_BindOsMemoryToNode_(void *Address, size_t Size, s32 NumaNode)
 {
-    void* MemoryStart = mmap(Address, Size,
-                             PROT_READ | PROT_WRITE,
-                             MAP_ANONYMOUS | MAP_PRIVATE,
-                             -1, 0);
+    b8 Result = false;
+    
+    if(NumaNode >= 0 &&
+       NumaNode < MEM_MPOL_MAX_NODES)
+    {
+        u64 NodeMask[MEM_MPOL_MAX_NODES / 64] = {};
+        NodeMask[NumaNode / 64] = 1ULL << (NumaNode % 64);
+        
+        // NOTE(amos): Preferred rather than bind, so the allocation still succeeds if the node runs out of memory.
+        Result = (syscall(SYS_mbind, Address, Size, MEM_MPOL_PREFERRED, NodeMask, MEM_MPOL_MAX_NODES + 1, 0) == 0);
+    }
+    
+    return Result;
+}
+
+void *mem_AllocateOsMemory(void *Address, size_t Size, u32 Flags, u32 *AppliedFlags, s32 NumaNode)
+{
+    void* MemoryStart = MAP_FAILED;
+    u32 Applied = MEM_Null;
+    
+    // NOTE(amos): Pages have to be placed on a node before they are faulted in, so MAP_POPULATE is only used when
+    // no node is requested. Otherwise, the pages are touched after they are bound.
+    b8 isPopulated = (Flags & MEM_Prefault) && (NumaNode == MEM_NUMA_ANY);
+    s32 PopulateFlag = isPopulated ? MAP_POPULATE : 0;
+    
+    if((Flags & MEM_HugePages1GB) &&
+       (Size % MEM_HUGE_PAGE_SIZE_1GB) == 0)
+    {
+        MemoryStart = mmap(Address, Size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_ANONYMOUS | MAP_PRIVATE | MAP_HUGETLB | MAP_HUGE_1GB | PopulateFlag,
+                           -1, 0);
+        if(MemoryStart != MAP_FAILED)
+        {
+            Applied |= MEM_HugePages1GB;
+        }
+    }
+    
+    if(MemoryStart == MAP_FAILED &&
+       (Flags & (MEM_HugePages | MEM_HugePages1GB)) &&
+       (Size % MEM_HUGE_PAGE_SIZE) == 0)
+    {
+        MemoryStart = mmap(Address, Size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_ANONYMOUS | MAP_PRIVATE | MAP_HUGETLB | MAP_HUGE_2MB | PopulateFlag,
+                           -1, 0);
+        if(MemoryStart != MAP_FAILED)
+        {
+            Applied |= MEM_HugePages;
+        }
+    }
+    
+    if(MemoryStart == MAP_FAILED &&
+       (Flags & (MEM_HugePages | MEM_HugePages1GB)) &&
+       !Address)
+    {
+        // NOTE(amos): Transparent huge pages only back 2MB aligned ranges, so over-allocate and trim to alignment.
+        // The result is still a single mapping of Size bytes, so mem_DeallocateOsMemory() works as normal.
+        size_t MappedSize = Size + MEM_HUGE_PAGE_SIZE;
+        u8 *Mapped = (u8*)mmap(0, MappedSize,
+                               PROT_READ | PROT_WRITE,
+                               MAP_ANONYMOUS | MAP_PRIVATE,
+                               -1, 0);
+        if(Mapped != MAP_FAILED)
+        {
+            u8 *Aligned = (u8*)((((size_t)Mapped) + MEM_HUGE_PAGE_SIZE - 1) & ~(MEM_HUGE_PAGE_SIZE - 1));
+            size_t HeadSize = Aligned - Mapped;
+            if(HeadSize)
+            {
+                munmap(Mapped, HeadSize);
+            }
+            munmap(Aligned + Size, MappedSize - HeadSize - Size);
+            
+            MemoryStart = Aligned;
+            if(madvise(MemoryStart, Size, MADV_HUGEPAGE) == 0)
+            {
+                Applied |= MEM_TransparentHugePages;
+            }
+            
+            // NOTE(amos): MAP_POPULATE would fault in regular pages before the madvise.
+            isPopulated = false;
+        }
+    }
+    
+    if(MemoryStart == MAP_FAILED)
+    {
+        MemoryStart = mmap(Address, Size,
+                           PROT_READ | PROT_WRITE,
+                           MAP_ANONYMOUS | MAP_PRIVATE | PopulateFlag,
+                           -1, 0);
+    }
     
     if(MemoryStart == MAP_FAILED)
     {
@@ -32,6 +148,34 @@ void *mem_AllocateOsMemory(void *Address, size_t Size)
         s32 Error = errno;
         MemoryStart = 0;
     }
+    else
+    {
+        if(NumaNode != MEM_NUMA_ANY &&
+           mem_BindOsMemoryToNode_(MemoryStart, Size, NumaNode))
+        {
+            Applied |= MEM_NumaNode;
+        }
+        
+        if(Flags & MEM_Prefault)
+        {
+            if(!isPopulated)
+            {
+                mem_PrefaultOsMemory(MemoryStart, Size);
+            }
+            Applied |= MEM_Prefault;
+        }
+        
+        if((Flags & MEM_Lock) &&
+           mem_LockOsMemory(MemoryStart, Size))
+        {
+            Applied |= MEM_Lock;
+        }
+    }
+    
+    if(AppliedFlags)
+    {
+        *AppliedFlags = Applied;
+    }
     
     return MemoryStart;
     
@@ -43,5 +187,371 @@ mem_DeallocateOsMemory(void *Address, size_t Size)
     munmap(Address, Size);
 }
 
-#endif
+void *mem_ReserveOsMemory(void *Address, size_t Size)
+{
+    void* MemoryStart = mmap(Address, Size,
+                             PROT_NONE,
+                             MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE,
+                             -1, 0);
+    
+    if(MemoryStart == MAP_FAILED)
+    {
+        // Error.
+        s32 Error = errno;
+        MemoryStart = 0;
+    }
+    
+    return MemoryStart;
+}
+
+b8 mem_CommitOsMemory(void *Address, size_t Size)
+{
+    b8 Result = (mprotect(Address, Size, PROT_READ | PROT_WRITE) == 0);
+    
+    return Result;
+}
+
+void mem_DecommitOsMemory(void *Address, size_t Size)
+{
+    // NOTE(amos): MADV_DONTNEED drops the pages immediately; they read back as zero if committed again.
+    madvise(Address, Size, MADV_DONTNEED);
+    mprotect(Address, Size, PROT_NONE);
+}
+
+size_t mem_GetPageSize()
+{
+    size_t Result = (size_t)sysconf(_SC_PAGESIZE);
+    
+    return Result;
+}
+
+b8 mem_LockOsMemory(void *Address, size_t Size)
+{
+    b8 Result = (mlock(Address, Size) == 0);
+    
+    return Result;
+}
 
+void mem_UnlockOsMemory(void *Address, size_t Size)
+{
+    munlock(Address, Size);
+}
+
+size_t mem_GetResidentPageCount(void *Address, size_t Size)
+{
+    size_t Result = 0;
+    
+    size_t PageSize = mem_GetPageSize();
+    u8 *Start = (u8*)(((size_t)Address) & ~(PageSize - 1));
+    size_t PageCount = ((((u8*)Address) + Size - Start) + PageSize - 1) / PageSize;
+    
+    u8 PageStatus[4096];
+    while(PageCount)
+    {
+        size_t ChunkCount = MINIMUM(PageCount, sizeof(PageStatus));
+        if(mincore(Start, ChunkCount*PageSize, PageStatus) != 0)
+        {
+            break;
+        }
+        
+        for(size_t Index = 0; Index < ChunkCount; ++Index)
+        {
+            Result += (PageStatus[Index] & 1);
+        }
+        
+        Start += ChunkCount*PageSize;
+        PageCount -= ChunkCount;
+    }
+    
+    return Result;
+}
+
+u32 mem_GetNumaMaxNode()
+{
+    u32 Result = 0;
+    
+    // NOTE(amos): The file holds a list of node ranges, such as "0", "0-1" or "0,2". The last number is the highest node.
+    s32 File = open("/sys/devices/system/node/online", O_RDONLY);
+    if(File >= 0)
+    {
+        char Buffer[256];
+        ssize_t Length = read(File, Buffer, sizeof(Buffer) - 1);
+        close(File);
+        
+        if(Length > 0)
+        {
+            Buffer[Length] = 0;
+            
+            u32 HighestNode = 0;
+            u32 Value = 0;
+            for(char *At = Buffer; *At; ++At)
+            {
+                if(*At >= '0' && *At <= '9')
+                {
+                    Value = Value*10 + (*At - '0');
+                    HighestNode = Value;
+                }
+                else
+                {
+                    Value = 0;
+                }
+            }
+            
+            Result = HighestNode;
+        }
+    }
+    
+    return Result;
+}
+
+u32 mem_GetCurrentNumaNode()
+{
+    u32 Result = 0;
+    
+    u32 Cpu = 0;
+    u32 Node = 0;
+    if(syscall(SYS_getcpu, &Cpu, &Node, 0) == 0)
+    {
+        Result = Node;
+    }
+    
+    return Result;
+}
+
+
+void *mem_MapOsFile(char const *Path, size_t Size, void *Address, b8 *isNewOut)
+{
+    void *Result = 0;
+    
+    s32 File = open(Path, O_RDWR | O_CREAT, 0644);
+    if(File >= 0)
+    {
+        struct stat FileStat;
+        b8 isSized = (fstat(File, &FileStat) == 0);
+        if(isSized && (size_t)FileStat.st_size < Size)
+        {
+            isSized = (ftruncate(File, (off_t)Size) == 0);
+        }
+        
+        if(isSized)
+        {
+            if(isNewOut)
+            {
+                *isNewOut = (FileStat.st_size == 0);
+            }
+            
+            s32 MapFlags = MAP_SHARED | (Address ? MAP_FIXED_NOREPLACE : 0);
+            Result = mmap(Address, Size, PROT_READ | PROT_WRITE, MapFlags, File, 0);
+            if(Result == MAP_FAILED)
+            {
+                Result = 0;
+            }
+            else if(Address && Result != Address)
+            {
+                // NOTE(amos): Kernels before 4.17 treat MAP_FIXED_NOREPLACE as a hint.
+                munmap(Result, Size);
+                Result = 0;
+            }
+        }
+        
+        // NOTE(amos): The mapping keeps the file open.
+        close(File);
+    }
+    
+    return Result;
+}
+
+void mem_UnmapOsFile(void *Address, size_t Size)
+{
+    munmap(Address, Size);
+}
+
+b8 mem_SyncOsFile(void *Address, size_t Size)
+{
+    b8 Result = (msync(Address, Size, MS_SYNC) == 0);
+    
+    return Result;
+}
+
+
+void *mem_MapSharedOsMemory(char const *Name, size_t Size, b8 *isCreatedOut, u32 TimeoutMs)
+{
+    void *Result = 0;
+    b8 isCreated = true;
+    
+    s32 File = shm_open(Name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if(File < 0 && errno == EEXIST)
+    {
+        isCreated = false;
+        File = shm_open(Name, O_RDWR, 0600);
+    }
+    
+    if(File >= 0)
+    {
+        b8 isSized = false;
+        if(isCreated)
+        {
+            isSized = (ftruncate(File, (off_t)Size) == 0);
+        }
+        else
+        {
+            // NOTE(amos): The creating process may not have set the size yet. Mapping past the end would fault. The size
+            // is set in one step, so once it isn't 0 it's final, and a smaller one fails right away.
+            struct stat FileStat = {};
+            u64 StartMs = mem_GetOsMilliseconds();
+            while(fstat(File, &FileStat) == 0 && FileStat.st_size == 0 &&
+                  (mem_GetOsMilliseconds() - StartMs) < TimeoutMs)
+            {
+                mem_YieldOsThread();
+            }
+            isSized = ((size_t)FileStat.st_size >= Size);
+        }
+        
+        if(isSized)
+        {
+            Result = mmap(0, Size, PROT_READ | PROT_WRITE, MAP_SHARED, File, 0);
+            if(Result == MAP_FAILED)
+            {
+                Result = 0;
+            }
+        }
+        
+        close(File);
+    }
+    
+    if(isCreatedOut)
+    {
+        *isCreatedOut = isCreated;
+    }
+    
+    return Result;
+}
+
+void mem_UnmapSharedOsMemory(void *Address, size_t Size)
+{
+    munmap(Address, Size);
+}
+
+void mem_RemoveSharedOsMemory(char const *Name)
+{
+    shm_unlink(Name);
+}
+
+void mem_YieldOsThread()
+{
+    sched_yield();
+}
+
+u64 mem_GetOsMilliseconds()
+{
+    timespec Now;
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    
+    return (u64)Now.tv_sec*1000 + (u64)Now.tv_nsec/1000000;
+}
+
+
+void *mem_AllocateDoubleMappedOsMemory(size_t Size)
+{
+    u8 *Result = 0;
+    
+    // NOTE(amos): Called through syscall() since older glibc doesn't wrap memfd_create(). 1 is MFD_CLOEXEC.
+    s32 File = (s32)syscall(SYS_memfd_create, "ab_memory_ring", 1);
+    if(File >= 0)
+    {
+        if(ftruncate(File, (off_t)Size) == 0)
+        {
+            // NOTE(amos): Reserve room for both mappings first, so nothing else can end up in between.
+            void *Reserved = mmap(0, 2*Size, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE, -1, 0);
+            if(Reserved != MAP_FAILED)
+            {
+                u8 *Base = (u8*)Reserved;
+                void *First = mmap(Base, Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, File, 0);
+                void *Second = mmap(Base + Size, Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, File, 0);
+                if(First == Base && Second == Base + Size)
+                {
+                    Result = Base;
+                }
+                else
+                {
+                    munmap(Base, 2*Size);
+                }
+            }
+        }
+        
+        // NOTE(amos): The mappings keep the memory alive.
+        close(File);
+    }
+    
+    return Result;
+}
+
+void mem_DeallocateDoubleMappedOsMemory(void *Address, size_t Size)
+{
+    munmap(Address, 2*Size);
+}
+
+
+b8 mem_ClearOsSoftDirty()
+{
+    b8 Result = false;
+    
+    // NOTE(amos): "4" clears the soft-dirty bits, see Documentation/admin-guide/mm/soft-dirty.rst.
+    s32 File = open("/proc/self/clear_refs", O_WRONLY);
+    if(File >= 0)
+    {
+        Result = (write(File, "4", 1) == 1);
+        close(File);
+    }
+    
+    return Result;
+}
+
+b8 mem_GetOsSoftDirtyPages(void *Address, size_t PageCount, u8 *DirtyOut)
+{
+    if(sysconf(_SC_PAGESIZE) != MEM_CHECKPOINT_PAGE_SIZE)
+    {
+        return false;
+    }
+    
+    s32 File = open("/proc/self/pagemap", O_RDONLY);
+    if(File < 0)
+    {
+        return false;
+    }
+    
+    // NOTE(amos): One u64 per page. Bit 55 is soft-dirty.
+    b8 Result = true;
+    size_t FirstPage = (size_t)Address / MEM_CHECKPOINT_PAGE_SIZE;
+    u64 Entries[512];
+    for(size_t Page = 0; Result && Page < PageCount; Page += ArrayCount(Entries))
+    {
+        size_t Count = MINIMUM(PageCount - Page, ArrayCount(Entries));
+        ssize_t Size = pread(File, Entries, Count*sizeof(u64), (off_t)((FirstPage + Page)*sizeof(u64)));
+        Result = (Size == (ssize_t)(Count*sizeof(u64)));
+        for(size_t Index = 0; Result && Index < Count; ++Index)
+        {
+            DirtyOut[Page + Index] = (u8)((Entries[Index] >> 55) & 1);
+        }
+    }
+    close(File);
+    
+    return Result;
+}
+
+b8 mem_SyncOsFileStream(FILE *File)
+{
+    return fflush(File) == 0 && fsync(fileno(File)) == 0;
+}
+
+b8 mem_ReplaceOsFile(char const *From, char const *To)
+{
+    return rename(From, To) == 0;
+}
+
+b8 mem_SeekOsFileStream(FILE *File, s64 Offset)
+{
+    return fseeko(File, (off_t)Offset, SEEK_CUR) == 0;
+}
+
+#endif
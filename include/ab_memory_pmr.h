@@ -0,0 +1,158 @@
+/** @file
+@brief Standard library containers in memory arenas.
+@author Amos Buchanan
+@version 1.0
+@date October 2026
+
+Adapters that let `std::pmr` containers allocate from a `memory_arena`, so STL-heavy code can use the same scratch memory as everything else rather than going out to the heap every control loop. Requires C++17.
+
+`arena_memory_resource` wraps an arena as a monotonic resource: allocating pushes to the arena, and deallocating does nothing. The one exception is freeing the most recent allocation, which gives the memory back to the arena, so short-lived strings and buffers don't pile up. Memory is otherwise only reclaimed when the arena is reset; a `std::pmr::vector` that grows leaves its old buffers behind, so `reserve()` it when the size is known.
+
+`temporary_memory_resource` does the same inside a `temporary_memory` scope. Everything allocated through it is freed when it goes out of scope, so containers using it must be destroyed first (declare them after the resource).
+
+If a fixed-size arena runs out, the allocation goes to the upstream resource instead. By default that's `std::pmr::null_memory_resource()`, which throws `std::bad_alloc`. Pass `std::pmr::new_delete_resource()` to fall back to the heap. A growable arena adds blocks as usual.
+
+This is a single-file library. You may include it as a header just as any other. Add the following define to include the source *once* per project:
+
+~~~c
+#define AB_MEMORY_PMR_SRC
+#include "ab_memory_pmr.h"
+~~~
+
+Example Usage:
+~~~c
+void
+UpdateLoop(memory_arena *VolatileMemory)
+{
+    temporary_memory_resource Scratch(VolatileMemory);
+    
+    std::pmr::vector<sensor_reading> Readings(&Scratch);
+    std::pmr::unordered_map<u32, std::pmr::string> Names(&Scratch);
+    ...
+    // Readings and Names are destroyed, then Scratch frees all their memory at once.
+}
+~~~
+
+See also:
+- @ref ab_memory.h
+
+**/
+
+#ifndef AB_MEMORY_PMR_H
+#define AB_MEMORY_PMR_H
+
+#include <memory_resource>
+
+#include "ab_common.h"
+#include "ab_memory.h"
+
+/** @brief A `std::pmr::memory_resource` that pushes to a memory arena. **/
+class arena_memory_resource : public std::pmr::memory_resource
+{
+public:
+    /** @brief Wrap an arena.
+    
+    @param Arena The arena to push to. Must outlive the resource and anything allocated from it.
+    @param Upstream Where allocations go if a fixed-size arena is full.
+    **/
+    explicit arena_memory_resource(memory_arena *Arena, std::pmr::memory_resource *Upstream = std::pmr::null_memory_resource());
+    
+    arena_memory_resource(arena_memory_resource const &) = delete;
+    arena_memory_resource &operator=(arena_memory_resource const &) = delete;
+    
+    /** @brief The arena being pushed to. **/
+    memory_arena *Arena;
+    /** @brief Where allocations go if a fixed-size arena is full. **/
+    std::pmr::memory_resource *Upstream;
+
+protected:
+    void *do_allocate(size_t Bytes, size_t Alignment) override;
+    void do_deallocate(void *Memory, size_t Bytes, size_t Alignment) override;
+    bool do_is_equal(std::pmr::memory_resource const &Other) const noexcept override;
+};
+
+/** @brief A `std::pmr::memory_resource` in a `temporary_memory` scope of an arena.
+
+Begins temporary memory when constructed, and ends it when destroyed.
+**/
+class temporary_memory_resource : public arena_memory_resource
+{
+public:
+    /** @brief Begin temporary memory in an arena.
+    
+    @param Arena The arena to push to.
+    @param Upstream Where allocations go if a fixed-size arena is full.
+    **/
+    explicit temporary_memory_resource(memory_arena *Arena, std::pmr::memory_resource *Upstream = std::pmr::null_memory_resource());
+    ~temporary_memory_resource();
+    
+    /** @private **/
+    temporary_memory TempMem;
+};
+
+#endif // AB_MEMORY_PMR_H
+
+/*************************************************/
+#ifdef AB_MEMORY_PMR_SRC
+
+arena_memory_resource::arena_memory_resource(memory_arena *Arena, std::pmr::memory_resource *Upstream) :
+    Arena(Arena), Upstream(Upstream)
+{
+}
+
+void *
+arena_memory_resource::do_allocate(size_t Bytes, size_t Alignment)
+{
+    void *Result = 0;
+    
+    // NOTE(amos): A fixed arena asserts when it's full, so check first and let the upstream resource decide.
+    if(Arena->MinimumBlockSize ||
+       (mem_GetAlignmentOffset(Arena, Alignment) + Bytes) <= mem_GetMemoryLeft(Arena))
+    {
+        Result = mem_PushSize_(Arena, Bytes, false, Alignment);
+    }
+    
+    if(!Result)
+    {
+        Result = Upstream->allocate(Bytes, Alignment);
+    }
+    
+    return Result;
+}
+
+void
+arena_memory_resource::do_deallocate(void *Memory, size_t Bytes, size_t Alignment)
+{
+    u8 *Start = (u8*)Arena->Start;
+    u8 *At = (u8*)Memory;
+    
+    if(At >= Start && At < (Start + Arena->Size))
+    {
+        mem_PopSize(Arena, Memory, Bytes);
+    }
+    else if(!Arena->MinimumBlockSize)
+    {
+        // NOTE(amos): Outside a fixed arena, so it came from upstream. Memory in earlier blocks of a growable
+        // arena is simply left until the blocks are freed.
+        Upstream->deallocate(Memory, Bytes, Alignment);
+    }
+}
+
+bool
+arena_memory_resource::do_is_equal(std::pmr::memory_resource const &Other) const noexcept
+{
+    return this == &Other;
+}
+
+temporary_memory_resource::temporary_memory_resource(memory_arena *Arena, std::pmr::memory_resource *Upstream) :
+    arena_memory_resource(Arena, Upstream), TempMem(mem_BeginTemporaryMemory(Arena))
+{
+}
+
+temporary_memory_resource::~temporary_memory_resource()
+{
+    mem_EndTemporaryMemory(TempMem);
+}
+
+#undef AB_MEMORY_PMR_SRC
+#endif // AB_MEMORY_PMR_SRC
@@ -16,13 +16,70 @@ Windows specific implementation of functions. See @ref ab_memory.h for function
 
 #define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
 #include <windows.h>
+#include <psapi.h>
+#include <io.h>
 
 
-void *mem_AllocateOsMemory(void *Address, size_t Size)
+void *mem_AllocateOsMemory(void *Address, size_t Size, u32 Flags, u32 *AppliedFlags, s32 NumaNode)
 {
-    LPVOID MemoryStart= VirtualAlloc(Address, Size,
-                                     MEM_COMMIT|MEM_RESERVE,
-                                     PAGE_READWRITE);
+    LPVOID MemoryStart = 0;
+    u32 Applied = MEM_Null;
+    
+    // NOTE(amos): VirtualAllocExNuma() only prefers the node, the same as on Linux.
+    DWORD PreferredNode = NUMA_NO_PREFERRED_NODE;
+    if(NumaNode >= 0 &&
+       (u32)NumaNode <= mem_GetNumaMaxNode())
+    {
+        PreferredNode = (DWORD)NumaNode;
+        Applied |= MEM_NumaNode;
+    }
+    
+    // NOTE(amos): Large pages need the SeLockMemoryPrivilege, and a size that's a multiple of the large page size.
+    // There are no transparent huge pages on Windows, so fall back to regular pages.
+    size_t LargePageSize = GetLargePageMinimum();
+    if((Flags & (MEM_HugePages | MEM_HugePages1GB)) &&
+       LargePageSize &&
+       (Size % LargePageSize) == 0)
+    {
+        MemoryStart = VirtualAllocExNuma(GetCurrentProcess(), Address, Size,
+                                         MEM_COMMIT|MEM_RESERVE|MEM_LARGE_PAGES,
+                                         PAGE_READWRITE, PreferredNode);
+        if(MemoryStart)
+        {
+            Applied |= MEM_HugePages;
+        }
+    }
+    
+    if(!MemoryStart)
+    {
+        MemoryStart = VirtualAllocExNuma(GetCurrentProcess(), Address, Size,
+                                         MEM_COMMIT|MEM_RESERVE,
+                                         PAGE_READWRITE, PreferredNode);
+    }
+    
+    if(!MemoryStart)
+    {
+        Applied = MEM_Null;
+    }
+    else
+    {
+        if(Flags & MEM_Prefault)
+        {
+            mem_PrefaultOsMemory(MemoryStart, Size);
+            Applied |= MEM_Prefault;
+        }
+        
+        if((Flags & MEM_Lock) &&
+           mem_LockOsMemory(MemoryStart, Size))
+        {
+            Applied |= MEM_Lock;
+        }
+    }
+    
+    if(AppliedFlags)
+    {
+        *AppliedFlags = Applied;
+    }
     
     return MemoryStart;
     
@@ -33,6 +90,277 @@ void mem_DeallocateOsMemory(void *Address, size_t Size)
     VirtualFree(Address, 0, MEM_RELEASE);
 }
 
+void *mem_ReserveOsMemory(void *Address, size_t Size)
+{
+    LPVOID MemoryStart = VirtualAlloc(Address, Size,
+                                      MEM_RESERVE,
+                                      PAGE_NOACCESS);
+    
+    return MemoryStart;
+}
 
-#endif
+b8 mem_CommitOsMemory(void *Address, size_t Size)
+{
+    b8 Result = (VirtualAlloc(Address, Size, MEM_COMMIT, PAGE_READWRITE) != 0);
+    
+    return Result;
+}
 
+void mem_DecommitOsMemory(void *Address, size_t Size)
+{
+    VirtualFree(Address, Size, MEM_DECOMMIT);
+}
+
+size_t mem_GetPageSize()
+{
+    SYSTEM_INFO SystemInfo;
+    GetSystemInfo(&SystemInfo);
+    size_t Result = (size_t)SystemInfo.dwPageSize;
+    
+    return Result;
+}
+
+
+b8 mem_LockOsMemory(void *Address, size_t Size)
+{
+    // NOTE(amos): Limited by the process working set size; see SetProcessWorkingSetSize().
+    b8 Result = (VirtualLock(Address, Size) != 0);
+    
+    return Result;
+}
+
+void mem_UnlockOsMemory(void *Address, size_t Size)
+{
+    VirtualUnlock(Address, Size);
+}
+
+size_t mem_GetResidentPageCount(void *Address, size_t Size)
+{
+    size_t Result = 0;
+    
+    size_t PageSize = mem_GetPageSize();
+    u8 *Start = (u8*)(((size_t)Address) & ~(PageSize - 1));
+    size_t PageCount = ((((u8*)Address) + Size - Start) + PageSize - 1) / PageSize;
+    
+    PSAPI_WORKING_SET_EX_INFORMATION PageStatus[256];
+    while(PageCount)
+    {
+        size_t ChunkCount = MINIMUM(PageCount, ArrayCount(PageStatus));
+        for(size_t Index = 0; Index < ChunkCount; ++Index)
+        {
+            PageStatus[Index].VirtualAddress = Start + Index*PageSize;
+        }
+        
+        if(!QueryWorkingSetEx(GetCurrentProcess(), PageStatus, (DWORD)(ChunkCount*sizeof(PageStatus[0]))))
+        {
+            break;
+        }
+        
+        for(size_t Index = 0; Index < ChunkCount; ++Index)
+        {
+            Result += PageStatus[Index].VirtualAttributes.Valid;
+        }
+        
+        Start += ChunkCount*PageSize;
+        PageCount -= ChunkCount;
+    }
+    
+    return Result;
+}
+
+u32 mem_GetNumaMaxNode()
+{
+    u32 Result = 0;
+    
+    ULONG HighestNode = 0;
+    if(GetNumaHighestNodeNumber(&HighestNode))
+    {
+        Result = (u32)HighestNode;
+    }
+    
+    return Result;
+}
+
+u32 mem_GetCurrentNumaNode()
+{
+    u32 Result = 0;
+    
+    PROCESSOR_NUMBER Processor;
+    GetCurrentProcessorNumberEx(&Processor);
+    USHORT Node = 0;
+    if(GetNumaProcessorNodeEx(&Processor, &Node))
+    {
+        Result = (u32)Node;
+    }
+    
+    return Result;
+}
+
+
+void *mem_MapOsFile(char const *Path, size_t Size, void *Address, b8 *isNewOut)
+{
+    void *Result = 0;
+    
+    HANDLE File = CreateFileA(Path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, 0,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    if(File != INVALID_HANDLE_VALUE)
+    {
+        LARGE_INTEGER FileSize = {};
+        GetFileSizeEx(File, &FileSize);
+        if(isNewOut)
+        {
+            *isNewOut = (FileSize.QuadPart == 0);
+        }
+        
+        // NOTE(amos): Creating the mapping grows the file to Size if it's smaller.
+        ULARGE_INTEGER MapSize;
+        MapSize.QuadPart = Size;
+        HANDLE Mapping = CreateFileMappingA(File, 0, PAGE_READWRITE, MapSize.HighPart, MapSize.LowPart, 0);
+        if(Mapping)
+        {
+            Result = MapViewOfFileEx(Mapping, FILE_MAP_ALL_ACCESS, 0, 0, Size, Address);
+            
+            // NOTE(amos): The view keeps the mapping and file open.
+            CloseHandle(Mapping);
+        }
+        CloseHandle(File);
+    }
+    
+    return Result;
+}
+
+void mem_UnmapOsFile(void *Address, size_t Size)
+{
+    UnmapViewOfFile(Address);
+}
+
+b8 mem_SyncOsFile(void *Address, size_t Size)
+{
+    b8 Result = (FlushViewOfFile(Address, Size) != 0);
+    
+    return Result;
+}
+
+
+void *mem_MapSharedOsMemory(char const *Name, size_t Size, b8 *isCreatedOut, u32 TimeoutMs)
+{
+    void *Result = 0;
+    
+    ULARGE_INTEGER MapSize;
+    MapSize.QuadPart = Size;
+    HANDLE Mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, 0, PAGE_READWRITE, MapSize.HighPart, MapSize.LowPart, Name);
+    if(Mapping)
+    {
+        if(isCreatedOut)
+        {
+            *isCreatedOut = (GetLastError() != ERROR_ALREADY_EXISTS);
+        }
+        
+        Result = MapViewOfFile(Mapping, FILE_MAP_ALL_ACCESS, 0, 0, Size);
+        
+        // NOTE(amos): The view keeps the shared memory alive.
+        CloseHandle(Mapping);
+    }
+    
+    return Result;
+}
+
+void mem_UnmapSharedOsMemory(void *Address, size_t Size)
+{
+    UnmapViewOfFile(Address);
+}
+
+void mem_RemoveSharedOsMemory(char const *Name)
+{
+}
+
+void mem_YieldOsThread()
+{
+    SwitchToThread();
+}
+
+u64 mem_GetOsMilliseconds()
+{
+    return (u64)GetTickCount64();
+}
+
+
+void *mem_AllocateDoubleMappedOsMemory(size_t Size)
+{
+    u8 *Result = 0;
+    
+    ULARGE_INTEGER MapSize;
+    MapSize.QuadPart = Size;
+    HANDLE Mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, 0, PAGE_READWRITE, MapSize.HighPart, MapSize.LowPart, 0);
+    if(Mapping)
+    {
+        // NOTE(amos): Find a free range big enough for both views, then map into it. Another thread can take the
+        // range in between, so try a few times.
+        for(u32 Try = 0; !Result && Try < 16; ++Try)
+        {
+            u8 *Base = (u8*)VirtualAlloc(0, 2*Size, MEM_RESERVE, PAGE_NOACCESS);
+            if(!Base)
+            {
+                break;
+            }
+            VirtualFree(Base, 0, MEM_RELEASE);
+            
+            void *First = MapViewOfFileEx(Mapping, FILE_MAP_ALL_ACCESS, 0, 0, Size, Base);
+            void *Second = MapViewOfFileEx(Mapping, FILE_MAP_ALL_ACCESS, 0, 0, Size, Base + Size);
+            if(First == Base && Second == Base + Size)
+            {
+                Result = Base;
+            }
+            else
+            {
+                if(First)
+                {
+                    UnmapViewOfFile(First);
+                }
+                if(Second)
+                {
+                    UnmapViewOfFile(Second);
+                }
+            }
+        }
+        
+        // NOTE(amos): The views keep the memory alive.
+        CloseHandle(Mapping);
+    }
+    
+    return Result;
+}
+
+void mem_DeallocateDoubleMappedOsMemory(void *Address, size_t Size)
+{
+    UnmapViewOfFile(Address);
+    UnmapViewOfFile(((u8*)Address) + Size);
+}
+
+
+b8 mem_ClearOsSoftDirty()
+{
+    return false;
+}
+
+b8 mem_GetOsSoftDirtyPages(void *Address, size_t PageCount, u8 *DirtyOut)
+{
+    return false;
+}
+
+b8 mem_SyncOsFileStream(FILE *File)
+{
+    return fflush(File) == 0 && _commit(_fileno(File)) == 0;
+}
+
+b8 mem_ReplaceOsFile(char const *From, char const *To)
+{
+    return MoveFileExA(From, To, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+b8 mem_SeekOsFileStream(FILE *File, s64 Offset)
+{
+    return _fseeki64(File, Offset, SEEK_CUR) == 0;
+}
+
+#endif
@@ -0,0 +1,145 @@
+/** @file
+@brief Relative pointers for data that moves.
+@author Amos Buchanan
+@version 1.0
+@date October 2026
+
+A `rel_ptr` stores the distance from itself to what it points at, rather than an address. Data that only points within itself with `rel_ptr` can be copied with memcpy, written to a file, or mapped at a different address in another process, and every pointer still works. No fixups needed.
+
+The offset is 32 bits by default, which is enough for anything within 2GB and halves the size of pointer-heavy structures on 64-bit builds. Use `rel_ptr<Type, s64>` for larger data. An offset of 0 is the null pointer, so a `rel_ptr` can't point at itself. A target out of range is stored as null.
+
+Since the offset depends on where the `rel_ptr` lives, copying one with `=` or a copy constructor points the new copy at the same target. Copying a whole block of memory with memcpy keeps everything in it pointing within the copy.
+
+`rel_array` is a relative pointer plus a count, for arrays in the same block of memory.
+
+This library is header only; there is no source to include.
+
+Example Usage:
+~~~c
+struct tree_node
+{
+    u32 Value;
+    rel_ptr<tree_node> Left;
+    rel_ptr<tree_node> Right;
+    rel_array<u32> Samples;
+};
+
+tree_node *Root = mem_PushStruct(&TreeMemory, tree_node);
+Root->Left = mem_PushStruct(&TreeMemory, tree_node);
+rp_PushArray(&TreeMemory, &Root->Samples, 64);
+
+// The whole tree can be copied somewhere else and used straight away.
+memcpy(SnapshotMemory, TreeMemory.Start, TreeMemory.Used);
+tree_node *SnapshotRoot = (tree_node*)SnapshotMemory;
+u32 LeftValue = SnapshotRoot->Left->Value;
+~~~
+
+See also:
+- @ref ab_memory.h
+
+**/
+
+#ifndef AB_RELPTR_H
+#define AB_RELPTR_H
+
+#include "ab_common.h"
+#include "ab_memory.h"
+
+/** @brief A pointer stored as an offset from its own address. **/
+template<typename T, typename O = s32>
+struct rel_ptr
+{
+    /** @brief Bytes from this `rel_ptr` to the target. 0 for null. **/
+    O Offset;
+    
+    rel_ptr() : Offset(0) {}
+    rel_ptr(T *Target) { Set(Target); }
+    rel_ptr(rel_ptr const &Other) { Set(Other.Get()); }
+    
+    rel_ptr &operator=(T *Target) { Set(Target); return *this; }
+    rel_ptr &operator=(rel_ptr const &Other) { Set(Other.Get()); return *this; }
+    
+    /** @brief Get the target address, or 0 for null. **/
+    T *
+    Get() const
+    {
+        // NOTE(amos): Done on integers, since the compiler may assume pointer math on `this` stays inside this object.
+        return Offset ? (T*)((uintptr_t)this + (intptr_t)Offset) : 0;
+    }
+    
+    /** @brief Point at a new target, or 0 for null.
+    
+    A target too far away for the offset type, or at this `rel_ptr` itself, asserts in debug builds. Release builds
+    store null, rather than an offset that points somewhere else.
+    
+    @return True if the target was stored.
+    **/
+    b8
+    Set(T *Target)
+    {
+        b8 Result = true;
+        Offset = 0;
+        if(Target)
+        {
+            s64 Distance = (s64)((intptr_t)Target - (intptr_t)this);
+            b8 isInRange = ((s64)(O)Distance == Distance) && (Distance != 0);
+            Assert(isInRange);
+            if(isInRange)
+            {
+                Offset = (O)Distance;
+            }
+            else
+            {
+                Result = false;
+            }
+        }
+        
+        return Result;
+    }
+    
+    operator T *() const { return Get(); }
+    T *operator->() const { return Get(); }
+};
+
+/** @brief An array stored as a relative pointer and a count. **/
+template<typename T, typename O = s32>
+struct rel_array
+{
+    /** @brief The first element. **/
+    rel_ptr<T, O> Data;
+    /** @brief Number of elements. **/
+    u32 Count;
+    
+    T &
+    operator[](u32 Index) const
+    {
+        Assert(Index < Count);
+        return Data.Get()[Index];
+    }
+    
+    T *begin() const { return Data.Get(); }
+    T *end() const { return Data.Get() + Count; }
+};
+
+/** @brief Push an array to an arena and point a `rel_array` at it.
+
+The `rel_array` should be in the same block of memory as the arena, so the two move together.
+
+@param Arena The arena to push to.
+@param Array The array to set.
+@param Count Number of elements to push.
+@param ClearMemory True to clear the elements to 0.
+@return A pointer to the first element; 0 if the arena is out of memory.
+**/
+template<typename T, typename O>
+T *
+rp_PushArray(memory_arena *Arena, rel_array<T, O> *Array, u32 Count, b8 ClearMemory = true)
+{
+    T *Result = (T*)mem_PushSize_(Arena, Count*sizeof(T), ClearMemory, alignof(T));
+    Array->Data = Result;
+    Array->Count = Result ? Count : 0;
+    
+    return Result;
+}
+
+#endif // AB_RELPTR_H
@@ -0,0 +1,409 @@
+/** @file
+@brief Slab allocator for small objects of many sizes.
+@author Amos Buchanan
+@version 1.0
+@date October 2026
+
+For allocating lots of small records of different types, such as log records or parsed JSON nodes. Rather than a pool per type, every allocation is rounded up to one of `SL_CLASS_COUNT` size classes, from `SL_MIN_SIZE` up to `SL_MAX_SIZE` bytes. Each size class packs its objects densely into slabs: page-aligned runs of `SL_SLAB_SIZE` bytes taken from a `memory_arena`. A bitmap in each slab tracks which objects are free.
+
+When every object in a slab is freed, the slab goes back to a shared list and can be used again by any size class. So memory follows the mix of sizes in use, rather than being stuck with whichever type used to be popular.
+
+Objects are aligned to 16 bytes. Freeing an object doesn't need its size; the slab is found from the address. Larger allocations should use @ref ab_heap.h. The allocator is not thread safe; use one per thread, or lock around it.
+
+This is a single-file library. You may include it as a header just as any other. Add the following define to include the source *once* per project:
+
+~~~c
+#define AB_SLAB_SRC
+#include "ab_slab.h"
+~~~
+
+Example Usage:
+~~~c
+// Slabs are pushed to the arena as needed, so a reserved arena works well here.
+memory_arena SlabMemory = mem_InitReservedMemory(Gigabytes(4));
+slab_allocator *Slabs = sl_CreateSlabAllocator(&SlabMemory);
+
+log_record *Record = (log_record*)sl_Alloc(Slabs, sizeof(log_record));
+json_node *Node = (json_node*)sl_Alloc(Slabs, sizeof(json_node), true);
+sl_Free(Slabs, Record);
+
+slab_stats Stats = sl_GetStats(Slabs);
+for(u32 ClassIndex = 0; ClassIndex < SL_CLASS_COUNT; ++ClassIndex)
+{
+    slab_class_stats *Class = &Stats.Classes[ClassIndex];
+    printf("%4u bytes: %u/%u in %u slabs (%.0f%%)\n", Class->ObjectSize, Class->UsedCount, Class->ObjectCount, Class->SlabCount, 100.0f*Class->Occupancy);
+}
+~~~
+
+See also:
+- @ref ab_memory.h
+- @ref ab_heap.h
+
+**/
+
+#ifndef AB_SLAB_H
+#define AB_SLAB_H
+
+#include "ab_common.h"
+#include "ab_memory.h"
+
+/** @brief Size of each slab. Slabs are aligned to their size, so the slab of an object is found by masking its address. **/
+#define SL_SLAB_SIZE Kilobytes(64)
+
+/** @brief Smallest size class. **/
+#define SL_MIN_SIZE 16
+
+/** @brief Largest size class. Larger allocations fail. **/
+#define SL_MAX_SIZE 1024
+
+/** @brief Number of size classes: steps of 16 bytes up to 128, then four steps for each power of two up to 1024. **/
+#define SL_CLASS_COUNT 20
+
+/** @private **/
+#define SL_BITMAP_WORDS (SL_SLAB_SIZE / SL_MIN_SIZE / 64)
+
+/** @private
+
+The header at the start of every slab. The objects follow it.
+**/
+struct sl_slab
+{
+    sl_slab *Next;
+    sl_slab *Prev;
+    u8 *Objects;
+    u32 ClassIndex;
+    u32 ObjectSize;
+    u32 ObjectCount;
+    u32 FreeCount;
+    // NOTE(amos): No words before this have any free bits.
+    u32 SearchWord;
+    // NOTE(amos): A set bit is a free object.
+    u64 FreeBits[SL_BITMAP_WORDS];
+};
+
+/** @private **/
+struct slab_allocator
+{
+    memory_arena *Arena;
+    sl_slab *PartialSlabs[SL_CLASS_COUNT];
+    sl_slab *EmptySlabs;
+    u32 SlabCount[SL_CLASS_COUNT];
+    u32 UsedCount[SL_CLASS_COUNT];
+    u32 EmptySlabCount;
+};
+
+/** @brief Usage of a single size class. **/
+struct slab_class_stats
+{
+    /** @brief Size of each object in the class. **/
+    u32 ObjectSize;
+    /** @brief Slabs currently holding objects of this class. **/
+    u32 SlabCount;
+    /** @brief Objects those slabs have room for. **/
+    u32 ObjectCount;
+    /** @brief Objects currently allocated. **/
+    u32 UsedCount;
+    /** @brief UsedCount / ObjectCount, or 0 if the class has no slabs. **/
+    r32 Occupancy;
+};
+
+/** @brief Usage of a slab allocator, from @ref sl_GetStats(). **/
+struct slab_stats
+{
+    slab_class_stats Classes[SL_CLASS_COUNT];
+    /** @brief Slabs not currently used by any class. **/
+    u32 EmptySlabCount;
+    /** @brief Total memory taken from the arena for slabs. **/
+    size_t TotalSize;
+};
+
+/** @brief Create a slab allocator.
+
+@param Arena The arena the allocator and its slabs come from. Slabs are pushed as needed, so the arena must not be reset while the allocator is in use.
+@return The allocator, or 0 if there isn't enough memory.
+**/
+slab_allocator *sl_CreateSlabAllocator(memory_arena *Arena);
+
+/** @brief Get memory for an object.
+
+@param Slabs The allocator.
+@param Size Size of the object. Rounded up to the next size class.
+@param ClearMemory True to clear the memory to 0.
+@return Pointer to the memory, aligned to 16 bytes; 0 if `Size` is 0 or larger than `SL_MAX_SIZE`, or the arena is out of memory.
+**/
+void *sl_Alloc(slab_allocator *Slabs, size_t Size, b8 ClearMemory = false);
+
+/** @brief Return an object's memory.
+
+@param Slabs The allocator the memory came from.
+@param Memory Memory from `sl_Alloc()`. May be 0.
+**/
+void sl_Free(slab_allocator *Slabs, void *Memory);
+
+/** @brief Get the size class index for an allocation size. **/
+u32 sl_GetClassIndex(size_t Size);
+
+/** @brief Get the object size of a size class. **/
+u32 sl_GetClassSize(u32 ClassIndex);
+
+/** @brief Get the occupancy of each size class. **/
+slab_stats sl_GetStats(slab_allocator *Slabs);
+
+#endif // AB_SLAB_H
+
+/*************************************************/
+#ifdef AB_SLAB_SRC
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static const u32 sl_ClassSizes[SL_CLASS_COUNT] = {
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256,
+    320, 384, 448, 512,
+    640, 768, 896, 1024,
+};
+
+#define SL_OBJECTS_OFFSET ((sizeof(sl_slab) + 63) & ~(size_t)63)
+
+u32
+sl_GetClassIndex(size_t Size)
+{
+    u32 Result = 0;
+    if(Size <= 128)
+    {
+        Result = (u32)((Size + 15) / 16) - 1;
+    }
+    else
+    {
+        while(sl_ClassSizes[Result] < Size)
+        {
+            ++Result;
+        }
+    }
+    
+    return Result;
+}
+
+u32
+sl_GetClassSize(u32 ClassIndex)
+{
+    Assert(ClassIndex < SL_CLASS_COUNT);
+    
+    return sl_ClassSizes[ClassIndex];
+}
+
+inline u32
+sl_FindFirstSet_(u64 Value)
+{
+#if defined(_MSC_VER)
+    unsigned long Result;
+    _BitScanForward64(&Result, Value);
+    return (u32)Result;
+#else
+    return (u32)__builtin_ctzll(Value);
+#endif
+}
+
+slab_allocator *
+sl_CreateSlabAllocator(memory_arena *Arena)
+{
+    slab_allocator *Slabs = mem_PushStruct(Arena, slab_allocator);
+    if(Slabs)
+    {
+        Slabs->Arena = Arena;
+    }
+    
+    return Slabs;
+}
+
+void
+sl_LinkSlab_(slab_allocator *Slabs, sl_slab *Slab)
+{
+    sl_slab *Head = Slabs->PartialSlabs[Slab->ClassIndex];
+    Slab->Prev = 0;
+    Slab->Next = Head;
+    if(Head)
+    {
+        Head->Prev = Slab;
+    }
+    Slabs->PartialSlabs[Slab->ClassIndex] = Slab;
+}
+
+void
+sl_UnlinkSlab_(slab_allocator *Slabs, sl_slab *Slab)
+{
+    if(Slab->Prev)
+    {
+        Slab->Prev->Next = Slab->Next;
+    }
+    else
+    {
+        Slabs->PartialSlabs[Slab->ClassIndex] = Slab->Next;
+    }
+    
+    if(Slab->Next)
+    {
+        Slab->Next->Prev = Slab->Prev;
+    }
+    
+    Slab->Next = Slab->Prev = 0;
+}
+
+sl_slab *
+sl_NewSlab_(slab_allocator *Slabs, u32 ClassIndex)
+{
+    sl_slab *Slab = Slabs->EmptySlabs;
+    if(Slab)
+    {
+        Slabs->EmptySlabs = Slab->Next;
+        --Slabs->EmptySlabCount;
+    }
+    else
+    {
+        Slab = (sl_slab*)mem_PushSize_(Slabs->Arena, SL_SLAB_SIZE, false, SL_SLAB_SIZE);
+    }
+    
+    if(Slab)
+    {
+        u32 ObjectSize = sl_ClassSizes[ClassIndex];
+        u32 ObjectCount = (u32)((SL_SLAB_SIZE - SL_OBJECTS_OFFSET) / ObjectSize);
+        
+        Slab->Objects = ((u8*)Slab) + SL_OBJECTS_OFFSET;
+        Slab->ClassIndex = ClassIndex;
+        Slab->ObjectSize = ObjectSize;
+        Slab->ObjectCount = ObjectCount;
+        Slab->FreeCount = ObjectCount;
+        Slab->SearchWord = 0;
+        
+        u32 FullWords = ObjectCount / 64;
+        for(u32 Word = 0; Word < SL_BITMAP_WORDS; ++Word)
+        {
+            Slab->FreeBits[Word] = (Word < FullWords) ? ~0ULL : 0;
+        }
+        if(ObjectCount % 64)
+        {
+            Slab->FreeBits[FullWords] = (1ULL << (ObjectCount % 64)) - 1;
+        }
+        
+        ++Slabs->SlabCount[ClassIndex];
+        sl_LinkSlab_(Slabs, Slab);
+    }
+    
+    return Slab;
+}
+
+void *
+sl_Alloc(slab_allocator *Slabs, size_t Size, b8 ClearMemory)
+{
+    void *Result = 0;
+    
+    if(Size && Size <= SL_MAX_SIZE)
+    {
+        u32 ClassIndex = sl_GetClassIndex(Size);
+        sl_slab *Slab = Slabs->PartialSlabs[ClassIndex];
+        if(!Slab)
+        {
+            Slab = sl_NewSlab_(Slabs, ClassIndex);
+        }
+        
+        if(Slab)
+        {
+            u32 Word = Slab->SearchWord;
+            while(!Slab->FreeBits[Word])
+            {
+                ++Word;
+            }
+            Assert(Word < SL_BITMAP_WORDS);
+            
+            u32 Bit = sl_FindFirstSet_(Slab->FreeBits[Word]);
+            Slab->FreeBits[Word] &= ~(1ULL << Bit);
+            Slab->SearchWord = Word;
+            --Slab->FreeCount;
+            ++Slabs->UsedCount[ClassIndex];
+            
+            if(!Slab->FreeCount)
+            {
+                sl_UnlinkSlab_(Slabs, Slab);
+            }
+            
+            Result = Slab->Objects + (size_t)(Word*64 + Bit)*Slab->ObjectSize;
+            if(ClearMemory)
+            {
+                mem_ZeroSize(Result, Slab->ObjectSize);
+            }
+        }
+    }
+    
+    return Result;
+}
+
+void
+sl_Free(slab_allocator *Slabs, void *Memory)
+{
+    if(Memory)
+    {
+        sl_slab *Slab = (sl_slab*)(((size_t)Memory) & ~(size_t)(SL_SLAB_SIZE - 1));
+        size_t Index = (((u8*)Memory) - Slab->Objects) / Slab->ObjectSize;
+        u32 Word = (u32)(Index / 64);
+        u64 Mask = 1ULL << (Index % 64);
+        
+        Assert(Index < Slab->ObjectCount);
+        Assert(!(Slab->FreeBits[Word] & Mask));
+        
+        Slab->FreeBits[Word] |= Mask;
+        Slab->SearchWord = MINIMUM(Slab->SearchWord, Word);
+        ++Slab->FreeCount;
+        --Slabs->UsedCount[Slab->ClassIndex];
+        
+        if(Slab->FreeCount == 1)
+        {
+            // NOTE(amos): The slab was full, so it wasn't on the partial list.
+            sl_LinkSlab_(Slabs, Slab);
+        }
+        
+        // NOTE(amos): Keep the last partial slab of a class, so a single object being allocated and freed over and
+        // over doesn't keep moving a slab back and forth.
+        if(Slab->FreeCount == Slab->ObjectCount &&
+           (Slab->Prev || Slab->Next))
+        {
+            sl_UnlinkSlab_(Slabs, Slab);
+            --Slabs->SlabCount[Slab->ClassIndex];
+            
+            Slab->Next = Slabs->EmptySlabs;
+            Slabs->EmptySlabs = Slab;
+            ++Slabs->EmptySlabCount;
+        }
+    }
+}
+
+slab_stats
+sl_GetStats(slab_allocator *Slabs)
+{
+    slab_stats Stats = {};
+    
+    u32 TotalSlabs = Slabs->EmptySlabCount;
+    for(u32 ClassIndex = 0; ClassIndex < SL_CLASS_COUNT; ++ClassIndex)
+    {
+        slab_class_stats *Class = &Stats.Classes[ClassIndex];
+        Class->ObjectSize = sl_ClassSizes[ClassIndex];
+        Class->SlabCount = Slabs->SlabCount[ClassIndex];
+        Class->ObjectCount = Class->SlabCount * (u32)((SL_SLAB_SIZE - SL_OBJECTS_OFFSET) / Class->ObjectSize);
+        Class->UsedCount = Slabs->UsedCount[ClassIndex];
+        if(Class->ObjectCount)
+        {
+            Class->Occupancy = (r32)Class->UsedCount / (r32)Class->ObjectCount;
+        }
+        
+        TotalSlabs += Class->SlabCount;
+    }
+    
+    Stats.EmptySlabCount = Slabs->EmptySlabCount;
+    Stats.TotalSize = (size_t)TotalSlabs * SL_SLAB_SIZE;
+    
+    return Stats;
+}
+
+#undef AB_SLAB_SRC
+#endif // AB_SLAB_SRC
@@ -0,0 +1,500 @@
+/** @file
+    @brief Benchmarks for the arena, pool, slab and heap allocators, against malloc.
+    @author Amos Buchanan
+    @version 1.0
+    @date October 2026
+    @copyright MIT Public License.
+
+Two workloads, each run on 1, 2, 4 and 8 threads:
+
+- Frame: allocate a batch of 256 objects, touch them, then throw them all away. Arenas reset or end a
+  `temporary_memory`; malloc frees each object.
+- Churn: keep 4096 objects alive, and replace a random one each step. Objects live for a random time, as they
+  would in a server handling messages.
+
+Sizes come from a fixed distribution: mostly records under 64 bytes, some buffers up to 1K, and a few large
+blocks up to 64K. Churn sizes are capped at 1K, the largest slab size. Each thread has its own arena, slabs and
+heap; the pool is shared, with a cache per thread. Nothing is cleared to 0 except pool items, which always are.
+
+For each run it reports time per operation on each thread, total throughput, growth in resident memory, and
+minor page faults. Pass a scale as the first argument to run more or fewer operations, such as 0.1 for a quick
+check.
+
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <atomic>
+#include <thread>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#define MEMORY_SRC
+#include "ab_memory.h"
+
+#define AB_SLAB_SRC
+#include "ab_slab.h"
+
+#define AB_HEAP_SRC
+#include "ab_heap.h"
+
+#define TIME_HELPER_SRC
+#include "ab_timehelper.h"
+
+#define BENCH_MAX_THREADS 8
+#define BENCH_SIZE_COUNT 65536
+#define BENCH_FRAME_COUNT 256
+#define BENCH_LIVE_COUNT 4096
+#define BENCH_POOL_ITEM_SIZE 64
+
+struct bench_shared
+{
+    memory_arena Memory;
+    memory_pool *Pool;
+};
+
+struct bench_thread
+{
+    u32 Index;
+    u64 OpCount;
+    u32 *Sizes;
+    bench_shared *Shared;
+    
+    memory_arena Memory;
+    void *Live[BENCH_LIVE_COUNT];
+};
+
+typedef void bench_function(bench_thread *Thread);
+
+struct bench
+{
+    char const *Name;
+    bench_function *Setup;
+    bench_function *Run;
+    bench_function *Cleanup;
+    /** @brief Relative number of operations, so slow benchmarks don't take forever. **/
+    r32 OpScale;
+};
+
+u64
+Random(u64 *State)
+{
+    u64 Value = *State;
+    Value ^= Value << 13;
+    Value ^= Value >> 7;
+    Value ^= Value << 17;
+    *State = Value;
+    
+    return Value;
+}
+
+u32
+GetRandomSize(u64 *State, u32 MaxSize)
+{
+    struct size_range
+    {
+        u32 Chance;
+        u32 Low;
+        u32 High;
+    };
+    
+    // NOTE(amos): Chances are out of 1000.
+    static const size_range Ranges[] =
+    {
+        {600, 8, 64},
+        {250, 64, 256},
+        {100, 256, 1024},
+        {45, 1024, 8192},
+        {5, 8192, 65536},
+    };
+    
+    u32 Roll = (u32)(Random(State) % 1000);
+    u32 Index = 0;
+    while(Roll >= Ranges[Index].Chance)
+    {
+        Roll -= Ranges[Index].Chance;
+        ++Index;
+    }
+    
+    u32 Size = Ranges[Index].Low + (u32)(Random(State) % (Ranges[Index].High - Ranges[Index].Low));
+    return MINIMUM(Size, MaxSize);
+}
+
+inline void
+Touch(void *Memory, u64 Op)
+{
+    *(volatile u8*)Memory = (u8)Op;
+}
+
+inline u32
+GetSize(bench_thread *Thread, u64 Op)
+{
+    return Thread->Sizes[Op & (BENCH_SIZE_COUNT - 1)];
+}
+
+inline u32
+GetSmallSize(bench_thread *Thread, u64 Op)
+{
+    return MINIMUM(GetSize(Thread, Op), SL_MAX_SIZE);
+}
+
+inline u32
+GetSlot(bench_thread *Thread, u64 Op)
+{
+    return (u32)((Op * 0x9E3779B97F4A7C15ull) >> 52) % BENCH_LIVE_COUNT;
+}
+
+void
+SetupArena(bench_thread *Thread)
+{
+    Thread->Memory = mem_InitReservedMemory(Gigabytes(1));
+}
+
+void
+CleanupArena(bench_thread *Thread)
+{
+    mem_ReleaseReservedMemory(&Thread->Memory);
+}
+
+//
+// Frame workload
+//
+
+void
+RunFrameMalloc(bench_thread *Thread)
+{
+    for(u64 Op = 0; Op < Thread->OpCount; Op += BENCH_FRAME_COUNT)
+    {
+        for(u32 Index = 0; Index < BENCH_FRAME_COUNT; ++Index)
+        {
+            void *Memory = malloc(GetSize(Thread, Op + Index));
+            Touch(Memory, Op);
+            Thread->Live[Index] = Memory;
+        }
+        for(u32 Index = 0; Index < BENCH_FRAME_COUNT; ++Index)
+        {
+            free(Thread->Live[Index]);
+        }
+    }
+}
+
+void
+RunFrameArena(bench_thread *Thread)
+{
+    for(u64 Op = 0; Op < Thread->OpCount; Op += BENCH_FRAME_COUNT)
+    {
+        for(u32 Index = 0; Index < BENCH_FRAME_COUNT; ++Index)
+        {
+            void *Memory = mem_PushSize_(&Thread->Memory, GetSize(Thread, Op + Index), false);
+            Touch(Memory, Op);
+        }
+        mem_ResetMemory(&Thread->Memory);
+    }
+}
+
+void
+RunFrameTemporary(bench_thread *Thread)
+{
+    for(u64 Op = 0; Op < Thread->OpCount; Op += BENCH_FRAME_COUNT)
+    {
+        temporary_memory TempMem = mem_BeginTemporaryMemory(&Thread->Memory);
+        for(u32 Index = 0; Index < BENCH_FRAME_COUNT; ++Index)
+        {
+            void *Memory = mem_PushSize_(&Thread->Memory, GetSize(Thread, Op + Index), false);
+            Touch(Memory, Op);
+        }
+        mem_EndTemporaryMemory(TempMem);
+    }
+}
+
+void
+RunFrameSubArena(bench_thread *Thread)
+{
+    for(u64 Op = 0; Op < Thread->OpCount; Op += BENCH_FRAME_COUNT)
+    {
+        temporary_memory TempMem = mem_BeginTemporaryMemory(&Thread->Memory);
+        memory_arena SubArena = mem_CreateSubArena(&Thread->Memory, Megabytes(1), MEM_CACHE_LINE_SIZE);
+        for(u32 Index = 0; Index < BENCH_FRAME_COUNT; ++Index)
+        {
+            void *Memory = mem_PushSize_(&SubArena, GetSize(Thread, Op + Index), false);
+            Touch(Memory, Op);
+        }
+        mem_EndTemporaryMemory(TempMem);
+    }
+}
+
+//
+// Churn workload
+//
+
+void
+SetupChurnMalloc(bench_thread *Thread)
+{
+    for(u32 Slot = 0; Slot < BENCH_LIVE_COUNT; ++Slot)
+    {
+        Thread->Live[Slot] = malloc(GetSmallSize(Thread, Slot));
+    }
+}
+
+void
+RunChurnMalloc(bench_thread *Thread)
+{
+    for(u64 Op = 0; Op < Thread->OpCount; ++Op)
+    {
+        u32 Slot = GetSlot(Thread, Op);
+        free(Thread->Live[Slot]);
+        Thread->Live[Slot] = malloc(GetSmallSize(Thread, Op));
+        Touch(Thread->Live[Slot], Op);
+    }
+}
+
+void
+CleanupChurnMalloc(bench_thread *Thread)
+{
+    for(u32 Slot = 0; Slot < BENCH_LIVE_COUNT; ++Slot)
+    {
+        free(Thread->Live[Slot]);
+    }
+}
+
+void
+SetupChurnSlab(bench_thread *Thread)
+{
+    SetupArena(Thread);
+    slab_allocator *Slabs = sl_CreateSlabAllocator(&Thread->Memory);
+    for(u32 Slot = 0; Slot < BENCH_LIVE_COUNT; ++Slot)
+    {
+        Thread->Live[Slot] = sl_Alloc(Slabs, GetSmallSize(Thread, Slot));
+    }
+}
+
+void
+RunChurnSlab(bench_thread *Thread)
+{
+    // NOTE(amos): The allocator is the first thing pushed to the arena.
+    slab_allocator *Slabs = (slab_allocator*)Thread->Memory.Start;
+    for(u64 Op = 0; Op < Thread->OpCount; ++Op)
+    {
+        u32 Slot = GetSlot(Thread, Op);
+        sl_Free(Slabs, Thread->Live[Slot]);
+        Thread->Live[Slot] = sl_Alloc(Slabs, GetSmallSize(Thread, Op));
+        Touch(Thread->Live[Slot], Op);
+    }
+}
+
+void
+SetupChurnHeap(bench_thread *Thread)
+{
+    SetupArena(Thread);
+    heap *Heap = hp_CreateHeap(&Thread->Memory, Megabytes(64));
+    for(u32 Slot = 0; Slot < BENCH_LIVE_COUNT; ++Slot)
+    {
+        Thread->Live[Slot] = hp_Alloc(Heap, GetSmallSize(Thread, Slot));
+    }
+}
+
+void
+RunChurnHeap(bench_thread *Thread)
+{
+    heap *Heap = (heap*)Thread->Memory.Start;
+    for(u64 Op = 0; Op < Thread->OpCount; ++Op)
+    {
+        u32 Slot = GetSlot(Thread, Op);
+        hp_Free(Heap, Thread->Live[Slot]);
+        Thread->Live[Slot] = hp_Alloc(Heap, GetSmallSize(Thread, Op));
+        Touch(Thread->Live[Slot], Op);
+    }
+}
+
+void
+SetupChurnMallocFixed(bench_thread *Thread)
+{
+    for(u32 Slot = 0; Slot < BENCH_LIVE_COUNT; ++Slot)
+    {
+        Thread->Live[Slot] = malloc(BENCH_POOL_ITEM_SIZE);
+    }
+}
+
+void
+RunChurnMallocFixed(bench_thread *Thread)
+{
+    for(u64 Op = 0; Op < Thread->OpCount; ++Op)
+    {
+        u32 Slot = GetSlot(Thread, Op);
+        free(Thread->Live[Slot]);
+        Thread->Live[Slot] = malloc(BENCH_POOL_ITEM_SIZE);
+        Touch(Thread->Live[Slot], Op);
+    }
+}
+
+void
+RunChurnPool(bench_thread *Thread)
+{
+    // NOTE(amos): The cache lives on the stack, so it's set up and flushed inside the run.
+    memory_pool_cache Cache = mem_InitPoolCache(Thread->Shared->Pool);
+    for(u32 Slot = 0; Slot < BENCH_LIVE_COUNT; ++Slot)
+    {
+        Thread->Live[Slot] = mem_PoolAllocCached(&Cache);
+    }
+    
+    for(u64 Op = 0; Op < Thread->OpCount; ++Op)
+    {
+        u32 Slot = GetSlot(Thread, Op);
+        mem_PoolFreeCached(&Cache, Thread->Live[Slot]);
+        Thread->Live[Slot] = mem_PoolAllocCached(&Cache);
+        Touch(Thread->Live[Slot], Op);
+    }
+    
+    for(u32 Slot = 0; Slot < BENCH_LIVE_COUNT; ++Slot)
+    {
+        mem_PoolFreeCached(&Cache, Thread->Live[Slot]);
+    }
+    mem_FlushPoolCache(&Cache);
+}
+
+static const bench Benches[] =
+{
+    {"frame malloc", 0, RunFrameMalloc, 0, 1.0f},
+    {"frame arena reset", SetupArena, RunFrameArena, CleanupArena, 1.0f},
+    {"frame temporary_memory", SetupArena, RunFrameTemporary, CleanupArena, 1.0f},
+    {"frame sub-arena", SetupArena, RunFrameSubArena, CleanupArena, 1.0f},
+    {"churn malloc <=1K", SetupChurnMalloc, RunChurnMalloc, CleanupChurnMalloc, 0.5f},
+    {"churn slab <=1K", SetupChurnSlab, RunChurnSlab, CleanupArena, 0.5f},
+    {"churn heap <=1K", SetupChurnHeap, RunChurnHeap, CleanupArena, 0.5f},
+    {"churn malloc 64B", SetupChurnMallocFixed, RunChurnMallocFixed, CleanupChurnMalloc, 0.5f},
+    {"churn pool 64B", 0, RunChurnPool, 0, 0.5f},
+};
+
+struct process_usage
+{
+    size_t Resident;
+    u64 MinorFaults;
+};
+
+process_usage
+GetProcessUsage()
+{
+    process_usage Result = {};
+    
+    struct rusage Usage;
+    getrusage(RUSAGE_SELF, &Usage);
+    Result.MinorFaults = (u64)Usage.ru_minflt;
+    
+    FILE *Statm = fopen("/proc/self/statm", "r");
+    if(Statm)
+    {
+        unsigned long long TotalPages = 0, ResidentPages = 0;
+        if(fscanf(Statm, "%llu %llu", &TotalPages, &ResidentPages) == 2)
+        {
+            Result.Resident = (size_t)ResidentPages * (size_t)sysconf(_SC_PAGESIZE);
+        }
+        fclose(Statm);
+    }
+    
+    return Result;
+}
+
+void
+RunBench(bench const *Bench, bench_thread *Threads, u32 ThreadCount, u64 OpCount)
+{
+    bench_shared Shared = {};
+    Shared.Memory = mem_InitReservedMemory(Gigabytes(1));
+    Shared.Pool = mem_PushPool_(&Shared.Memory, BENCH_POOL_ITEM_SIZE, MEM_CACHE_LINE_SIZE,
+                                ThreadCount*(BENCH_LIVE_COUNT + MEM_POOL_CACHE_COUNT));
+    
+    for(u32 Index = 0; Index < ThreadCount; ++Index)
+    {
+        bench_thread *Thread = &Threads[Index];
+        Thread->OpCount = (u64)(OpCount*Bench->OpScale);
+        Thread->Shared = &Shared;
+        if(Bench->Setup)
+        {
+            Bench->Setup(Thread);
+        }
+    }
+    
+    process_usage Before = GetProcessUsage();
+    std::atomic<u32> ReadyCount(0);
+    std::atomic<b8> isStarted(false);
+    std::thread Workers[BENCH_MAX_THREADS];
+    for(u32 Index = 0; Index < ThreadCount; ++Index)
+    {
+        Workers[Index] = std::thread([&, Index]()
+                                     {
+                                         ReadyCount.fetch_add(1);
+                                         while(!isStarted.load()) {}
+                                         Bench->Run(&Threads[Index]);
+                                     });
+    }
+    
+    while(ReadyCount.load() < ThreadCount) {}
+    th_time StartTime = th_GetMonotonic();
+    isStarted.store(true);
+    for(u32 Index = 0; Index < ThreadCount; ++Index)
+    {
+        Workers[Index].join();
+    }
+    r32 ElapsedMs = th_GetElapsedMsR32(StartTime, th_GetMonotonic());
+    process_usage After = GetProcessUsage();
+    
+    u64 OpsPerThread = Threads[0].OpCount;
+    r64 NsPerOp = (r64)ElapsedMs*1e6 / (r64)OpsPerThread;
+    r64 MopsPerSecond = (r64)(OpsPerThread*ThreadCount) / ((r64)ElapsedMs*1e3);
+    r64 ResidentMb = ((r64)After.Resident - (r64)Before.Resident) / (r64)Megabytes(1);
+    printf("%-24s %7u %9.1f %9.1f %10.1f %10llu\n", Bench->Name, ThreadCount, NsPerOp, MopsPerSecond, ResidentMb,
+           (unsigned long long)(After.MinorFaults - Before.MinorFaults));
+    
+    for(u32 Index = 0; Index < ThreadCount; ++Index)
+    {
+        if(Bench->Cleanup)
+        {
+            Bench->Cleanup(&Threads[Index]);
+        }
+    }
+    mem_ReleaseReservedMemory(&Shared.Memory);
+    
+    // NOTE(amos): So memory malloc kept from one run doesn't hide page faults in the next.
+    malloc_trim(0);
+}
+
+int
+main(int argc, char *argv[])
+{
+    r64 Scale = (argc > 1) ? atof(argv[1]) : 1.0;
+    u64 OpCount = (u64)(Scale*8000000.0);
+    OpCount = MAXIMUM(OpCount - (OpCount % BENCH_FRAME_COUNT), (u64)BENCH_FRAME_COUNT);
+    
+    static bench_thread Threads[BENCH_MAX_THREADS];
+    for(u32 Index = 0; Index < BENCH_MAX_THREADS; ++Index)
+    {
+        bench_thread *Thread = &Threads[Index];
+        Thread->Index = Index;
+        Thread->Sizes = (u32*)malloc(BENCH_SIZE_COUNT*sizeof(u32));
+        u64 State = 0x9E3779B97F4A7C15ull * (Index + 1);
+        for(u32 SizeIndex = 0; SizeIndex < BENCH_SIZE_COUNT; ++SizeIndex)
+        {
+            Thread->Sizes[SizeIndex] = GetRandomSize(&State, 65536);
+        }
+    }
+    
+    u32 CoreCount = std::thread::hardware_concurrency();
+    printf("%llu operations per thread, %u cores\n\n", (unsigned long long)OpCount, CoreCount);
+    printf("%-24s %7s %9s %9s %10s %10s\n", "Benchmark", "Threads", "ns/op", "Mops/s", "RSS (MB)", "Faults");
+    
+    for(u32 BenchIndex = 0; BenchIndex < ArrayCount(Benches); ++BenchIndex)
+    {
+        for(u32 ThreadCount = 1; ThreadCount <= BENCH_MAX_THREADS; ThreadCount *= 2)
+        {
+            RunBench(&Benches[BenchIndex], Threads, ThreadCount, OpCount);
+        }
+        printf("\n");
+    }
+    
+    for(u32 Index = 0; Index < BENCH_MAX_THREADS; ++Index)
+    {
+        free(Threads[Index].Sizes);
+    }
+    
+    return 0;
+}
@@ -71,3 +71,60 @@ project "TestPreprocessor"
 		runtime "Release"
 		optimize "On"
 
+project "BenchMemory"
+	kind "ConsoleApp"
+	targetname "benchmemory"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+
+	-- Uses getrusage and /proc for memory use, so Linux only. Not run after building; run it by hand.
+	removeplatforms { "Win64", "Win32" }
+
+	files
+	{
+		workspacepath .. "%{prj.location}/bench_memory.cpp",
+	}
+
+	defines
+	{
+	}
+
+	includedirs
+	{
+		"%{wks.location}/include",
+	}
+
+	links
+	{
+		"pthread"
+	}
+
+	filter "platforms:Linux64"
+		system "Linux"
+		systemversion "latest"
+		architecture "x86_64"
+		defines { "_LINUX" }
+
+	filter "platforms:Linux32"
+		system "Linux"
+		systemversion "latest"
+		architecture "x86"
+		defines { "_LINUX" }
+
+	filter "platforms:Arm"
+		system "Linux"
+		systemversion "latest"
+		architecture "x86"
+		defines { "_LINUX" }
+
+	filter "configurations:Debug"
+		defines { "DEBUG" }
+		runtime "Debug"
+		symbols "On"
+
+	-- NOTE(amos): Numbers only mean something from this configuration.
+	filter "configurations:Release"
+		defines { "NDEBUG" }
+		runtime "Release"
+		optimize "Speed"
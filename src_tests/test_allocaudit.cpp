@@ -0,0 +1,187 @@
+/** @file
+    @brief Tests for ab_allocaudit.h.
+    @author Amos Buchanan
+    @version 1.0
+    @date October 2026
+    @copyright MIT Public License.
+
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define MEMORY_SRC
+#include "ab_memory.h"
+
+#define AB_SLAB_SRC
+#include "ab_slab.h"
+
+#define AB_HASHMAP_SRC
+#include "ab_hashmap.h"
+
+#define AB_ALLOCAUDIT_SRC
+#include "ab_allocaudit.h"
+
+#include "test_common.h"
+
+// NOTE(amos): Stores results here, so the compiler can't remove allocations that are never used.
+void *volatile Sink;
+
+void
+TestCounting()
+{
+    TestCheck(au_IsAuditWorking());
+    
+    alloc_audit Audit = au_BeginAudit();
+    Sink = malloc(100);
+    free(Sink);
+    Sink = calloc(10, 8);
+    Sink = realloc(Sink, 200);
+    free(Sink);
+    Audit = au_EndAudit(Audit);
+    TestCheck(Audit.AllocCount == 3);
+    TestCheck(Audit.FreeCount == 2);
+    TestCheck(Audit.AllocSize == 380);
+    
+    // A calloc whose size overflows fails, and counts no bytes.
+    volatile size_t HugeCount = SIZE_MAX/2;
+    Audit = au_BeginAudit();
+    Sink = calloc(HugeCount, 4);
+    Audit = au_EndAudit(Audit);
+    TestCheck(!Sink);
+    TestCheck(Audit.AllocCount == 1);
+    TestCheck(Audit.AllocSize == 0);
+    
+    Audit = au_BeginAudit();
+    u32 *Value = new u32(5);
+    Sink = Value;
+    delete Value;
+    std::vector<u32> Values;
+    Values.push_back(1);
+    Audit = au_EndAudit(Audit);
+    TestCheck(Audit.AllocCount == 2);
+    TestCheck(Audit.FreeCount == 1);
+    
+    // Nothing is counted outside an audit.
+    alloc_audit Outside = au_BeginAudit();
+    Outside = au_EndAudit(Outside);
+    Sink = malloc(16);
+    free(Sink);
+    TestCheck(Outside.AllocCount == 0);
+}
+
+void
+TestNesting()
+{
+    alloc_audit Outer = au_BeginAudit();
+    Sink = malloc(8);
+    free(Sink);
+    
+    alloc_audit Inner = au_BeginAudit();
+    Sink = malloc(8);
+    free(Sink);
+    Inner = au_EndAudit(Inner);
+    
+    Outer = au_EndAudit(Outer);
+    TestCheck(Inner.AllocCount == 1);
+    TestCheck(Outer.AllocCount == 2);
+}
+
+void
+TestThreads()
+{
+    // Allocations on other threads aren't counted.
+    std::atomic<u32> Step(0);
+    std::thread Other([&Step]()
+                      {
+                          while(Step.load() == 0) {}
+                          Sink = malloc(64);
+                          free(Sink);
+                          Step.store(2);
+                      });
+    
+    alloc_audit Audit = au_BeginAudit();
+    Step.store(1);
+    while(Step.load() != 2) {}
+    Audit = au_EndAudit(Audit);
+    Other.join();
+    
+    TestCheck(Audit.AllocCount == 0);
+}
+
+void
+TestProcessAudit()
+{
+    // Counts every thread, even with no audit running.
+    au_BeginProcessAudit();
+    alloc_audit Before = au_GetProcessAudit();
+    std::thread Other([]()
+                      {
+                          Sink = malloc(64);
+                          free(Sink);
+                      });
+    Other.join();
+    alloc_audit After = au_GetProcessAudit();
+    
+    TestCheck(After.AllocCount > Before.AllocCount);
+    TestCheck(After.FreeCount > Before.FreeCount);
+    TestCheck(After.AllocSize >= Before.AllocSize + 64);
+}
+
+void
+TestLibraries()
+{
+    // Once set up, arenas, slabs and hash maps never touch the heap.
+    memory_arena Memory = mem_InitReservedMemory(Gigabytes(1));
+    slab_allocator *Slabs = sl_CreateSlabAllocator(&Memory);
+    hash_map<u64, u32> Map;
+    hm_InitHashMap(&Map, &Memory);
+    std::string Short = "short";
+    
+    alloc_audit Audit = au_BeginAudit(true);
+    for(u32 Index = 0; Index < 10000; ++Index)
+    {
+        temporary_memory TempMem = mem_BeginTemporaryMemory(&Memory);
+        mem_PushArray(&Memory, Index % 100 + 1, u64);
+        mem_EndTemporaryMemory(TempMem);
+        
+        void *Object = sl_Alloc(Slabs, Index % 1000 + 1);
+        if(Index & 1)
+        {
+            sl_Free(Slabs, Object);
+        }
+        
+        *hm_Insert(&Map, (u64)Index) = Index;
+    }
+    Short = "also short";
+    Audit = au_EndAudit(Audit);
+    
+    TestCheck(Audit.AllocCount == 0);
+    TestCheck(Audit.FreeCount == 0);
+    TestCheck(Map.Count == 10000);
+    
+    mem_ReleaseReservedMemory(&Memory);
+}
+
+int
+main(int argc, char *argv[])
+{
+    TestCounting();
+    TestNesting();
+    TestThreads();
+    TestLibraries();
+    TestProcessAudit();
+    
+    if(FailCount)
+    {
+        printf("%d allocation audit tests failed.\n", FailCount);
+        return 1;
+    }
+    
+    printf("All allocation audit tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,23 @@
+/** @file
+    @brief Checks shared by the library tests.
+    @author Amos Buchanan
+    @version 1.0
+    @date October 2026
+    @copyright MIT Public License.
+
+Include after the libraries being tested. A failing `TestCheck()` prints the file, line and expression, and adds to `FailCount`, which each test's `main()` reports at the end.
+
+**/
+
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H
+
+#include <stdio.h>
+
+#include "ab_common.h"
+
+static s32 FailCount = 0;
+
+#define TestCheck(test) do { if(!(test)) { printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #test); ++FailCount; } } while(0)
+
+#endif // TEST_COMMON_H
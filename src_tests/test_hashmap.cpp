@@ -0,0 +1,162 @@
+/** @file
+    @brief Tests for ab_hashmap.h.
+    @author Amos Buchanan
+    @version 1.0
+    @date October 2026
+    @copyright MIT Public License.
+
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MEMORY_SRC
+#include "ab_memory.h"
+
+#define AB_STRING_SRC
+#include "ab_string.h"
+
+#define AB_HASHMAP_SRC
+#include "ab_hashmap.h"
+
+#include "test_common.h"
+
+void
+TestIntegerKeys(memory_arena *Memory)
+{
+    hash_map<u32, u64> Map;
+    TestCheck(hm_InitHashMap(&Map, Memory));
+    TestCheck(Map.Capacity == HM_GROUP_SIZE);
+    TestCheck(!hm_Find(&Map, 5u));
+    
+    // Capacities past the limit fail, rather than wrapping around.
+    hash_map<u32, u64> Huge;
+    TestCheck(!hm_InitHashMap(&Huge, Memory, 0xF0000000u));
+    
+    b8 isNew = false;
+    *hm_Insert(&Map, 5u, &isNew) = 50;
+    TestCheck(isNew);
+    *hm_Insert(&Map, 5u, &isNew) += 1;
+    TestCheck(!isNew);
+    TestCheck(*hm_Find(&Map, 5u) == 51);
+    TestCheck(Map.Count == 1);
+    
+    // Grows past the initial capacity, keeping every key.
+    for(u32 Key = 0; Key < 10000; ++Key)
+    {
+        *hm_Insert(&Map, Key * 7919u) = Key;
+    }
+    TestCheck(Map.Capacity > 10000 && Map.Capacity < 32768);
+    
+    b8 isFound = true;
+    for(u32 Key = 0; Key < 10000; ++Key)
+    {
+        u64 *Value = hm_Find(&Map, Key * 7919u);
+        isFound = isFound && Value && *Value == Key;
+    }
+    TestCheck(isFound);
+    
+    u32 UsedSlots = 0;
+    for(u32 Slot = 0; Slot < Map.Capacity; ++Slot)
+    {
+        UsedSlots += hm_IsSlotUsed(&Map, Slot) ? 1 : 0;
+    }
+    TestCheck(UsedSlots == Map.Count);
+    
+    hm_Clear(&Map);
+    TestCheck(Map.Count == 0);
+    TestCheck(!hm_Find(&Map, 7919u));
+}
+
+void
+TestStringKeys(memory_arena *Memory)
+{
+    hash_map<st_ptr, u32> Map;
+    hm_InitHashMap(&Map, Memory, 100);
+    TestCheck(Map.Capacity == 128);
+    
+    char const *Text = "the quick brown fox jumps over the lazy dog the end";
+    char const *WordStart = Text;
+    for(char const *At = Text; ; ++At)
+    {
+        if(*At == ' ' || *At == 0)
+        {
+            *hm_Insert(&Map, st_ptr(WordStart, (u32)(At - WordStart))) += 1;
+            WordStart = At + 1;
+        }
+        if(*At == 0)
+        {
+            break;
+        }
+    }
+    
+    // Keys are compared by contents, not by pointer.
+    TestCheck(Map.Count == 9);
+    TestCheck(*hm_Find(&Map, st_ptr("the")) == 3);
+    TestCheck(*hm_Find(&Map, st_ptr("dog")) == 1);
+    TestCheck(!hm_Find(&Map, st_ptr("cat")));
+    TestCheck(!hm_Find(&Map, st_ptr("th")));
+}
+
+void
+TestRandom(memory_arena *Memory)
+{
+    // Random inserts and removes, compared against a plain array.
+    const u32 KeyCount = 4096;
+    static u32 Expected[KeyCount];
+    static b8 isPresent[KeyCount];
+    hash_map<u64, u32> Map;
+    hm_InitHashMap(&Map, Memory);
+    srand(1234);
+    
+    for(u32 Step = 0; Step < 200000; ++Step)
+    {
+        u32 Key = (u32)rand() % KeyCount;
+        if((rand() % 3) == 0)
+        {
+            TestCheck(hm_Remove(&Map, (u64)Key) == isPresent[Key]);
+            isPresent[Key] = false;
+        }
+        else
+        {
+            Expected[Key] = (u32)rand();
+            *hm_Insert(&Map, (u64)Key) = Expected[Key];
+            isPresent[Key] = true;
+        }
+    }
+    
+    b8 isMatched = true;
+    u32 PresentCount = 0;
+    for(u32 Key = 0; Key < KeyCount; ++Key)
+    {
+        u32 *Value = hm_Find(&Map, (u64)Key);
+        isMatched = isMatched && (isPresent[Key] ? (Value && *Value == Expected[Key]) : !Value);
+        PresentCount += isPresent[Key] ? 1 : 0;
+    }
+    TestCheck(isMatched);
+    TestCheck(Map.Count == PresentCount);
+    
+    // Removing and adding keeps reusing slots, so the map doesn't keep growing.
+    TestCheck(Map.Capacity <= 8192);
+}
+
+int
+main(int argc, char *argv[])
+{
+    memory_arena Memory = mem_InitReservedMemory(Gigabytes(1));
+    
+    TestIntegerKeys(&Memory);
+    TestStringKeys(&Memory);
+    TestRandom(&Memory);
+    
+    mem_ReleaseReservedMemory(&Memory);
+    
+    if(FailCount)
+    {
+        printf("%d hash map tests failed.\n", FailCount);
+        return 1;
+    }
+    
+    printf("All hash map tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,174 @@
+/** @file
+    @brief Tests for ab_heap.h.
+    @author Amos Buchanan
+    @version 1.0
+    @date October 2026
+    @copyright MIT Public License.
+
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MEMORY_SRC
+#include "ab_memory.h"
+
+#define AB_HEAP_SRC
+#include "ab_heap.h"
+
+#include "test_common.h"
+
+void
+TestAllocFree(heap *Heap)
+{
+    heap_stats Empty = hp_GetStats(Heap);
+    TestCheck(Empty.FreeBlockCount == 1);
+    TestCheck(Empty.UsedBlockCount == 0);
+    TestCheck(Empty.Fragmentation == 0.0f);
+    
+    u8 *A = (u8*)hp_Alloc(Heap, 1);
+    u8 *B = (u8*)hp_Alloc(Heap, 100, true);
+    u8 *C = (u8*)hp_Alloc(Heap, 5000);
+    TestCheck(A && B && C);
+    TestCheck(((size_t)A % HP_ALIGN) == 0 && ((size_t)B % HP_ALIGN) == 0 && ((size_t)C % HP_ALIGN) == 0);
+    TestCheck(hp_GetSize(B) >= 100);
+    TestCheck(B[99] == 0);
+    TestCheck(!hp_Alloc(Heap, 0));
+    
+    heap_stats Stats = hp_GetStats(Heap);
+    TestCheck(Stats.UsedBlockCount == 3);
+    
+    // Freeing the middle block leaves a hole, then merging closes it again.
+    hp_Free(Heap, B);
+    Stats = hp_GetStats(Heap);
+    TestCheck(Stats.FreeBlockCount == 2);
+    TestCheck(Stats.Fragmentation > 0.0f);
+    
+    hp_Free(Heap, A);
+    hp_Free(Heap, C);
+    Stats = hp_GetStats(Heap);
+    TestCheck(Stats.FreeBlockCount == 1);
+    TestCheck(Stats.UsedBlockCount == 0);
+    TestCheck(Stats.FreeSize == Empty.FreeSize);
+}
+
+void
+TestRealloc(heap *Heap)
+{
+    u8 *A = (u8*)hp_Realloc(Heap, 0, 64);
+    for(u32 Index = 0; Index < 64; ++Index)
+    {
+        A[Index] = (u8)Index;
+    }
+    
+    // Grows in place into the free space after it.
+    u8 *Grown = (u8*)hp_Realloc(Heap, A, 1000);
+    TestCheck(Grown == A);
+    
+    // Moves when the next block is in use, keeping the contents.
+    u8 *Blocker = (u8*)hp_Alloc(Heap, 16);
+    u8 *Moved = (u8*)hp_Realloc(Heap, Grown, 4000);
+    TestCheck(Moved && Moved != Grown);
+    b8 isCopied = true;
+    for(u32 Index = 0; Index < 64; ++Index)
+    {
+        isCopied = isCopied && (Moved[Index] == (u8)Index);
+    }
+    TestCheck(isCopied);
+    
+    u8 *Shrunk = (u8*)hp_Realloc(Heap, Moved, 32);
+    TestCheck(Shrunk == Moved);
+    TestCheck(hp_GetSize(Shrunk) < 4000);
+    
+    TestCheck(!hp_Realloc(Heap, Shrunk, 0));
+    hp_Free(Heap, Blocker);
+    TestCheck(hp_GetStats(Heap).FreeBlockCount == 1);
+}
+
+void
+TestRandom(heap *Heap)
+{
+    // Random allocations and frees, checking that no two live allocations overlap.
+    const u32 SlotCount = 500;
+    u8 *Slots[SlotCount] = {};
+    size_t Sizes[SlotCount] = {};
+    srand(1234);
+    
+    for(u32 Step = 0; Step < 100000; ++Step)
+    {
+        u32 Slot = (u32)rand() % SlotCount;
+        if(Slots[Slot])
+        {
+            TestCheck(Slots[Slot][0] == (u8)Slot && Slots[Slot][Sizes[Slot] - 1] == (u8)Slot);
+            if(rand() & 1)
+            {
+                hp_Free(Heap, Slots[Slot]);
+                Slots[Slot] = 0;
+            }
+            else
+            {
+                size_t NewSize = 1 + (rand() % 3000);
+                u8 *NewMemory = (u8*)hp_Realloc(Heap, Slots[Slot], NewSize);
+                if(NewMemory)
+                {
+                    Slots[Slot] = NewMemory;
+                    Sizes[Slot] = NewSize;
+                    memset(NewMemory, (u8)Slot, NewSize);
+                }
+            }
+        }
+        else
+        {
+            Sizes[Slot] = 1 + (rand() % ((rand() & 7) ? 256 : 20000));
+            Slots[Slot] = (u8*)hp_Alloc(Heap, Sizes[Slot]);
+            if(Slots[Slot])
+            {
+                memset(Slots[Slot], (u8)Slot, Sizes[Slot]);
+            }
+        }
+    }
+    
+    b8 isIntact = true;
+    for(u32 Slot = 0; Slot < SlotCount; ++Slot)
+    {
+        if(Slots[Slot])
+        {
+            for(size_t Index = 0; Index < Sizes[Slot]; ++Index)
+            {
+                isIntact = isIntact && (Slots[Slot][Index] == (u8)Slot);
+            }
+            hp_Free(Heap, Slots[Slot]);
+        }
+    }
+    TestCheck(isIntact);
+    
+    heap_stats Stats = hp_GetStats(Heap);
+    TestCheck(Stats.FreeBlockCount == 1);
+    TestCheck(Stats.UsedBlockCount == 0);
+}
+
+int
+main(int argc, char *argv[])
+{
+    void *OsMemory = mem_AllocateOsMemory(NULL, Megabytes(4));
+    memory_arena Memory = mem_InitMemory(OsMemory, Megabytes(4), true);
+    
+    heap *Heap = hp_CreateHeap(&Memory, Megabytes(2));
+    TestCheck(Heap);
+    
+    TestAllocFree(Heap);
+    TestRealloc(Heap);
+    TestRandom(Heap);
+    
+    mem_DeallocateOsMemory(OsMemory, Megabytes(4));
+    
+    if(FailCount)
+    {
+        printf("%d heap tests failed.\n", FailCount);
+        return 1;
+    }
+    
+    printf("All heap tests passed.\n");
+    return 0;
+}
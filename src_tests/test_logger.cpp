@@ -61,11 +61,13 @@ main(int argc, char *argv[])
         printf("Created logger on port %d.\n", Port);
     }
     
+    u32 LoopCount = 0;
     while(isRunning)
     {
         sleep(2);
         
         log_SetLevel(Logger, LOGGER_TRACE);
+        log_info(Logger, "Loop %u, port %d, %s, %.2f seconds, %5.1f%%.", ++LoopCount, Port, argv[0], 2.0, 50.0);
         log_trace(Logger, "Trace Log.");
         log_debug(Logger, "Debug Log.");
         log_info(Logger, "Info Log");
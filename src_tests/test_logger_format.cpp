@@ -0,0 +1,126 @@
+/** @file
+    @brief Tests for packing deferred log arguments in ab_logger.h and formatting them in ab_loggerclient.h.
+    @author Amos Buchanan
+    @version 1.0
+    @date October 2026
+    @copyright MIT Public License.
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+
+#define MEMORY_SRC
+#include "ab_memory.h"
+
+#define AB_LOGGER_SRC
+#include "ab_logger.h"
+
+#define AB_LOGGERCLIENT_SRC
+#include "ab_loggerclient.h"
+
+#include "test_common.h"
+
+enum test_enum
+{
+    TestEnum_First,
+    TestEnum_Second,
+};
+
+// NOTE(amos): Packs the arguments the way a deferred log call does, then formats them the way the client does.
+template<typename... Args>
+b8
+IsFormatted(char const *Expected, char const *Format, Args... Arguments)
+{
+    char const *ArgTypes = decltype(log_GetArgTypes_(Arguments...))::Types;
+    u8 Record[LOG_DEFERRED_BUFFER_SIZE];
+    log_packer Packer = {Record, Record + sizeof(Record)};
+    (log_PackArg_(&Packer, Arguments), ...);
+    
+    char Text[LC_MESSAGE_SIZE];
+    lc_FormatDeferred(Format, ArgTypes, Record, Packer.At - Record, Text, sizeof(Text));
+    
+    b8 Result = strcmp(Text, Expected) == 0;
+    if(!Result)
+    {
+        printf("Formatted \"%s\" as \"%s\", expected \"%s\".\n", Format, Text, Expected);
+    }
+    
+    return Result;
+}
+
+void
+TestConversions()
+{
+    char Name[] = "name";
+    
+    TestCheck(IsFormatted("plain", "plain"));
+    TestCheck(IsFormatted("100% done", "100%% done"));
+    TestCheck(IsFormatted("-3 7 -123456789012 1234567890123 -4", "%d %u %ld %lu %hhd",
+                          -3, 7u, -123456789012L, 1234567890123UL, (char)-4));
+    TestCheck(IsFormatted("ff 00000ABC 42   |", "%x %08X %-5d|", 255, 0xabcu, 42));
+    TestCheck(IsFormatted("-1 18446744073709551615", "%lld %llu", (long long)-1, ~0ull));
+    TestCheck(IsFormatted("3.14 1.000000e-05      2.5", "%.2f %e %8.3g", 3.14159, 1e-5f, 2.5));
+    TestCheck(IsFormatted("hello he   name|ab    |", "%s %.2s %6s|%-6s|", "hello", "hello", Name, "ab"));
+    TestCheck(IsFormatted("hi 0x1234", "%c%c %p", 'h', 'i', (void*)0x1234));
+    TestCheck(IsFormatted("0 1", "%d %d", TestEnum_First, TestEnum_Second));
+}
+
+void
+TestStarArguments()
+{
+    TestCheck(IsFormatted("    1|2   |1.000|xy", "%*d|%-*d|%.*f|%.*s", 5, 1, 4, 2, 3, 1.0, 2, "xyz"));
+}
+
+void
+TestStrings()
+{
+    char const *Null = 0;
+    TestCheck(IsFormatted("(null) x", "%s x", Null));
+    
+    // A string that doesn't fit is cut short, and the arguments after it are lost.
+    char Long[600];
+    memset(Long, 'a', sizeof(Long) - 1);
+    Long[sizeof(Long) - 1] = 0;
+    
+    char Expected[600];
+    size_t KeptLength = LOG_DEFERRED_BUFFER_SIZE - sizeof(u16);
+    memset(Expected, 'a', KeptLength);
+    strcpy(Expected + KeptLength, " <?>");
+    TestCheck(IsFormatted(Expected, "%s %d", Long, 5));
+    
+    // The text itself is cut short to fit the buffer.
+    u8 Record[16];
+    log_packer Packer = {Record, Record + sizeof(Record)};
+    log_PackArg_(&Packer, 12345);
+    char Small[8];
+    lc_FormatDeferred("%d long text", "i", Record, Packer.At - Record, Small, sizeof(Small));
+    TestCheck(strcmp(Small, "12345 l") == 0);
+}
+
+void
+TestMismatches()
+{
+    // Arguments that don't match their conversion, or are missing, print "<?>" rather than reading the wrong thing.
+    TestCheck(IsFormatted("<?> 2", "%s %d", 1, 2));
+    TestCheck(IsFormatted("1 <?>", "%d %d", 1));
+    TestCheck(IsFormatted("<?>", "%d", "text"));
+}
+
+int
+main(int argc, char *argv[])
+{
+    TestConversions();
+    TestStarArguments();
+    TestStrings();
+    TestMismatches();
+    
+    if(FailCount)
+    {
+        printf("%d logger format tests failed.\n", FailCount);
+        return 1;
+    }
+    
+    printf("All logger format tests passed.\n");
+    return 0;
+}
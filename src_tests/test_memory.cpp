@@ -0,0 +1,1071 @@
+/** @file
+    @brief Tests for ab_memory.h.
+    @author Amos Buchanan
+    @version 1.0
+    @date October 2026
+    @copyright MIT Public License.
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define MEMORY_SRC
+#include "ab_memory.h"
+
+#include "test_common.h"
+
+void
+TestFixedArena()
+{
+    void *OsMemory = mem_AllocateOsMemory(NULL, Kilobytes(4));
+    TestCheck(OsMemory);
+    
+    memory_arena Memory = mem_InitMemory(OsMemory, Kilobytes(4));
+    u8 *Bytes = mem_PushArray(&Memory, 100, u8);
+    TestCheck(Bytes == OsMemory);
+    TestCheck(Memory.Used == 100);
+    
+    temporary_memory TempMem = mem_BeginTemporaryMemory(&Memory);
+    mem_PushSize(&Memory, 200);
+    TestCheck(Memory.Used == 300);
+    mem_EndTemporaryMemory(TempMem);
+    TestCheck(Memory.Used == 100);
+    
+    mem_ResetMemory(&Memory);
+    TestCheck(Memory.Used == 0);
+    
+#ifndef _DEBUG
+    // A sub-arena that doesn't fit is empty, so pushes to it fail too.
+    memory_arena SubArena = mem_CreateSubArena(&Memory, Kilobytes(8));
+    TestCheck(!SubArena.Start && SubArena.Size == 0 && SubArena.Committed == 0);
+    TestCheck(!mem_PushSize(&SubArena, 16));
+    SubArena = mem_CreateSubArena(&Memory, SIZE_MAX - 2, 64);
+    TestCheck(!SubArena.Start && SubArena.Size == 0);
+    TestCheck(!mem_PushSize(&Memory, SIZE_MAX - 2));
+    TestCheck(Memory.Used == 0);
+#endif
+    
+    mem_DeallocateOsMemory(OsMemory, Kilobytes(4));
+}
+
+void
+TestGrowableArena()
+{
+    void *OsMemory = mem_AllocateOsMemory(NULL, Kilobytes(4));
+    memory_arena Memory = mem_InitGrowableMemory(OsMemory, Kilobytes(4), Kilobytes(4));
+    
+    mem_PushSize(&Memory, Kilobytes(3));
+    TestCheck(Memory.BlockCount == 0);
+    
+    temporary_memory TempMem = mem_BeginTemporaryMemory(&Memory);
+    
+    // Spills into a new 4kb block, then an 8kb block.
+    u8 *First = (u8*)mem_PushSize(&Memory, Kilobytes(2));
+    TestCheck(First);
+    TestCheck(Memory.BlockCount == 1);
+    u8 *Second = (u8*)mem_PushSize(&Memory, Kilobytes(3));
+    TestCheck(Second);
+    TestCheck(Memory.BlockCount == 2);
+    TestCheck(Memory.Size >= Kilobytes(7));
+    
+    // A push larger than the next block size gets a block of its own.
+    u8 *Large = (u8*)mem_PushSize(&Memory, Megabytes(1));
+    TestCheck(Large);
+    TestCheck(Memory.BlockCount == 3);
+    Large[Megabytes(1) - 1] = 1;
+    
+    mem_EndTemporaryMemory(TempMem);
+    TestCheck(Memory.BlockCount == 0);
+    TestCheck(Memory.Start == OsMemory);
+    TestCheck(Memory.Used == Kilobytes(3));
+    
+    mem_PushSize(&Memory, Kilobytes(8));
+    TestCheck(Memory.BlockCount == 1);
+    mem_ResetMemory(&Memory);
+    TestCheck(Memory.BlockCount == 0);
+    TestCheck(Memory.Start == OsMemory);
+    TestCheck(Memory.Used == 0);
+    
+#ifndef _DEBUG
+    // A size so large that adding the alignment or block header would wrap around fails, rather than getting a tiny block.
+    TestCheck(!mem_PushSize_(&Memory, SIZE_MAX - 2, false, 64));
+    TestCheck(!mem_PushSize(&Memory, SIZE_MAX - 8));
+    TestCheck(Memory.BlockCount == 0);
+#endif
+    
+    mem_DeallocateOsMemory(OsMemory, Kilobytes(4));
+}
+
+void
+TestReservedArena()
+{
+    memory_arena Memory = mem_InitReservedMemory(Gigabytes(4));
+    TestCheck(Memory.Start);
+    TestCheck(Memory.Committed == 0);
+    
+    u8 *Bytes = mem_PushArray(&Memory, 100, u8);
+    TestCheck(Bytes == Memory.Start);
+    TestCheck(Memory.Committed == MEM_COMMIT_GRANULARITY);
+    
+    u8 *Large = mem_PushArray(&Memory, Megabytes(100), u8);
+    TestCheck(Large);
+    TestCheck(Memory.Committed >= Megabytes(100) + 100);
+    Large[Megabytes(100) - 1] = 1;
+    
+    mem_ResetMemory(&Memory);
+    TestCheck(Memory.Committed >= Megabytes(100));
+    mem_ResetMemory(&Memory, true);
+    TestCheck(Memory.Committed == 0);
+    
+    // Decommitted pages read back as zero.
+    Large = (u8*)mem_PushSize_(&Memory, Megabytes(100) + 100, false);
+    TestCheck(Large[Megabytes(100) - 1 + 100] == 0);
+    
+    // Arrays of unknown size don't commit the rest of the reservation.
+    mem_ResetMemory(&Memory, true);
+    memory_array Array;
+    u32 *Elements = mem_BeginArray(&Memory, u32, &Array);
+    TestCheck(Memory.Committed == MEM_COMMIT_GRANULARITY);
+    TestCheck(Array.MaxElementCount == MEM_COMMIT_GRANULARITY/sizeof(u32));
+    Elements[Array.MaxElementCount - 1] = 1;
+    mem_EndArray(&Array, 10);
+    TestCheck(Memory.Used == 10*sizeof(u32));
+    
+    Elements = mem_BeginArrayMax(&Memory, u32, Megabytes(1), &Array);
+    TestCheck(Array.MaxElementCount == Megabytes(1));
+    TestCheck(Memory.Committed >= Megabytes(4));
+    TestCheck(Memory.Committed < Megabytes(5));
+    Elements[Array.MaxElementCount - 1] = 1;
+    mem_EndArray(&Array, Megabytes(1));
+    TestCheck(Memory.Used == 10*sizeof(u32) + Megabytes(4));
+    
+    mem_ReleaseReservedMemory(&Memory);
+    TestCheck(!Memory.Start);
+}
+
+void
+TestClearMemory()
+{
+    size_t Size = MEM_NONTEMPORAL_THRESHOLD + Kilobytes(4);
+    void *OsMemory = mem_AllocateOsMemory(NULL, Size);
+    memory_arena Memory = mem_InitMemory(OsMemory, Size, true);
+    TestCheck(Memory.Dirty == 0);
+    
+    u8 *Bytes = mem_PushArray(&Memory, 3, u8);
+    TestCheck(Memory.Dirty == 3);
+    
+    // Dirty memory is cleared again on the next push, for sizes on either side of the SSE2 and non-temporal paths.
+    size_t Sizes[] = {1, 63, 64, 1000, MEM_NONTEMPORAL_THRESHOLD + 17};
+    for(u32 Index = 0; Index < ArrayCount(Sizes); ++Index)
+    {
+        temporary_memory TempMem = mem_BeginTemporaryMemory(&Memory);
+        u8 *Dirty = mem_PushArray(&Memory, Sizes[Index], u8);
+        memset(Dirty, 0xFF, Sizes[Index]);
+        mem_EndTemporaryMemory(TempMem);
+        TestCheck(Memory.Dirty >= 3 + Sizes[Index]);
+        
+        u8 *Cleared = mem_PushArray(&Memory, Sizes[Index] + 1, u8);
+        b8 isCleared = true;
+        for(size_t ByteIndex = 0; ByteIndex < Sizes[Index] + 1; ++ByteIndex)
+        {
+            isCleared = isCleared && (Cleared[ByteIndex] == 0);
+        }
+        TestCheck(isCleared);
+        mem_EndTemporaryMemory(TempMem);
+    }
+    
+    mem_DeallocateOsMemory(OsMemory, Size);
+}
+
+void
+TestAlignedPush()
+{
+    void *OsMemory = mem_AllocateOsMemory(NULL, Kilobytes(64));
+    memory_arena Memory = mem_InitMemory(OsMemory, Kilobytes(64), true);
+    
+    mem_PushArray(&Memory, 3, u8);
+    r64 *Doubles = mem_PushArrayAligned(&Memory, 10, r64, alignof(r64));
+    TestCheck(((size_t)Doubles % alignof(r64)) == 0);
+    
+    mem_PushArray(&Memory, 1, u8);
+    u8 *Simd = mem_PushArrayAligned(&Memory, 64, u8, 32);
+    TestCheck(((size_t)Simd % 32) == 0);
+    
+    u8 *Page = (u8*)mem_PushSizeAligned(&Memory, 10, mem_GetPageSize());
+    TestCheck(((size_t)Page % mem_GetPageSize()) == 0);
+    
+    mem_PushArray(&Memory, 1, u8);
+    memory_arena SubArena = mem_CreateSubArena(&Memory, 100, MEM_CACHE_LINE_SIZE);
+    TestCheck(((size_t)SubArena.Start % MEM_CACHE_LINE_SIZE) == 0);
+    TestCheck(SubArena.Size == 128);
+    TestCheck((Memory.Used % MEM_CACHE_LINE_SIZE) == 0);
+    
+    // Alignment carries over into new blocks of a growable arena.
+    memory_arena Growable = mem_InitGrowableMemory(0, 0, Kilobytes(4));
+    mem_PushArray(&Growable, 1, u8);
+    u8 *Large = (u8*)mem_PushSizeAligned(&Growable, Kilobytes(8), mem_GetPageSize());
+    TestCheck(((size_t)Large % mem_GetPageSize()) == 0);
+    mem_ResetMemory(&Growable);
+    
+    mem_DeallocateOsMemory(OsMemory, Kilobytes(64));
+}
+
+void
+TestHugePages()
+{
+    u32 AppliedFlags = MEM_Null;
+    u8 *Memory = (u8*)mem_AllocateOsMemory(NULL, Megabytes(4), MEM_HugePages, &AppliedFlags);
+    TestCheck(Memory);
+    if(AppliedFlags & (MEM_HugePages | MEM_TransparentHugePages))
+    {
+        TestCheck(((size_t)Memory % Megabytes(2)) == 0);
+    }
+    Memory[Megabytes(4) - 1] = 1;
+    mem_DeallocateOsMemory(Memory, Megabytes(4));
+    
+    // Sizes that aren't a multiple of the huge page size still get memory.
+    Memory = (u8*)mem_AllocateOsMemory(NULL, Kilobytes(12), MEM_HugePages1GB, &AppliedFlags);
+    TestCheck(Memory);
+    TestCheck(!(AppliedFlags & (MEM_HugePages | MEM_HugePages1GB)));
+    mem_DeallocateOsMemory(Memory, Kilobytes(12));
+}
+
+void
+TestPrefault()
+{
+    size_t PageSize = mem_GetPageSize();
+    size_t Size = 64*PageSize;
+    
+    void *Lazy = mem_AllocateOsMemory(NULL, Size);
+    TestCheck(mem_GetResidentPageCount(Lazy, Size) == 0);
+    mem_DeallocateOsMemory(Lazy, Size);
+    
+    u32 AppliedFlags = MEM_Null;
+    void *Prefaulted = mem_AllocateOsMemory(NULL, Size, MEM_Prefault | MEM_Lock, &AppliedFlags);
+    TestCheck(AppliedFlags & MEM_Prefault);
+    TestCheck(mem_GetResidentPageCount(Prefaulted, Size) == 64);
+    mem_DeallocateOsMemory(Prefaulted, Size);
+    
+    // A range that starts partway into a page still reaches the page its end falls in.
+    u8 *Unaligned = (u8*)mem_AllocateOsMemory(NULL, Size);
+    mem_PrefaultOsMemory(Unaligned + PageSize/2, PageSize);
+    TestCheck(mem_GetResidentPageCount(Unaligned, Size) == 2);
+    mem_DeallocateOsMemory(Unaligned, Size);
+    
+    memory_arena Memory = mem_InitReservedMemory(Gigabytes(1));
+    TestCheck(mem_PrefaultMemory(&Memory, Size, false));
+    TestCheck(Memory.Committed >= Size);
+    TestCheck(mem_GetResidentPageCount(Memory.Start, Size) == 64);
+    TestCheck(Memory.Used == 0);
+    mem_ReleaseReservedMemory(&Memory);
+}
+
+void
+TestNumaArenas()
+{
+    u32 MaxNode = mem_GetNumaMaxNode();
+    TestCheck(mem_GetCurrentNumaNode() <= MaxNode);
+    
+    u32 AppliedFlags = MEM_Null;
+    void *NodeMemory = mem_AllocateOsMemory(NULL, Kilobytes(64), MEM_Prefault, &AppliedFlags, 0);
+    TestCheck(NodeMemory);
+    mem_DeallocateOsMemory(NodeMemory, Kilobytes(64));
+    
+    memory_numa_arenas NumaArenas = {};
+    TestCheck(mem_InitNumaArenas(&NumaArenas, Kilobytes(64)));
+    TestCheck(NumaArenas.NodeCount == MINIMUM(MaxNode + 1, MEM_MAX_NUMA_NODES));
+    
+    memory_arena *LocalArena = mem_GetLocalNumaArena(&NumaArenas);
+    TestCheck(LocalArena);
+    TestCheck(mem_PushArray(LocalArena, 100, u8));
+    
+    mem_ReleaseNumaArenas(&NumaArenas);
+    TestCheck(NumaArenas.NodeCount == 0);
+}
+
+u8 *
+BuildScratchResult(memory_arena *ResultMemory)
+{
+    scratch_memory Scratch(ResultMemory);
+    TestCheck(Scratch.Arena);
+    TestCheck(Scratch.Arena != ResultMemory);
+    
+    u8 *Working = mem_PushArray(Scratch.Arena, 64, u8);
+    u8 *Result = mem_PushArray(ResultMemory, 64, u8);
+    Result[0] = 1;
+    
+    return Result;
+}
+
+void
+TestScratch()
+{
+    scratch_memory Outer;
+    TestCheck(Outer.Arena);
+    
+    // Results built into one scratch arena get working memory from the other.
+    u8 *Result = BuildScratchResult(Outer.Arena);
+    TestCheck(Result[0] == 1);
+    size_t OuterUsed = Outer.Arena->Used;
+    
+    // Arenas created inside a scratch arena conflict with it too.
+    memory_arena SubArena = mem_CreateSubArena(Outer.Arena, Kilobytes(1));
+    temporary_memory Inner = mem_GetScratch(&SubArena);
+    TestCheck(Inner.Arena && Inner.Arena != Outer.Arena);
+    mem_ReleaseScratch(Inner);
+    
+    TestCheck(Outer.Arena->Used == OuterUsed + Kilobytes(1));
+}
+
+void
+ConcurrentWorker(concurrent_arena *Arena, u32 WorkerIndex, u64 **Results)
+{
+    concurrent_chunk Chunk = {};
+    for(u32 Index = 0; Index < 1000; ++Index)
+    {
+        u64 *Value = mem_PushConcurrentStruct(Arena, &Chunk, u64);
+        *Value = ((u64)WorkerIndex << 32) | Index;
+        Results[WorkerIndex*1000 + Index] = Value;
+    }
+    
+    // Large pushes go straight to the arena.
+    u8 *Large = mem_PushConcurrentArray(Arena, &Chunk, Kilobytes(8), u8);
+    Large[Kilobytes(8) - 1] = 1;
+}
+
+void
+TestConcurrentArena()
+{
+    const u32 WorkerCount = 4;
+    void *OsMemory = mem_AllocateOsMemory(NULL, Megabytes(1));
+    concurrent_arena Arena;
+    mem_InitConcurrentArena(&Arena, OsMemory, Megabytes(1), Kilobytes(4));
+    
+    // Pushes only write Used, so nothing they read may share its cache line.
+    size_t UsedLine = ((size_t)&Arena.Used)/MEM_CACHE_LINE_SIZE;
+    TestCheck(((size_t)&Arena.Generation)/MEM_CACHE_LINE_SIZE != UsedLine);
+    TestCheck(((size_t)&Arena.ChunkSize)/MEM_CACHE_LINE_SIZE != UsedLine);
+    TestCheck(sizeof(concurrent_arena) % MEM_CACHE_LINE_SIZE == 0);
+    
+    u64 *Results[WorkerCount*1000];
+    for(u32 Frame = 0; Frame < 3; ++Frame)
+    {
+        std::thread Workers[WorkerCount];
+        for(u32 WorkerIndex = 0; WorkerIndex < WorkerCount; ++WorkerIndex)
+        {
+            Workers[WorkerIndex] = std::thread(ConcurrentWorker, &Arena, WorkerIndex, Results);
+        }
+        for(u32 WorkerIndex = 0; WorkerIndex < WorkerCount; ++WorkerIndex)
+        {
+            Workers[WorkerIndex].join();
+        }
+        
+        // No two pushes overlapped.
+        b8 isIntact = true;
+        for(u32 WorkerIndex = 0; WorkerIndex < WorkerCount; ++WorkerIndex)
+        {
+            for(u32 Index = 0; Index < 1000; ++Index)
+            {
+                isIntact = isIntact && (*Results[WorkerIndex*1000 + Index] == (((u64)WorkerIndex << 32) | Index));
+            }
+        }
+        TestCheck(isIntact);
+        
+        mem_ResetConcurrentArena(&Arena);
+        TestCheck(Arena.Used == 0);
+    }
+    
+    // A chunk from before a reset is dropped.
+    concurrent_chunk Chunk = {};
+    u8 *First = mem_PushConcurrentArray(&Arena, &Chunk, 8, u8);
+    mem_ResetConcurrentArena(&Arena);
+    u8 *Second = mem_PushConcurrentArray(&Arena, &Chunk, 8, u8);
+    TestCheck(First == Second);
+    
+    mem_DeallocateOsMemory(OsMemory, Megabytes(1));
+}
+
+struct test_pool_item
+{
+    u64 Id;
+    test_pool_item *Next;
+};
+
+void
+PoolWorker(memory_pool *Pool)
+{
+    memory_pool_cache Cache = mem_InitPoolCache(Pool);
+    test_pool_item *Held[16];
+    for(u32 Round = 0; Round < 100; ++Round)
+    {
+        for(u32 Index = 0; Index < ArrayCount(Held); ++Index)
+        {
+            Held[Index] = (test_pool_item*)mem_PoolAllocCached(&Cache);
+            Held[Index]->Id = Index;
+        }
+        for(u32 Index = 0; Index < ArrayCount(Held); ++Index)
+        {
+            mem_PoolFreeCached(&Cache, Held[Index]);
+        }
+    }
+    mem_FlushPoolCache(&Cache);
+}
+
+void
+TestPool()
+{
+    void *OsMemory = mem_AllocateOsMemory(NULL, Kilobytes(64));
+    memory_arena Memory = mem_InitMemory(OsMemory, Kilobytes(64), true);
+    
+    memory_pool *Pool = mem_PushPool(&Memory, test_pool_item, 4);
+    TestCheck(Pool);
+    TestCheck(mem_GetPoolItemsLeft(Pool) == 4);
+    
+    test_pool_item *Items[4];
+    for(u32 Index = 0; Index < ArrayCount(Items); ++Index)
+    {
+        Items[Index] = mem_PoolAllocStruct(Pool, test_pool_item);
+        TestCheck(Items[Index] && Items[Index]->Id == 0);
+        Items[Index]->Id = Index + 1;
+    }
+    TestCheck(!mem_PoolAlloc(Pool));
+    
+    // Freed items are reused, and cleared.
+    mem_PoolFree(Pool, Items[2]);
+    test_pool_item *Reused = mem_PoolAllocStruct(Pool, test_pool_item);
+    TestCheck(Reused == Items[2]);
+    TestCheck(Reused->Id == 0);
+    for(u32 Index = 0; Index < ArrayCount(Items); ++Index)
+    {
+        mem_PoolFree(Pool, Items[Index]);
+    }
+    TestCheck(mem_GetPoolItemsLeft(Pool) == 4);
+    
+    // Threads sharing a pool through their caches.
+    memory_pool *SharedPool = mem_PushPool(&Memory, test_pool_item, 200);
+    std::thread Workers[4];
+    for(u32 WorkerIndex = 0; WorkerIndex < ArrayCount(Workers); ++WorkerIndex)
+    {
+        Workers[WorkerIndex] = std::thread(PoolWorker, SharedPool);
+    }
+    for(u32 WorkerIndex = 0; WorkerIndex < ArrayCount(Workers); ++WorkerIndex)
+    {
+        Workers[WorkerIndex].join();
+    }
+    TestCheck(mem_GetPoolItemsLeft(SharedPool) == 200);
+    
+    mem_DeallocateOsMemory(OsMemory, Kilobytes(64));
+}
+
+void
+TestVirtualArray()
+{
+    // Two arrays grow at once, interleaved with pushes to a regular arena.
+    memory_arena Memory = mem_InitReservedMemory(Megabytes(16));
+    memory_virtual_array Evens = mem_InitVirtualArray(1000000, u32);
+    memory_virtual_array Odds = mem_InitVirtualArray(1000000, u32);
+    TestCheck(Evens.Arena.Start && Odds.Arena.Start);
+    
+    u32 *FirstEven = mem_PushVirtualArray(&Evens, 1, u32);
+    for(u32 Value = 0; Value < 200000; ++Value)
+    {
+        memory_virtual_array *Array = (Value & 1) ? &Odds : &Evens;
+        u32 *Element = (Value == 0) ? FirstEven : mem_PushVirtualArray(Array, 1, u32);
+        *Element = Value;
+        mem_PushStruct(&Memory, u32);
+    }
+    
+    TestCheck(Evens.Count == 100000 && Odds.Count == 100000);
+    TestCheck(mem_GetVirtualArray(&Evens, u32) == FirstEven);
+    TestCheck(mem_GetVirtualArray(&Odds, u32)[99999] == 199999);
+    TestCheck(Evens.Arena.Committed < Megabytes(1));
+    
+    mem_PopVirtualArray(&Odds, 10);
+    TestCheck(Odds.Count == 99990);
+    TestCheck(*mem_PushVirtualArray(&Odds, 1, u32) == 0);
+    
+    mem_ClearVirtualArray(&Evens, true);
+    TestCheck(Evens.Count == 0 && Evens.Arena.Committed == 0);
+    TestCheck(mem_PushVirtualArray(&Evens, 1, u32) == FirstEven);
+    
+    mem_ReleaseVirtualArray(&Evens);
+    mem_ReleaseVirtualArray(&Odds);
+    mem_ReleaseReservedMemory(&Memory);
+    TestCheck(!Evens.Arena.Start);
+}
+
+struct file_table
+{
+    u32 Count;
+    u32 *Values;
+};
+
+void
+TestFileMemory()
+{
+    char const *Path = "test_memory_file.arena";
+    remove(Path);
+    
+    b8 isRestored = true;
+    memory_arena Memory = mem_OpenFileMemory(Path, Megabytes(4), 1, &isRestored);
+    TestCheck(Memory.Start);
+    TestCheck(!isRestored);
+    
+    // Pointers inside the arena are kept, since it's mapped back at the same address.
+    void *Start = Memory.Start;
+    file_table *Table = mem_PushStruct(&Memory, file_table);
+    Table->Count = 1000;
+    Table->Values = mem_PushArray(&Memory, Table->Count, u32);
+    for(u32 Index = 0; Index < Table->Count; ++Index)
+    {
+        Table->Values[Index] = Index*Index;
+    }
+    size_t Used = Memory.Used;
+    TestCheck(mem_SaveFileMemory(&Memory));
+    mem_CloseFileMemory(&Memory);
+    TestCheck(!Memory.Start);
+    
+    Memory = mem_OpenFileMemory(Path, Megabytes(4), 1, &isRestored);
+    TestCheck(isRestored);
+    TestCheck(Memory.Start == Start);
+    TestCheck(Memory.Used == Used);
+    Table = (file_table*)Memory.Start;
+    TestCheck(Table->Count == 1000 && Table->Values[999] == 999*999);
+    
+    // Changes after the save are written to the file, but the saved Used is kept.
+    mem_PushArray(&Memory, 100, u8);
+    mem_CloseFileMemory(&Memory);
+    Memory = mem_OpenFileMemory(Path, Megabytes(4), 1, &isRestored);
+    TestCheck(isRestored && Memory.Used == Used);
+    mem_CloseFileMemory(&Memory);
+    
+    // A different version starts over, and old data is cleared when pushed again.
+    Memory = mem_OpenFileMemory(Path, Megabytes(4), 2, &isRestored);
+    TestCheck(!isRestored);
+    TestCheck(Memory.Used == 0);
+    Table = mem_PushStruct(&Memory, file_table);
+    TestCheck(Table->Count == 0);
+    mem_CloseFileMemory(&Memory);
+    
+    // Never saved, so not restored.
+    Memory = mem_OpenFileMemory(Path, Megabytes(4), 2, &isRestored);
+    TestCheck(!isRestored);
+    mem_CloseFileMemory(&Memory);
+    
+    remove(Path);
+}
+
+struct shared_item
+{
+    u32 Process;
+    u32 Index;
+    u64 Offset;
+};
+
+struct shared_root
+{
+    std::atomic<u32> PushCount;
+};
+
+void
+TestSharedArena()
+{
+    char const *Name = "/ab_test_memory_shared";
+    const u32 ProcessCount = 4;
+    const u32 ItemCount = 1000;
+    mem_RemoveSharedOsMemory(Name);
+    
+    shared_arena Arena = mem_OpenSharedArena(Name, Megabytes(1));
+    TestCheck(Arena.Start);
+    TestCheck(!mem_GetSharedRoot(&Arena));
+    shared_root *Root = mem_PushSharedStruct(&Arena, shared_root);
+    mem_SetSharedRoot(&Arena, Root);
+    
+    // Each child process maps the arena at its own address, and pushes items that record their own offset.
+    for(u32 Process = 0; Process < ProcessCount; ++Process)
+    {
+        if(fork() == 0)
+        {
+            mem_CloseSharedArena(&Arena);
+            shared_arena ChildArena = mem_OpenSharedArena(Name, Megabytes(1));
+            shared_root *ChildRoot = (shared_root*)mem_GetSharedRoot(&ChildArena);
+            for(u32 Index = 0; Index < ItemCount; ++Index)
+            {
+                shared_item *Item = mem_PushSharedStruct(&ChildArena, shared_item);
+                Item->Process = Process + 1;
+                Item->Index = Index;
+                Item->Offset = mem_GetSharedOffset(&ChildArena, Item);
+                ChildRoot->PushCount.fetch_add(1);
+            }
+            _exit(0);
+        }
+    }
+    
+    for(u32 Process = 0; Process < ProcessCount; ++Process)
+    {
+        wait(0);
+    }
+    
+    TestCheck(Root->PushCount.load() == ProcessCount*ItemCount);
+    
+    u32 ItemsFound = 0;
+    b8 isIntact = true;
+    for(u64 Offset = 8; Offset + sizeof(shared_item) <= Arena.Header->Used.load(); Offset += sizeof(shared_item))
+    {
+        shared_item *Item = (shared_item*)mem_GetSharedAddress(&Arena, Offset);
+        isIntact = isIntact && Item->Offset == Offset && Item->Process >= 1 && Item->Process <= ProcessCount && Item->Index < ItemCount;
+        ++ItemsFound;
+    }
+    TestCheck(isIntact);
+    TestCheck(ItemsFound == ProcessCount*ItemCount);
+    
+    // Opening with the wrong size fails right away, without asserting.
+    u64 StartMs = mem_GetOsMilliseconds();
+    shared_arena WrongSize = mem_OpenSharedArena(Name, Megabytes(2));
+    TestCheck(!WrongSize.Start);
+    WrongSize = mem_OpenSharedArena(Name, Kilobytes(512));
+    TestCheck(!WrongSize.Start);
+    TestCheck((mem_GetOsMilliseconds() - StartMs) < 500);
+    
+    mem_CloseSharedArena(&Arena);
+    mem_RemoveSharedOsMemory(Name);
+    
+    // A creator that died before finishing the header leaves memory that times out rather than hanging.
+    size_t MapSize = sizeof(shared_arena_header) + Megabytes(1);
+    void *Unfinished = mem_MapSharedOsMemory(Name, MapSize);
+    TestCheck(Unfinished);
+    StartMs = mem_GetOsMilliseconds();
+    shared_arena TimedOut = mem_OpenSharedArena(Name, Megabytes(1), 20);
+    u64 WaitedMs = mem_GetOsMilliseconds() - StartMs;
+    TestCheck(!TimedOut.Start);
+    TestCheck(WaitedMs >= 20 && WaitedMs < 1000);
+    mem_UnmapSharedOsMemory(Unfinished, MapSize);
+    mem_RemoveSharedOsMemory(Name);
+    
+    // So does one that died before it even set the size.
+    s32 Unsized = shm_open(Name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    TestCheck(Unsized >= 0);
+    close(Unsized);
+    StartMs = mem_GetOsMilliseconds();
+    TimedOut = mem_OpenSharedArena(Name, Megabytes(1), 20);
+    WaitedMs = mem_GetOsMilliseconds() - StartMs;
+    TestCheck(!TimedOut.Start);
+    TestCheck(WaitedMs >= 20 && WaitedMs < 1000);
+    mem_RemoveSharedOsMemory(Name);
+}
+
+void
+TestRing()
+{
+    memory_ring Ring;
+    TestCheck(mem_CreateRing(&Ring, 1000));
+    TestCheck(Ring.Size == MEM_COMMIT_GRANULARITY);
+    
+    // Both mappings are the same memory.
+    Ring.Start[5] = 42;
+    TestCheck(Ring.Start[Ring.Size + 5] == 42);
+    
+    size_t Available = 1;
+    mem_BeginRingRead(&Ring, &Available);
+    TestCheck(Available == 0);
+    TestCheck(!mem_BeginRingWrite(&Ring, Ring.Size + 1));
+    
+    // A writer thread sends length-prefixed records that often wrap the end, and the reader checks them in place.
+    const u32 RecordCount = 100000;
+    std::thread Writer([&Ring, RecordCount]()
+                       {
+                           for(u32 Record = 0; Record < RecordCount; ++Record)
+                           {
+                               u32 Length = 4 + (Record*7919) % 1000;
+                               u8 *At;
+                               while(!(At = (u8*)mem_BeginRingWrite(&Ring, Length)))
+                               {
+                                   std::this_thread::yield();
+                               }
+                               memcpy(At, &Length, 4);
+                               memset(At + 4, (u8)Record, Length - 4);
+                               mem_EndRingWrite(&Ring, Length);
+                           }
+                       });
+    
+    u32 RecordsRead = 0;
+    b8 isIntact = true;
+    while(RecordsRead < RecordCount)
+    {
+        u8 *Data = (u8*)mem_BeginRingRead(&Ring, &Available);
+        size_t Parsed = 0;
+        while(Available - Parsed >= 4)
+        {
+            u32 Length;
+            memcpy(&Length, Data + Parsed, 4);
+            if(Available - Parsed < Length)
+            {
+                break;
+            }
+            isIntact = isIntact && Length == 4 + (RecordsRead*7919) % 1000;
+            isIntact = isIntact && (Length == 4 || Data[Parsed + Length - 1] == (u8)RecordsRead);
+            Parsed += Length;
+            ++RecordsRead;
+        }
+        mem_EndRingRead(&Ring, Parsed);
+    }
+    Writer.join();
+    TestCheck(isIntact);
+    
+    mem_ReleaseRing(&Ring);
+    TestCheck(!Ring.Start);
+    
+    // A released ring has nothing to read or write, rather than dividing by its size of 0.
+    size_t Left = 1;
+    TestCheck(!mem_BeginRingRead(&Ring, &Left));
+    TestCheck(Left == 0);
+    TestCheck(!mem_BeginRingWrite(&Ring, 0));
+}
+
+struct frame_results
+{
+    u64 Frame;
+    u32 Count;
+    u32 *Values;
+};
+
+void
+TestFrameArenas()
+{
+    const size_t Size = Megabytes(1);
+    void *OsMemory = mem_AllocateOsMemory(NULL, Size);
+    memory_frame_arenas Frames;
+    mem_InitFrameArenas(&Frames, OsMemory, Size, true);
+    TestCheck(!mem_BeginFrameRead(&Frames));
+    
+    // Memory from the last frame is still there, and the frame before that is reset.
+    frame_results *Last = 0;
+    b8 isIntact = true;
+    for(u64 Frame = 1; Frame <= 10; ++Frame)
+    {
+        memory_arena *Memory = mem_BeginFrame(&Frames);
+        TestCheck(Memory == mem_GetCurrentFrame(&Frames));
+        TestCheck(Memory->Used == 0);
+        
+        frame_results *Results = mem_PushStruct(Memory, frame_results);
+        Results->Frame = Frame;
+        if(Last)
+        {
+            isIntact = isIntact && Last->Frame == Frame - 1;
+            isIntact = isIntact && mem_GetPreviousFrame(&Frames)->Start <= (void*)Last;
+        }
+        Last = Results;
+    }
+    TestCheck(isIntact);
+    
+    // A consumer reads whole frames while the producer keeps going.
+    const u64 FrameCount = 20000;
+    std::atomic<b8> isDone(false);
+    b8 isConsistent = true;
+    u64 ReadCount = 0;
+    std::atomic<u64> LastRead(0);
+    std::thread Consumer([&]()
+                         {
+                             while(!isDone.load())
+                             {
+                                 u64 Frame = 0;
+                                 frame_results *Results = (frame_results*)mem_BeginFrameRead(&Frames, &Frame);
+                                 if(Results)
+                                 {
+                                     isConsistent = isConsistent && Results->Frame == Frame && Frame >= LastRead;
+                                     for(u32 Index = 0; Index < Results->Count; ++Index)
+                                     {
+                                         isConsistent = isConsistent && Results->Values[Index] == (u32)Frame;
+                                     }
+                                     mem_EndFrameRead(&Frames);
+                                     LastRead.store(Frame);
+                                     ++ReadCount;
+                                 }
+                             }
+                         });
+    
+    for(u64 Frame = 11; Frame <= FrameCount; ++Frame)
+    {
+        memory_arena *Memory = mem_BeginFrame(&Frames);
+        frame_results *Results = mem_PushStruct(Memory, frame_results);
+        Results->Frame = Frame;
+        Results->Count = 64 + (u32)(Frame % 64);
+        Results->Values = mem_PushArray(Memory, Results->Count, u32);
+        for(u32 Index = 0; Index < Results->Count; ++Index)
+        {
+            Results->Values[Index] = (u32)Frame;
+        }
+        mem_PublishFrame(&Frames, Results);
+        
+        if((Frame % 256) == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    
+    // The consumer always picks up the latest frame.
+    while(LastRead.load() != FrameCount)
+    {
+        std::this_thread::yield();
+    }
+    isDone.store(true);
+    Consumer.join();
+    
+    TestCheck(isConsistent);
+    TestCheck(ReadCount > 0);
+    
+    // A producer that skips publishing leaves nothing to read, rather than making the consumer wait.
+    memory_frame_arenas Skipped;
+    mem_InitFrameArenas(&Skipped, OsMemory, Size, false);
+    mem_BeginFrame(&Skipped);
+    mem_PublishFrame(&Skipped, &Skipped);
+    TestCheck(mem_BeginFrameRead(&Skipped) == &Skipped);
+    mem_EndFrameRead(&Skipped);
+    mem_BeginFrame(&Skipped);
+    mem_BeginFrame(&Skipped);
+    TestCheck(!mem_BeginFrameRead(&Skipped));
+    TestCheck(Skipped.ReadFrame.load() == 0);
+    
+    mem_DeallocateOsMemory(OsMemory, Size);
+}
+
+void
+FillCheckpointPages(memory_arena *Memory, size_t FirstPage, size_t PageCount, u32 Seed)
+{
+    for(size_t Page = FirstPage; Page < FirstPage + PageCount; ++Page)
+    {
+        u32 *Words = (u32*)((u8*)Memory->Start + Page*MEM_CHECKPOINT_PAGE_SIZE);
+        Words[Seed % 1024] = (u32)(Page*2654435761u) ^ Seed;
+    }
+}
+
+long
+GetFileSize(char const *Path)
+{
+    long Result = -1;
+    FILE *File = fopen(Path, "rb");
+    if(File)
+    {
+        fseek(File, 0, SEEK_END);
+        Result = ftell(File);
+        fclose(File);
+    }
+    
+    return Result;
+}
+
+void
+TestCheckpoints(b8 isHashing)
+{
+    char const *Path = "test_memory_checkpoint.ckpt";
+    remove(Path);
+    
+    memory_arena Memory = mem_InitReservedMemory(Megabytes(64));
+    mem_PushSize(&Memory, Megabytes(8));
+    FillCheckpointPages(&Memory, 0, 2048, 1);
+    
+    memory_checkpoint Checkpoint;
+    TestCheck(mem_OpenCheckpoints(&Checkpoint, &Memory, Path, 3, isHashing));
+    TestCheck(!isHashing || !Checkpoint.isSoftDirty);
+    
+    // The first checkpoint has every used page; after that only the changes.
+    size_t PageCount = 0;
+    TestCheck(mem_WriteCheckpoint(&Checkpoint, false, &PageCount));
+    TestCheck(PageCount == 2048);
+    
+    TestCheck(mem_WriteCheckpoint(&Checkpoint, false, &PageCount));
+    TestCheck(PageCount == 0);
+    
+    for(size_t Page = 3; Page < 2048; Page += 200)
+    {
+        FillCheckpointPages(&Memory, Page, 1, 2);
+    }
+    TestCheck(mem_WriteCheckpoint(&Checkpoint, false, &PageCount));
+    TestCheck(Checkpoint.isSoftDirty ? (PageCount >= 11) : (PageCount == 11));
+    
+    // New pages past the last checkpoint's Used are always saved.
+    mem_PushSize(&Memory, Megabytes(1));
+    FillCheckpointPages(&Memory, 100, 1, 3);
+    TestCheck(mem_WriteCheckpoint(&Checkpoint, false, &PageCount));
+    TestCheck(Checkpoint.isSoftDirty ? (PageCount >= 257) : (PageCount == 257));
+    size_t SavedUsed = Memory.Used;
+    long SavedSize = GetFileSize(Path);
+    
+    memory_arena Restored = mem_InitReservedMemory(Megabytes(64));
+    TestCheck(mem_RestoreCheckpoint(&Restored, Path, 3));
+    TestCheck(Restored.Used == Memory.Used);
+    TestCheck(memcmp(Restored.Start, Memory.Start, Memory.Used) == 0);
+    TestCheck(!mem_RestoreCheckpoint(&Restored, Path, 4));
+    
+    // A checkpoint cut off partway is skipped, restoring the one before.
+    FillCheckpointPages(&Memory, 0, 2304, 4);
+    mem_PushSize(&Memory, Kilobytes(4));
+    TestCheck(mem_WriteCheckpoint(&Checkpoint, false, &PageCount));
+    TestCheck(truncate(Path, GetFileSize(Path) - 100) == 0);
+    memory_arena Truncated = mem_InitReservedMemory(Megabytes(64));
+    TestCheck(mem_RestoreCheckpoint(&Truncated, Path, 3));
+    TestCheck(Truncated.Used == SavedUsed);
+    TestCheck(memcmp(Truncated.Start, Restored.Start, SavedUsed) == 0);
+    mem_ReleaseReservedMemory(&Truncated);
+    
+    // A full checkpoint replaces the file, dropping the history.
+    TestCheck(mem_WriteCheckpoint(&Checkpoint, true, &PageCount));
+    TestCheck(PageCount == 2305);
+    TestCheck(GetFileSize(Path) < SavedSize);
+    mem_ResetMemory(&Restored);
+    TestCheck(mem_RestoreCheckpoint(&Restored, Path, 3));
+    TestCheck(Restored.Used == Memory.Used);
+    TestCheck(memcmp(Restored.Start, Memory.Start, Memory.Used) == 0);
+    
+    // Pages handed back to the OS read as 0 when pushed again, without being written, and are still saved.
+    mem_ResetMemory(&Memory, true);
+    mem_PushSize(&Memory, Megabytes(2));
+    TestCheck(mem_WriteCheckpoint(&Checkpoint));
+    memory_arena Decommitted = mem_InitReservedMemory(Megabytes(64));
+    TestCheck(mem_RestoreCheckpoint(&Decommitted, Path, 3));
+    TestCheck(Decommitted.Used == Memory.Used);
+    TestCheck(memcmp(Decommitted.Start, Memory.Start, Memory.Used) == 0);
+    mem_ReleaseReservedMemory(&Decommitted);
+    
+    mem_CloseCheckpoints(&Checkpoint);
+    mem_ReleaseReservedMemory(&Restored);
+    mem_ReleaseReservedMemory(&Memory);
+    remove(Path);
+}
+
+#if MEM_INSTRUMENT
+void
+TestInstrument()
+{
+    mem_ClearMemoryReport();
+    void *OsMemory = mem_AllocateOsMemory(NULL, Kilobytes(4));
+    memory_arena Memory = mem_InitGrowableMemory(OsMemory, Kilobytes(4), Kilobytes(4));
+    mem_SetArenaName(&Memory, "Growable \"test\"");
+    
+    // The peak counts every block of a growable arena, and is kept across resets.
+    u32 LoopLine = 0;
+    for(u32 Frame = 0; Frame < 3; ++Frame)
+    {
+        for(u32 Push = 0; Push < 10; ++Push)
+        {
+            LoopLine = __LINE__ + 1;
+            mem_PushSize(&Memory, Kilobytes(1) * (Frame + 1));
+        }
+        
+        temporary_memory TempMem = mem_BeginTemporaryMemory(&Memory);
+        mem_PushSize(&Memory, 100);
+        mem_PushSize(&Memory, 200);
+        mem_EndTemporaryMemory(TempMem);
+        
+        // Only the last push can be given back.
+        void *First = mem_PushSize(&Memory, 64);
+        void *Last = mem_PushSize(&Memory, 32);
+        TestCheck(!mem_PopSize(&Memory, First, 64));
+        TestCheck(mem_PopSize(&Memory, Last, 32));
+        mem_ResetMemory(&Memory);
+    }
+    
+    memory_arena_stats *Stats = 0;
+    for(u32 Index = 0; Index < MEM_INSTRUMENT_ARENA_COUNT; ++Index)
+    {
+        if(mem_ArenaStats_[Index].Arena == &Memory)
+        {
+            Stats = &mem_ArenaStats_[Index];
+        }
+    }
+    TestCheck(Stats);
+    if(Stats)
+    {
+        TestCheck(Stats->PushCount == 42);
+        TestCheck(Stats->ResetCount == 3);
+        TestCheck(Stats->PeakUsed >= Kilobytes(30) + 300 && Stats->PeakUsed < Kilobytes(34));
+        TestCheck(Stats->TemporaryCount == 3);
+        TestCheck(Stats->TemporaryMaxSize == 300);
+        TestCheck(Stats->TemporaryTotalSize == 900);
+        TestCheck(Stats->PopCount == 3);
+        TestCheck(Stats->PopTotalSize == 96);
+    }
+    
+    // Every push from the loop above is one site.
+    b8 isSiteFound = false;
+    for(u32 Index = 0; Index < MEM_INSTRUMENT_SITE_COUNT; ++Index)
+    {
+        memory_site_stats *Site = &mem_SiteStats_[Index];
+        if(Site->File && Site->Line == LoopLine && strstr(Site->File, "test_memory.cpp"))
+        {
+            isSiteFound = Site->PushCount == 30 && Site->TotalSize == Kilobytes(60) && Site->MaxSize == Kilobytes(3);
+        }
+    }
+    TestCheck(isSiteFound);
+    
+    char Report[16384] = {};
+    FILE *Out = fmemopen(Report, sizeof(Report) - 1, "w");
+    mem_WriteMemoryReportJson(Out);
+    fclose(Out);
+    TestCheck(strstr(Report, "\"name\": \"Growable \\\"test\\\"\""));
+    TestCheck(strstr(Report, "\"resets\": 3"));
+    
+    Out = fmemopen(Report, sizeof(Report) - 1, "w");
+    mem_PrintMemoryReport(Out, 5);
+    fclose(Out);
+    TestCheck(strstr(Report, "test_memory.cpp"));
+    TestCheck(!strstr(Report, "dropped"));
+    
+    // More sites than the table holds are counted, and the report says so.
+    for(u32 Line = 1; Line <= MEM_INSTRUMENT_SITE_COUNT + 10; ++Line)
+    {
+        mem_RecordPush_(&Memory, 1, "dropped.cpp", Line);
+    }
+    TestCheck(mem_DroppedSiteCount_ >= 10);
+    
+    Out = fmemopen(Report, sizeof(Report) - 1, "w");
+    mem_PrintMemoryReport(Out, 5);
+    fclose(Out);
+    TestCheck(strstr(Report, "site records were dropped"));
+    
+    mem_ClearMemoryReport();
+    TestCheck(mem_DroppedSiteCount_ == 0);
+    
+    mem_DeallocateOsMemory(OsMemory, Kilobytes(4));
+}
+#endif
+
+int
+main(int argc, char *argv[])
+{
+    TestFixedArena();
+    TestGrowableArena();
+    TestReservedArena();
+    TestClearMemory();
+    TestAlignedPush();
+    TestHugePages();
+    TestPrefault();
+    TestNumaArenas();
+    TestScratch();
+    TestConcurrentArena();
+    TestPool();
+    TestVirtualArray();
+    TestFileMemory();
+    TestSharedArena();
+    TestRing();
+    TestFrameArenas();
+    TestCheckpoints(false);
+    TestCheckpoints(true);
+#if MEM_INSTRUMENT
+    TestInstrument();
+#endif
+    mem_ReleaseThreadScratch();
+    
+    if(FailCount)
+    {
+        printf("%d memory tests failed.\n", FailCount);
+        return 1;
+    }
+    
+    printf("All memory tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,121 @@
+/** @file
+    @brief Tests for ab_memory_pmr.h.
+    @author Amos Buchanan
+    @version 1.0
+    @date October 2026
+    @copyright MIT Public License.
+
+**/
+
+#include <stdio.h>
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+// NOTE(amos): build_test.sh also builds this with TEST_SEPARATE_MEMORY_SRC, taking the ab_memory.h source from
+// test_memory_src.cpp, to check the pmr source links against ab_memory.h built in another file.
+#ifndef TEST_SEPARATE_MEMORY_SRC
+#define MEMORY_SRC
+#endif
+#include "ab_memory.h"
+
+#define AB_MEMORY_PMR_SRC
+#include "ab_memory_pmr.h"
+
+#include "test_common.h"
+
+void
+TestArenaResource(memory_arena *Memory)
+{
+    arena_memory_resource Resource(Memory);
+    u8 *Start = (u8*)Memory->Start;
+    
+    std::pmr::vector<u32> Values(&Resource);
+    for(u32 Index = 0; Index < 1000; ++Index)
+    {
+        Values.push_back(Index);
+    }
+    TestCheck(Values[999] == 999);
+    TestCheck((u8*)Values.data() >= Start && (u8*)Values.data() < Start + Memory->Size);
+    
+    // Freeing the most recent allocation gives it back to the arena.
+    u8 *Last = (u8*)Resource.allocate(500);
+    Resource.deallocate(Last, 500);
+    TestCheck(Memory->Used == (size_t)(Last - Start));
+    
+    std::pmr::string Text("A string long enough to not fit in the small string buffer.", &Resource);
+    TestCheck((u8*)Text.data() >= Start && (u8*)Text.data() < Start + Memory->Size);
+    
+    std::pmr::unordered_map<u32, std::pmr::string> Names(&Resource);
+    Names[1] = "One";
+    Names[2] = "Two, which is also long enough to need its own memory.";
+    TestCheck(Names[2].get_allocator().resource() == &Resource);
+    TestCheck(Names.size() == 2);
+    
+    void *Aligned = Resource.allocate(100, 64);
+    TestCheck(((size_t)Aligned % 64) == 0);
+}
+
+void
+TestTemporaryResource(memory_arena *Memory)
+{
+    size_t Used = Memory->Used;
+    {
+        temporary_memory_resource Scratch(Memory);
+        std::pmr::vector<std::pmr::string> Lines(&Scratch);
+        for(u32 Index = 0; Index < 100; ++Index)
+        {
+            Lines.emplace_back("This is one of the many lines in the temporary vector.");
+        }
+        TestCheck(Lines.size() == 100);
+        TestCheck(Memory->Used > Used);
+    }
+    TestCheck(Memory->Used == Used);
+}
+
+void
+TestUpstream()
+{
+    u8 Buffer[256];
+    memory_arena Small = mem_InitMemory(Buffer, sizeof(Buffer));
+    
+    arena_memory_resource Strict(&Small);
+    b8 isThrown = false;
+    try
+    {
+        Strict.allocate(1024);
+    }
+    catch(std::bad_alloc const &)
+    {
+        isThrown = true;
+    }
+    TestCheck(isThrown);
+    
+    arena_memory_resource Fallback(&Small, std::pmr::new_delete_resource());
+    void *FromHeap = Fallback.allocate(1024);
+    TestCheck(FromHeap && ((u8*)FromHeap < Buffer || (u8*)FromHeap >= Buffer + sizeof(Buffer)));
+    Fallback.deallocate(FromHeap, 1024);
+    TestCheck(Small.Used == 0);
+}
+
+int
+main(int argc, char *argv[])
+{
+    void *OsMemory = mem_AllocateOsMemory(NULL, Megabytes(1));
+    memory_arena Memory = mem_InitMemory(OsMemory, Megabytes(1), true);
+    
+    TestArenaResource(&Memory);
+    TestTemporaryResource(&Memory);
+    TestUpstream();
+    
+    mem_DeallocateOsMemory(OsMemory, Megabytes(1));
+    
+    if(FailCount)
+    {
+        printf("%d pmr tests failed.\n", FailCount);
+        return 1;
+    }
+    
+    printf("All pmr tests passed.\n");
+    return 0;
+}
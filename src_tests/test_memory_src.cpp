@@ -0,0 +1,13 @@
+/** @file
+    @brief The ab_memory.h source on its own.
+    @author Amos Buchanan
+    @version 1.0
+    @date October 2026
+    @copyright MIT Public License.
+
+Linked with tests built with `TEST_SEPARATE_MEMORY_SRC`, to check that libraries built on ab_memory.h link when its source is in a different file.
+
+**/
+
+#define MEMORY_SRC
+#include "ab_memory.h"
@@ -0,0 +1,161 @@
+/** @file
+    @brief Tests for ab_relptr.h.
+    @author Amos Buchanan
+    @version 1.0
+    @date October 2026
+    @copyright MIT Public License.
+
+**/
+
+#include <stdio.h>
+#include <string.h>
+
+#define MEMORY_SRC
+#include "ab_memory.h"
+
+#include "ab_relptr.h"
+
+#include "test_common.h"
+
+struct list_node
+{
+    u32 Value;
+    rel_ptr<list_node> Next;
+    rel_array<u16> Samples;
+};
+
+list_node *
+BuildList(memory_arena *Memory, u32 NodeCount)
+{
+    list_node *Head = 0;
+    for(u32 Index = 0; Index < NodeCount; ++Index)
+    {
+        list_node *Node = mem_PushStructAligned(Memory, list_node, alignof(list_node));
+        Node->Value = NodeCount - Index - 1;
+        Node->Next = Head;
+        u16 *Samples = rp_PushArray(Memory, &Node->Samples, Node->Value % 5);
+        for(u32 Sample = 0; Sample < Node->Samples.Count; ++Sample)
+        {
+            Samples[Sample] = (u16)(Node->Value + Sample);
+        }
+        Head = Node;
+    }
+    
+    return Head;
+}
+
+b8
+IsListIntact(list_node *Head, u32 NodeCount)
+{
+    b8 Result = true;
+    u32 Expected = 0;
+    for(list_node *Node = Head; Node; Node = Node->Next)
+    {
+        Result = Result && Node->Value == Expected && Node->Samples.Count == Expected % 5;
+        
+        u32 Sample = 0;
+        for(u16 Value : Node->Samples)
+        {
+            Result = Result && Value == (u16)(Expected + Sample);
+            ++Sample;
+        }
+        ++Expected;
+    }
+    
+    return Result && Expected == NodeCount;
+}
+
+void
+TestRelPtr()
+{
+    u32 Values[4] = {1, 2, 3, 4};
+    struct holder
+    {
+        rel_ptr<u32> Value;
+        rel_ptr<u32, s64> WideValue;
+    } Holder;
+    
+    TestCheck(!Holder.Value);
+    TestCheck(sizeof(Holder.Value) == 4 && sizeof(Holder.WideValue) == 8);
+    
+    Holder.Value = &Values[2];
+    Holder.WideValue = &Values[3];
+    TestCheck(*Holder.Value == 3 && *Holder.WideValue == 4);
+    TestCheck(Holder.Value[1] == 4);
+    
+    // Copying a single rel_ptr keeps the same target.
+    holder Copy = Holder;
+    TestCheck(Copy.Value.Get() == &Values[2]);
+    
+    Holder.Value = 0;
+    TestCheck(!Holder.Value.Get());
+    
+    // A target out of range for the offset is stored as null. Debug builds assert instead.
+#ifndef _DEBUG
+    u8 Bytes[512];
+    rel_ptr<u8, s8> *Narrow = (rel_ptr<u8, s8>*)Bytes;
+    TestCheck(Narrow->Set(Bytes + 100));
+    TestCheck(Narrow->Get() == Bytes + 100);
+    TestCheck(!Narrow->Set(Bytes + 300));
+    TestCheck(!Narrow->Get());
+#endif
+}
+
+void
+TestRelocation()
+{
+    const u32 NodeCount = 1000;
+    memory_arena Memory = mem_InitReservedMemory(Megabytes(16));
+    list_node *Head = BuildList(&Memory, NodeCount);
+    TestCheck(IsListIntact(Head, NodeCount));
+    
+    // A memcpy of the whole arena works in the new place, with nothing pointing back at the old one.
+    memory_arena Copy = mem_InitReservedMemory(Megabytes(16));
+    u8 *CopyStart = (u8*)mem_PushSize_(&Copy, Memory.Used, false);
+    memcpy(CopyStart, Memory.Start, Memory.Used);
+    size_t HeadOffset = ((u8*)Head) - (u8*)Memory.Start;
+    mem_ReleaseReservedMemory(&Memory);
+    
+    TestCheck(IsListIntact((list_node*)(CopyStart + HeadOffset), NodeCount));
+    mem_ReleaseReservedMemory(&Copy);
+}
+
+void
+TestRelocatableFile()
+{
+    char const *Path = "test_relptr_file.arena";
+    remove(Path);
+    
+    b8 isRestored = true;
+    memory_arena Memory = mem_OpenFileMemory(Path, Megabytes(1), 1, &isRestored, true);
+    rel_ptr<list_node> *Root = mem_PushStruct(&Memory, rel_ptr<list_node>);
+    *Root = BuildList(&Memory, 100);
+    mem_SaveFileMemory(&Memory);
+    
+    // Map it again while the first mapping is still open, so it has to be at a different address.
+    memory_arena Reopened = mem_OpenFileMemory(Path, Megabytes(1), 1, &isRestored, true);
+    TestCheck(isRestored);
+    TestCheck(Reopened.Start != Memory.Start);
+    TestCheck(IsListIntact(*(rel_ptr<list_node>*)Reopened.Start, 100));
+    
+    mem_CloseFileMemory(&Reopened);
+    mem_CloseFileMemory(&Memory);
+    remove(Path);
+}
+
+int
+main(int argc, char *argv[])
+{
+    TestRelPtr();
+    TestRelocation();
+    TestRelocatableFile();
+    
+    if(FailCount)
+    {
+        printf("%d relative pointer tests failed.\n", FailCount);
+        return 1;
+    }
+    
+    printf("All relative pointer tests passed.\n");
+    return 0;
+}
@@ -0,0 +1,182 @@
+/** @file
+    @brief Tests for ab_slab.h.
+    @author Amos Buchanan
+    @version 1.0
+    @date October 2026
+    @copyright MIT Public License.
+
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MEMORY_SRC
+#include "ab_memory.h"
+
+#define AB_SLAB_SRC
+#include "ab_slab.h"
+
+#include "test_common.h"
+
+void
+TestClasses()
+{
+    TestCheck(sl_GetClassIndex(1) == 0);
+    TestCheck(sl_GetClassIndex(16) == 0);
+    TestCheck(sl_GetClassIndex(17) == 1);
+    TestCheck(sl_GetClassSize(sl_GetClassIndex(129)) == 160);
+    TestCheck(sl_GetClassSize(sl_GetClassIndex(1000)) == 1024);
+    TestCheck(sl_GetClassIndex(SL_MAX_SIZE) == SL_CLASS_COUNT - 1);
+    
+    b8 isFitted = true;
+    for(size_t Size = 1; Size <= SL_MAX_SIZE; ++Size)
+    {
+        u32 ClassSize = sl_GetClassSize(sl_GetClassIndex(Size));
+        isFitted = isFitted && ClassSize >= Size && (Size <= 16 || sl_GetClassSize(sl_GetClassIndex(Size) - 1) < Size);
+    }
+    TestCheck(isFitted);
+}
+
+void
+TestAllocFree(slab_allocator *Slabs)
+{
+    u8 *A = (u8*)sl_Alloc(Slabs, 24);
+    u8 *B = (u8*)sl_Alloc(Slabs, 24, true);
+    u8 *C = (u8*)sl_Alloc(Slabs, 700);
+    TestCheck(A && B && C);
+    TestCheck(((size_t)A % 16) == 0 && ((size_t)B % 16) == 0 && ((size_t)C % 16) == 0);
+    TestCheck(B - A == 32);
+    TestCheck(B[31] == 0);
+    TestCheck(!sl_Alloc(Slabs, 0));
+    TestCheck(!sl_Alloc(Slabs, SL_MAX_SIZE + 1));
+    
+    slab_stats Stats = sl_GetStats(Slabs);
+    TestCheck(Stats.Classes[1].UsedCount == 2);
+    TestCheck(Stats.Classes[1].SlabCount == 1);
+    TestCheck(Stats.Classes[1].Occupancy > 0.0f);
+    TestCheck(Stats.Classes[sl_GetClassIndex(700)].UsedCount == 1);
+    
+    // The lowest free slot is reused first.
+    sl_Free(Slabs, A);
+    TestCheck(sl_Alloc(Slabs, 20) == A);
+    
+    sl_Free(Slabs, A);
+    sl_Free(Slabs, B);
+    sl_Free(Slabs, C);
+    sl_Free(Slabs, 0);
+    
+    // The last slab of a class is kept, even when empty.
+    Stats = sl_GetStats(Slabs);
+    TestCheck(Stats.Classes[1].UsedCount == 0);
+    TestCheck(Stats.Classes[1].SlabCount == 1);
+    TestCheck(Stats.Classes[1].Occupancy == 0.0f);
+}
+
+void
+TestSlabReuse(slab_allocator *Slabs)
+{
+    // Fill several slabs of one class, free them, then check another class gets the same slabs.
+    const u32 Count = 10000;
+    static void *Objects[Count];
+    for(u32 Index = 0; Index < Count; ++Index)
+    {
+        Objects[Index] = sl_Alloc(Slabs, 48);
+        memset(Objects[Index], (u8)Index, 48);
+    }
+    
+    slab_stats Full = sl_GetStats(Slabs);
+    u32 FullSlabs = Full.Classes[2].SlabCount;
+    TestCheck(FullSlabs > 1);
+    TestCheck(Full.Classes[2].UsedCount == Count);
+    
+    b8 isIntact = true;
+    for(u32 Index = 0; Index < Count; ++Index)
+    {
+        isIntact = isIntact && ((u8*)Objects[Index])[47] == (u8)Index;
+        sl_Free(Slabs, Objects[Index]);
+    }
+    TestCheck(isIntact);
+    
+    slab_stats Emptied = sl_GetStats(Slabs);
+    TestCheck(Emptied.Classes[2].SlabCount == 1);
+    TestCheck(Emptied.EmptySlabCount == FullSlabs - 1);
+    
+    size_t ArenaUsed = Slabs->Arena->Used;
+    for(u32 Index = 0; Index < 1500; ++Index)
+    {
+        Objects[Index] = sl_Alloc(Slabs, 256);
+    }
+    TestCheck(Slabs->Arena->Used == ArenaUsed);
+    TestCheck(sl_GetStats(Slabs).Classes[sl_GetClassIndex(256)].SlabCount > 1);
+    TestCheck(sl_GetStats(Slabs).TotalSize == Full.TotalSize);
+    
+    for(u32 Index = 0; Index < 1500; ++Index)
+    {
+        sl_Free(Slabs, Objects[Index]);
+    }
+}
+
+void
+TestRandom(slab_allocator *Slabs)
+{
+    const u32 SlotCount = 2000;
+    static u8 *Slots[SlotCount];
+    static size_t Sizes[SlotCount];
+    srand(1234);
+    
+    for(u32 Step = 0; Step < 200000; ++Step)
+    {
+        u32 Slot = (u32)rand() % SlotCount;
+        if(Slots[Slot])
+        {
+            TestCheck(Slots[Slot][0] == (u8)Slot && Slots[Slot][Sizes[Slot] - 1] == (u8)Slot);
+            sl_Free(Slabs, Slots[Slot]);
+            Slots[Slot] = 0;
+        }
+        else
+        {
+            Sizes[Slot] = 1 + (rand() % SL_MAX_SIZE);
+            Slots[Slot] = (u8*)sl_Alloc(Slabs, Sizes[Slot]);
+            TestCheck(Slots[Slot]);
+            memset(Slots[Slot], (u8)Slot, Sizes[Slot]);
+        }
+    }
+    
+    for(u32 Slot = 0; Slot < SlotCount; ++Slot)
+    {
+        sl_Free(Slabs, Slots[Slot]);
+    }
+    
+    slab_stats Stats = sl_GetStats(Slabs);
+    b8 isEmpty = true;
+    for(u32 ClassIndex = 0; ClassIndex < SL_CLASS_COUNT; ++ClassIndex)
+    {
+        isEmpty = isEmpty && Stats.Classes[ClassIndex].UsedCount == 0 && Stats.Classes[ClassIndex].SlabCount <= 1;
+    }
+    TestCheck(isEmpty);
+}
+
+int
+main(int argc, char *argv[])
+{
+    memory_arena Memory = mem_InitReservedMemory(Gigabytes(1));
+    slab_allocator *Slabs = sl_CreateSlabAllocator(&Memory);
+    TestCheck(Slabs);
+    
+    TestClasses();
+    TestAllocFree(Slabs);
+    TestSlabReuse(Slabs);
+    TestRandom(Slabs);
+    
+    mem_ReleaseReservedMemory(&Memory);
+    
+    if(FailCount)
+    {
+        printf("%d slab tests failed.\n", FailCount);
+        return 1;
+    }
+    
+    printf("All slab tests passed.\n");
+    return 0;
+}